@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Single-machine collectives over POSIX shared memory. Every rank opens the same 'name';
+// rank 0 creates the segment (replacing one left by a crashed run), admits every other rank
+// through a per-attach token, and unlinks it once all ranks are attached. All-reduce is a
+// ring (reduce-scatter, then all-gather) through one single-slot mailbox per rank holding
+// 'chunk_elems' doubles; longer buffers are processed in segments of world * chunk_elems.
+class ShmCommunicator
+{
+public:
+    ShmCommunicator(const std::string &name, int rank, int world_size,
+                    int64_t chunk_elems = 1 << 16, double timeout_s = 120.0);
+    ~ShmCommunicator();
+    ShmCommunicator(const ShmCommunicator &) = delete;
+    ShmCommunicator &operator=(const ShmCommunicator &) = delete;
+
+    int rank() const { return rank_; }
+    int world_size() const { return world_; }
+
+    void allreduce_sum(double *buf, int64_t n);
+    void broadcast(double *buf, int64_t n, int root = 0);
+    void barrier();
+
+private:
+    void send(const double *src, int64_t n);   // into this rank's mailbox
+    void recv_add(double *dst, int64_t n);     // from the previous rank's mailbox
+    void recv_copy(double *dst, int64_t n);
+    template <class F>
+    void recv(F &&consume);
+
+    void create(); // rank 0
+    void attach(); // other ranks
+    void map(int fd);
+
+    std::string name_;
+    int rank_, world_;
+    int64_t chunk_;
+    double timeout_s_;
+    void *base_ = nullptr;
+    size_t bytes_ = 0;
+};
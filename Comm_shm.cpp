@@ -0,0 +1,327 @@
+#include "Comm.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <random>
+#include <stdexcept>
+
+#if defined(_WIN32)
+
+ShmCommunicator::ShmCommunicator(const std::string &, int, int, int64_t, double)
+{
+    throw std::runtime_error("ShmCommunicator: POSIX shared memory is not available on this platform");
+}
+ShmCommunicator::~ShmCommunicator() = default;
+void ShmCommunicator::allreduce_sum(double *, int64_t) {}
+void ShmCommunicator::broadcast(double *, int64_t, int) {}
+void ShmCommunicator::barrier() {}
+
+#else
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "cross-process atomics need lock-free uint64");
+
+constexpr uint64_t kMagic = 0x454c48414d53484dULL; // "ELHAMSHM"
+
+struct alignas(64) Header
+{
+    std::atomic<uint64_t> magic;
+    int64_t world, chunk;
+    std::atomic<uint64_t> arrived, generation; // barrier
+};
+
+// Single-slot mailbox: the owner writes when consumed == posted, the next rank reads when
+// posted > consumed. Both counters only grow.
+struct alignas(64) Mailbox
+{
+    std::atomic<uint64_t> posted;
+    std::atomic<uint64_t> join, ack; // start-up handshake: the rank's token, echoed by rank 0
+    alignas(64) std::atomic<uint64_t> consumed;
+};
+
+size_t segment_bytes(int world, int64_t chunk)
+{
+    return sizeof(Header) + sizeof(Mailbox) * size_t(world) + sizeof(double) * size_t(world) * size_t(chunk);
+}
+
+Header *header(void *base) { return static_cast<Header *>(base); }
+Mailbox *mailbox(void *base, int r) { return reinterpret_cast<Mailbox *>(static_cast<char *>(base) + sizeof(Header)) + r; }
+double *slot(void *base, int world, int64_t chunk, int r)
+{
+    char *data = static_cast<char *>(base) + sizeof(Header) + sizeof(Mailbox) * size_t(world);
+    return reinterpret_cast<double *>(data) + size_t(r) * size_t(chunk);
+}
+
+// Inode the name refers to now, 0 when there is none.
+ino_t inode_of(const std::string &name)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        return 0;
+    struct stat st{};
+    const bool ok = fstat(fd, &st) == 0;
+    close(fd);
+    return ok ? st.st_ino : 0;
+}
+
+// Nonzero, and different for every attach of every run.
+uint64_t join_token()
+{
+    static std::atomic<uint64_t> attaches{0};
+    std::random_device rd;
+    const uint64_t t = (uint64_t(rd()) << 32 | rd()) ^ uint64_t(getpid()) ^ (attaches++ << 48);
+    return t ? t : 1;
+}
+
+// Spin, then yield; give up after 'timeout_s' (a peer probably died).
+template <class Pred>
+void wait_until(Pred ready, double timeout_s, const char *what)
+{
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::duration<double>(timeout_s);
+    for (uint64_t spin = 0; !ready(); ++spin)
+    {
+        if (spin < 256)
+            continue;
+        sched_yield();
+        if ((spin & 1023) == 0 && clock::now() > deadline)
+            throw std::runtime_error(std::string("ShmCommunicator: timed out waiting for ") + what);
+    }
+}
+} // namespace
+
+ShmCommunicator::ShmCommunicator(const std::string &name, int rank, int world_size,
+                                 int64_t chunk_elems, double timeout_s)
+    : name_(name.empty() || name[0] != '/' ? "/" + name : name),
+      rank_(rank), world_(world_size), chunk_(chunk_elems), timeout_s_(timeout_s)
+{
+    if (world_ <= 0 || rank_ < 0 || rank_ >= world_)
+        throw std::runtime_error("ShmCommunicator: need 0 <= rank < world_size");
+    if (chunk_ <= 0)
+        throw std::runtime_error("ShmCommunicator: chunk_elems must be positive");
+    bytes_ = segment_bytes(world_, chunk_);
+
+    if (rank_ == 0)
+        create();
+    else
+        attach();
+    barrier();
+    if (rank_ == 0)
+        shm_unlink(name_.c_str()); // everyone is mapped; the name is no longer needed
+}
+
+// A segment left under the name by a crashed run may still look initialized to a rank that
+// opens it first. Rank 0 clears its magic before replacing it, and admits each rank by echoing
+// the token the rank wrote into the new segment, so no rank proceeds on a stale one.
+void ShmCommunicator::create()
+{
+    int fd = shm_open(name_.c_str(), O_RDWR, 0600);
+    if (fd >= 0)
+    {
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && size_t(st.st_size) >= sizeof(Header))
+        {
+            void *old = mmap(nullptr, sizeof(Header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (old != MAP_FAILED)
+            {
+                header(old)->magic.store(0, std::memory_order_release);
+                munmap(old, sizeof(Header));
+            }
+        }
+        close(fd);
+        shm_unlink(name_.c_str());
+    }
+    fd = shm_open(name_.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0 || ftruncate(fd, off_t(bytes_)) != 0)
+    {
+        if (fd >= 0)
+            close(fd);
+        throw std::runtime_error("ShmCommunicator: cannot create " + name_);
+    }
+    map(fd);
+
+    Header *h = header(base_);
+    new (&h->arrived) std::atomic<uint64_t>(0);
+    new (&h->generation) std::atomic<uint64_t>(0);
+    h->world = world_;
+    h->chunk = chunk_;
+    for (int r = 0; r < world_; ++r)
+    {
+        Mailbox *mb = mailbox(base_, r);
+        new (&mb->posted) std::atomic<uint64_t>(0);
+        new (&mb->join) std::atomic<uint64_t>(0);
+        new (&mb->ack) std::atomic<uint64_t>(0);
+        new (&mb->consumed) std::atomic<uint64_t>(0);
+    }
+    new (&h->magic) std::atomic<uint64_t>(0);
+    h->magic.store(kMagic, std::memory_order_release);
+
+    for (int r = 1; r < world_; ++r)
+    {
+        Mailbox *mb = mailbox(base_, r);
+        wait_until([&]
+                   { return mb->join.load(std::memory_order_acquire) != 0; }, timeout_s_, "ranks to attach");
+        mb->ack.store(mb->join.load(std::memory_order_relaxed), std::memory_order_release);
+    }
+}
+
+// Attach, wait for the magic, post a token and wait for rank 0 to echo it. While waiting,
+// check now and then that the name still refers to the mapped segment; if rank 0 has replaced
+// it, attach again.
+void ShmCommunicator::attach()
+{
+    for (;;)
+    {
+        int fd = -1;
+        struct stat st{};
+        wait_until([&]
+                   {
+            fd = shm_open(name_.c_str(), O_RDWR, 0600);
+            if (fd >= 0 && fstat(fd, &st) == 0 && size_t(st.st_size) >= bytes_)
+                return true;
+            if (fd >= 0)
+                close(fd);
+            return false; }, timeout_s_, "rank 0 to create the segment");
+        map(fd);
+
+        Header *h = header(base_);
+        Mailbox *mb = mailbox(base_, rank_);
+        uint64_t polls = 0;
+        bool stale = false;
+        auto replaced = [&]
+        { return stale = (++polls & 1023) == 0 && inode_of(name_) != st.st_ino; };
+        wait_until([&]
+                   { return h->magic.load(std::memory_order_acquire) == kMagic || replaced(); }, timeout_s_, "segment initialization");
+        if (!stale)
+        {
+            const uint64_t token = join_token();
+            mb->join.store(token, std::memory_order_release);
+            wait_until([&]
+                       { return mb->ack.load(std::memory_order_acquire) == token || replaced(); }, timeout_s_, "rank 0 to admit this rank");
+        }
+        if (!stale)
+            break;
+        munmap(base_, bytes_);
+        base_ = nullptr;
+    }
+    const Header *h = header(base_);
+    if (h->world != world_ || h->chunk != chunk_)
+        throw std::runtime_error("ShmCommunicator: world_size/chunk_elems differ between ranks");
+}
+
+void ShmCommunicator::map(int fd)
+{
+    base_ = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base_ == MAP_FAILED)
+    {
+        base_ = nullptr;
+        throw std::runtime_error("ShmCommunicator: mmap failed for " + name_);
+    }
+}
+
+ShmCommunicator::~ShmCommunicator()
+{
+    if (base_)
+        munmap(base_, bytes_);
+}
+
+void ShmCommunicator::barrier()
+{
+    Header *h = header(base_);
+    const uint64_t gen = h->generation.load(std::memory_order_acquire);
+    if (h->arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == uint64_t(world_))
+    {
+        h->arrived.store(0, std::memory_order_relaxed);
+        h->generation.fetch_add(1, std::memory_order_acq_rel);
+        return;
+    }
+    wait_until([&]
+               { return h->generation.load(std::memory_order_acquire) != gen; }, timeout_s_, "barrier");
+}
+
+void ShmCommunicator::send(const double *src, int64_t n)
+{
+    Mailbox *mb = mailbox(base_, rank_);
+    const uint64_t posted = mb->posted.load(std::memory_order_relaxed);
+    wait_until([&]
+               { return mb->consumed.load(std::memory_order_acquire) == posted; }, timeout_s_, "next rank to drain");
+    std::copy(src, src + n, slot(base_, world_, chunk_, rank_));
+    mb->posted.store(posted + 1, std::memory_order_release);
+}
+
+template <class F>
+void ShmCommunicator::recv(F &&consume)
+{
+    const int prev = (rank_ + world_ - 1) % world_;
+    Mailbox *mb = mailbox(base_, prev);
+    const uint64_t consumed = mb->consumed.load(std::memory_order_relaxed);
+    wait_until([&]
+               { return mb->posted.load(std::memory_order_acquire) > consumed; }, timeout_s_, "previous rank");
+    consume(slot(base_, world_, chunk_, prev));
+    mb->consumed.store(consumed + 1, std::memory_order_release);
+}
+
+void ShmCommunicator::recv_add(double *dst, int64_t n)
+{
+    recv([&](const double *src)
+         {
+        for (int64_t i = 0; i < n; ++i)
+            dst[i] += src[i]; });
+}
+
+void ShmCommunicator::recv_copy(double *dst, int64_t n)
+{
+    recv([&](const double *src)
+         { std::copy(src, src + n, dst); });
+}
+
+void ShmCommunicator::allreduce_sum(double *buf, int64_t n)
+{
+    const int N = world_, r = rank_;
+    if (N == 1)
+        return;
+    auto mod = [N](int64_t v)
+    { return int((v % N + N) % N); };
+    for (int64_t off = 0; off < n; off += chunk_ * N)
+    {
+        const int64_t seg = std::min<int64_t>(chunk_ * N, n - off);
+        const int64_t cs = (seg + N - 1) / N;
+        auto lo = [&](int c)
+        { return off + std::min<int64_t>(seg, int64_t(c) * cs); };
+        auto len = [&](int c)
+        { return lo(c + 1) - lo(c); };
+
+        // reduce-scatter: after N-1 steps rank r holds the full sum of chunk r+1
+        for (int s = 0; s < N - 1; ++s)
+        {
+            const int sc = mod(r - s), rc = mod(r - s - 1);
+            send(buf + lo(sc), len(sc));
+            recv_add(buf + lo(rc), len(rc));
+        }
+        // all-gather: circulate the reduced chunks
+        for (int s = 0; s < N - 1; ++s)
+        {
+            const int sc = mod(r + 1 - s), rc = mod(r - s);
+            send(buf + lo(sc), len(sc));
+            recv_copy(buf + lo(rc), len(rc));
+        }
+    }
+}
+
+void ShmCommunicator::broadcast(double *buf, int64_t n, int root)
+{
+    if (rank_ != root)
+        std::fill(buf, buf + n, 0.0);
+    allreduce_sum(buf, n);
+}
+
+#endif
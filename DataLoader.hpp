@@ -0,0 +1,438 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "Tensor.hpp"
+
+// ---------- sources: a table of 'rows' samples with 'cols' values each ----------
+class DataSource
+{
+public:
+    // Sequential reader over one source; every loader worker opens its own.
+    class Reader
+    {
+    public:
+        virtual ~Reader() = default;
+        virtual void read_row(int64_t row, double *out) = 0; // cols() values
+    };
+
+    virtual ~DataSource() = default;
+    virtual int64_t rows() const = 0;
+    virtual int64_t cols() const = 0;
+    virtual std::unique_ptr<Reader> reader() const = 0;
+};
+
+// Headerless row-major float64 or float32 records (e.g. numpy's ndarray.tofile), optionally
+// after 'offset' bytes of preamble. Rows are read in place, so shuffling needs no index.
+class BinarySource : public DataSource
+{
+public:
+    BinarySource(std::string path, int64_t cols, bool float32 = false, int64_t offset = 0)
+        : path_(std::move(path)), cols_(cols), elem_(float32 ? 4 : 8), offset_(offset)
+    {
+        if (cols_ <= 0 || offset_ < 0)
+            throw std::runtime_error("BinarySource: cols must be positive and offset non-negative");
+        std::ifstream f(path_, std::ios::binary | std::ios::ate);
+        if (!f)
+            throw std::runtime_error("BinarySource: cannot open " + path_);
+        const int64_t bytes = static_cast<int64_t>(f.tellg()) - offset_;
+        const int64_t row_bytes = cols_ * elem_;
+        if (bytes < 0 || bytes % row_bytes != 0)
+            throw std::runtime_error("BinarySource: " + path_ + " is not a whole number of " +
+                                     std::to_string(cols_) + "-value rows");
+        rows_ = bytes / row_bytes;
+    }
+
+    int64_t rows() const override { return rows_; }
+    int64_t cols() const override { return cols_; }
+
+    std::unique_ptr<Reader> reader() const override
+    {
+        class R : public Reader
+        {
+        public:
+            explicit R(const BinarySource &s) : src(s), f(s.path_, std::ios::binary), raw(static_cast<size_t>(s.cols_ * s.elem_))
+            {
+                if (!f)
+                    throw std::runtime_error("BinarySource: cannot open " + s.path_);
+            }
+            void read_row(int64_t row, double *out) override
+            {
+                f.seekg(src.offset_ + row * src.cols_ * src.elem_);
+                if (src.elem_ == 8)
+                    f.read(reinterpret_cast<char *>(out), static_cast<std::streamsize>(src.cols_ * 8));
+                else
+                    f.read(raw.data(), static_cast<std::streamsize>(raw.size()));
+                if (!f)
+                    throw std::runtime_error("BinarySource: short read from " + src.path_);
+                if (src.elem_ == 4)
+                    for (int64_t j = 0; j < src.cols_; ++j)
+                    {
+                        float v;
+                        std::memcpy(&v, raw.data() + j * 4, 4);
+                        out[j] = v;
+                    }
+            }
+
+        private:
+            const BinarySource &src;
+            std::ifstream f;
+            std::vector<char> raw;
+        };
+        return std::make_unique<R>(*this);
+    }
+
+private:
+    std::string path_;
+    int64_t cols_, elem_, offset_, rows_ = 0;
+};
+
+// Numeric delimited text. One indexing pass records where every data line starts (blank lines
+// are skipped, 'header' drops the first line); rows are parsed when a worker reads them.
+class CsvSource : public DataSource
+{
+public:
+    explicit CsvSource(std::string path, char delimiter = ',', bool header = false)
+        : path_(std::move(path)), delim_(delimiter)
+    {
+        std::ifstream f(path_, std::ios::binary);
+        if (!f)
+            throw std::runtime_error("CsvSource: cannot open " + path_);
+        std::vector<char> buf(1 << 16);
+        int64_t pos = 0, line_start = 0;
+        bool blank = true, skip = header;
+        auto end_line = [&](int64_t end)
+        {
+            if (!blank && !std::exchange(skip, false))
+                starts_.push_back(line_start);
+            line_start = end + 1;
+            blank = true;
+        };
+        while (f)
+        {
+            f.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+            const std::streamsize got = f.gcount();
+            for (std::streamsize i = 0; i < got; ++i, ++pos)
+            {
+                const char c = buf[static_cast<size_t>(i)];
+                if (c == '\n')
+                    end_line(pos);
+                else if (c != '\r' && c != ' ' && c != '\t')
+                    blank = false;
+            }
+        }
+        end_line(pos);
+        if (starts_.empty())
+            throw std::runtime_error("CsvSource: " + path_ + " has no data rows");
+        std::string first;
+        f.clear();
+        f.seekg(starts_[0]);
+        std::getline(f, first);
+        cols_ = 1 + static_cast<int64_t>(std::count(first.begin(), first.end(), delim_));
+    }
+
+    int64_t rows() const override { return static_cast<int64_t>(starts_.size()); }
+    int64_t cols() const override { return cols_; }
+
+    std::unique_ptr<Reader> reader() const override
+    {
+        class R : public Reader
+        {
+        public:
+            explicit R(const CsvSource &s) : src(s), f(s.path_, std::ios::binary)
+            {
+                if (!f)
+                    throw std::runtime_error("CsvSource: cannot open " + s.path_);
+            }
+            void read_row(int64_t row, double *out) override
+            {
+                f.clear();
+                f.seekg(src.starts_[static_cast<size_t>(row)]);
+                std::getline(f, line);
+                const char *p = line.c_str();
+                for (int64_t j = 0; j < src.cols_; ++j)
+                {
+                    char *end;
+                    out[j] = std::strtod(p, &end);
+                    if (end == p)
+                        throw std::runtime_error("CsvSource: bad number in data row " + std::to_string(row) +
+                                                 " of " + src.path_);
+                    while (*end == ' ' || *end == '\t' || *end == '\r')
+                        ++end;
+                    if (*end != (j + 1 < src.cols_ ? src.delim_ : '\0'))
+                        throw std::runtime_error("CsvSource: data row " + std::to_string(row) + " of " +
+                                                 src.path_ + " does not have " + std::to_string(src.cols_) + " fields");
+                    p = end + 1;
+                }
+            }
+
+        private:
+            const CsvSource &src;
+            std::ifstream f;
+            std::string line;
+        };
+        return std::make_unique<R>(*this);
+    }
+
+private:
+    std::string path_;
+    char delim_;
+    int64_t cols_ = 0;
+    std::vector<int64_t> starts_; // byte offset of every data line
+};
+
+// ---------- loader ----------
+// Streams (optionally shuffled) minibatches from a DataSource. Worker threads read rows straight
+// into the batch Tensors of a ring of 'prefetch' slots; next() hands batches out in order and
+// takes the caller's previous batch back as the slot's storage (or a recycle()d one), so steady
+// state allocates nothing. A handed-out batch is owned by the caller: no worker writes to it.
+// Each row is split into named fields of consecutive columns, giving one (batch, width) Tensor
+// per field (feedable as is to Graph::forward_async or DataParallel::step).
+// The next epoch is shuffled and starts prefetching in the next() call that reports the end
+// of the current one (or in restart()).
+class DataLoader
+{
+public:
+    using Batch = std::map<std::string, Tensor>;
+    using Field = std::pair<std::string, int64_t>; // name, width in columns
+
+    DataLoader(std::shared_ptr<DataSource> source, int64_t batch_size, std::vector<Field> fields = {},
+               bool shuffle = true, uint64_t seed = 0, int workers = 2, int prefetch = 4, bool drop_last = false)
+        : src(std::move(source)), batch(batch_size), fields(std::move(fields)), shuffle(shuffle), seed(seed),
+          drop_last(drop_last), slots(static_cast<size_t>(std::max(prefetch, 1)))
+    {
+        if (!src)
+            throw std::runtime_error("DataLoader: no source");
+        if (batch <= 0)
+            throw std::runtime_error("DataLoader: batch_size must be positive");
+        if (this->fields.empty())
+            this->fields.emplace_back("x", src->cols());
+        int64_t width = 0;
+        for (auto &f : this->fields)
+        {
+            if (f.second <= 0)
+                throw std::runtime_error("DataLoader: field '" + f.first + "' needs a positive width");
+            width += f.second;
+        }
+        if (width != src->cols())
+            throw std::runtime_error("DataLoader: field widths add up to " + std::to_string(width) +
+                                     " but rows have " + std::to_string(src->cols()) + " values");
+        const int64_t n = src->rows();
+        per_epoch = drop_last ? n / batch : (n + batch - 1) / batch;
+        order.resize(static_cast<size_t>(n));
+        begin_epoch();
+        for (int w = 0; w < std::max(workers, 1); ++w)
+            pool.emplace_back([this]
+                              { work(); });
+    }
+
+    ~DataLoader()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto &t : pool)
+            t.join();
+    }
+
+    DataLoader(const DataLoader &) = delete;
+    DataLoader &operator=(const DataLoader &) = delete;
+
+    int64_t batches_per_epoch() const { return per_epoch; }
+    // Epoch being served (advances as soon as one is exhausted or restarted).
+    int64_t epoch() const
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        return epoch_;
+    }
+
+    // Next batch of the current epoch into 'out'. Its previous tensors become slot storage
+    // (pass a batch you are done with, or an empty one). Returns false once the epoch is
+    // exhausted; the following call starts the next epoch.
+    bool next(Batch &out)
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        if (consumed == per_epoch)
+        {
+            begin_epoch();
+            cv.notify_all();
+            return false;
+        }
+        Slot &s = slots[static_cast<size_t>(consumed) % slots.size()];
+        cv.wait(lk, [&]
+                { return s.ready; });
+        s.ready = false;
+        ++consumed;
+        std::exception_ptr err = std::exchange(s.error, nullptr);
+        if (!err)
+        {
+            std::swap(out, s.data);
+            if (s.data.empty() && !spare.empty())
+            {
+                s.data = std::move(spare.back());
+                spare.pop_back();
+            }
+        }
+        cv.notify_all();
+        if (err)
+            std::rethrow_exception(err);
+        return true;
+    }
+
+    // Give the tensors of a batch that is no longer used back as storage for a later one (for
+    // callers that take batches with an empty 'out').
+    void recycle(Batch &&b)
+    {
+        std::lock_guard<std::mutex> lk(mu);
+        if (spare.size() < slots.size())
+            spare.push_back(std::move(b));
+    }
+
+    // Drop what is left of the current epoch and start the next one.
+    void restart()
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        if (consumed == 0)
+            return;
+        claimed = per_epoch; // stop handing out work, then let in-flight batches land
+        cv.wait(lk, [this]
+                { return in_flight == 0; });
+        for (auto &s : slots)
+        {
+            s.ready = false;
+            s.error = nullptr;
+        }
+        begin_epoch();
+        cv.notify_all();
+    }
+
+private:
+    struct Slot
+    {
+        Batch data;
+        bool ready = false;
+        std::exception_ptr error;
+    };
+
+    // Called with 'mu' held (or before the workers exist).
+    void begin_epoch()
+    {
+        if (consumed > 0 || epoch_ < 0)
+            ++epoch_;
+        std::iota(order.begin(), order.end(), int64_t(0));
+        if (shuffle)
+        {
+            std::mt19937_64 rng(seed + static_cast<uint64_t>(epoch_) * 0x9E3779B97F4A7C15ULL);
+            std::shuffle(order.begin(), order.end(), rng);
+        }
+        claimed = consumed = 0;
+    }
+
+    void work()
+    {
+        std::unique_ptr<DataSource::Reader> reader;
+        std::exception_ptr open_error;
+        try
+        {
+            reader = src->reader();
+        }
+        catch (...)
+        {
+            open_error = std::current_exception();
+        }
+        std::vector<double> row(static_cast<size_t>(src->cols()));
+        for (;;)
+        {
+            int64_t b;
+            Slot *s;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                // bounded: batch b may only be filled once the slot it reuses has been consumed
+                cv.wait(lk, [this]
+                        { return stopping || (claimed < per_epoch && claimed < consumed + int64_t(slots.size())); });
+                if (stopping)
+                    return;
+                b = claimed++;
+                s = &slots[static_cast<size_t>(b) % slots.size()];
+                ++in_flight;
+            }
+            try
+            {
+                if (open_error)
+                    std::rethrow_exception(open_error);
+                fill(b, s->data, *reader, row);
+            }
+            catch (...)
+            {
+                s->error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                s->ready = true;
+                --in_flight;
+            }
+            cv.notify_all();
+        }
+    }
+
+    void fill(int64_t b, Batch &out, DataSource::Reader &reader, std::vector<double> &row) const
+    {
+        const int64_t lo = b * batch, n = std::min(batch, static_cast<int64_t>(order.size()) - lo);
+        std::vector<double *> dst;
+        for (auto &f : fields)
+        {
+            Tensor &t = out[f.first];
+            t.ensure_shape({n, f.second});
+            dst.push_back(t.data.data());
+        }
+        const bool direct = fields.size() == 1;
+        for (int64_t i = 0; i < n; ++i)
+        {
+            const int64_t r = order[static_cast<size_t>(lo + i)];
+            if (direct)
+            {
+                reader.read_row(r, dst[0] + i * fields[0].second);
+                continue;
+            }
+            reader.read_row(r, row.data());
+            const double *p = row.data();
+            for (size_t k = 0; k < fields.size(); ++k)
+            {
+                std::copy(p, p + fields[k].second, dst[k] + i * fields[k].second);
+                p += fields[k].second;
+            }
+        }
+    }
+
+    std::shared_ptr<DataSource> src;
+    int64_t batch;
+    std::vector<Field> fields;
+    bool shuffle;
+    uint64_t seed;
+    bool drop_last;
+    int64_t per_epoch = 0;
+    std::vector<int64_t> order; // row order of the current epoch
+
+    mutable std::mutex mu;
+    std::condition_variable cv;
+    std::vector<Slot> slots;
+    std::vector<Batch> spare; // recycle()d batches, storage for slots emptied by next()
+    int64_t epoch_ = -1, claimed = 0, consumed = 0, in_flight = 0;
+    bool stopping = false;
+    std::vector<std::thread> pool; // last: workers start once everything above exists
+};
@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Graph.hpp"
+#include "Optimizer.hpp"
+#include "Comm.hpp"
+
+// Data-parallel training across local processes: every rank holds a replica Graph and feeds
+// its own shard. Variable grads are averaged with bucketed ring all-reduces that start while
+// the backward sweep is still running; the optimizer then steps identically on every rank.
+class DataParallel
+{
+public:
+    DataParallel(Graph &g, Optimizer &opt, ShmCommunicator &comm, int64_t bucket_elems = 1 << 18)
+        : graph(g), optimizer(opt), comm(comm)
+    {
+        params = graph.parameters();
+        plan_buckets(bucket_elems);
+        // replicas start from rank 0's parameters
+        for (auto &p : params)
+        {
+            comm.broadcast(p->value.data.data(), p->value.size(), 0);
+            p->mark_dirty();
+        }
+        worker = std::thread([this]
+                             { comm_loop(); });
+    }
+
+    ~DataParallel()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    // One synchronized step on this rank's batch. Returns the local (scalar) loss.
+    double step(const std::map<std::string, Tensor> &feed = {})
+    {
+        for (auto &kv : feed)
+            graph.leaf_named(kv.first, "DataParallel::step")->set_value(kv.second);
+        const Tensor &loss = graph.forward();
+        if (loss.size() != 1)
+            throw std::runtime_error("DataParallel::step: root must be scalar");
+        const double l = loss.data[0];
+
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            pending = buckets.size();
+        }
+        size_t next = 0;
+        graph.backward_sweep([&](size_t i)
+                             {
+            while (next < buckets.size() && buckets[next].launch_at == i)
+                enqueue(next++); });
+        wait_all();
+        optimizer.step(params);
+        return l;
+    }
+
+    std::vector<double> train(int64_t steps, const std::map<std::string, std::vector<Tensor>> &feed = {})
+    {
+        std::vector<double> losses;
+        std::map<std::string, Tensor> batch;
+        for (auto &kv : feed)
+            if (kv.second.empty())
+                throw std::runtime_error("DataParallel::train: empty feed for '" + kv.first + "'");
+        for (int64_t s = 0; s < steps; ++s)
+        {
+            for (auto &kv : feed)
+                batch[kv.first] = kv.second.at(static_cast<size_t>(s) % kv.second.size());
+            losses.push_back(step(batch));
+        }
+        return losses;
+    }
+
+    size_t bucket_count() const { return buckets.size(); }
+
+private:
+    struct Bucket
+    {
+        std::vector<Node *> members;
+        std::vector<double> flat;
+        size_t launch_at; // sweep position after which every member's grad is final
+    };
+
+    // A Variable's grad is final once the sweep has passed its earliest consumer. Params are
+    // packed in the order they become final, so buckets launch in order during the sweep.
+    void plan_buckets(int64_t bucket_elems)
+    {
+        // position of each node's earliest consumer ('order' is topological, so the first
+        // operator found consuming it); a param without consumers (the root) uses its own
+        std::unordered_map<const Node *, size_t> ready_at;
+        for (size_t i = 0; i < graph.order.size(); ++i)
+            if (auto op = dynamic_cast<Operator *>(graph.order[i].get()))
+                for (Node *in : {op->a.get(), op->b.get(), op->c.get()})
+                    if (in)
+                        ready_at.emplace(in, i);
+        for (size_t i = 0; i < graph.order.size(); ++i)
+            ready_at.emplace(graph.order[i].get(), i);
+        std::vector<NodePtr> sorted = params;
+        std::stable_sort(sorted.begin(), sorted.end(), [&](const NodePtr &x, const NodePtr &y)
+                         { return ready_at[x.get()] > ready_at[y.get()]; });
+        int64_t filled = 0;
+        for (auto &p : sorted)
+        {
+            if (buckets.empty() || filled + p->value.size() > bucket_elems)
+            {
+                buckets.push_back(Bucket{{}, {}, ready_at[p.get()]});
+                filled = 0;
+            }
+            Bucket &b = buckets.back();
+            b.members.push_back(p.get());
+            b.launch_at = std::min(b.launch_at, ready_at[p.get()]);
+            filled += p->value.size();
+        }
+        for (auto &b : buckets)
+        {
+            int64_t n = 0;
+            for (auto *p : b.members)
+                n += p->value.size();
+            b.flat.resize(static_cast<size_t>(n));
+        }
+    }
+
+    void enqueue(size_t b)
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            queue.push_back(b);
+        }
+        cv.notify_all();
+    }
+
+    void wait_all()
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        cv.wait(lk, [this]
+                { return pending == 0; });
+        if (error)
+            std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+    // Communication thread: pack -> ring all-reduce -> unpack averaged grads, bucket by bucket.
+    void comm_loop()
+    {
+        const double scale = 1.0 / comm.world_size();
+        for (;;)
+        {
+            size_t bi;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv.wait(lk, [this]
+                        { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                bi = queue.front();
+                queue.pop_front();
+            }
+            try
+            {
+                Bucket &b = buckets[bi];
+                double *dst = b.flat.data();
+                for (auto *p : b.members)
+                    dst = std::copy(p->grad.data.begin(), p->grad.data.end(), dst);
+                comm.allreduce_sum(b.flat.data(), static_cast<int64_t>(b.flat.size()));
+                const double *src = b.flat.data();
+                for (auto *p : b.members)
+                    for (auto &g : p->grad.data)
+                        g = *src++ * scale;
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                if (!error)
+                    error = std::current_exception();
+            }
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                --pending;
+            }
+            cv.notify_all();
+        }
+    }
+
+    Graph &graph;
+    Optimizer &optimizer;
+    ShmCommunicator &comm;
+    std::vector<NodePtr> params;
+    std::vector<Bucket> buckets;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<size_t> queue;
+    size_t pending = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+    std::thread worker;
+};
@@ -14,11 +14,27 @@ from __future__ import annotations
 try:
     from .ElhamMath import (  # type: ignore[attr-defined]
         # core types
-        Node, Variable, Constant, Operator, UnaryOperator, Graph,
+        Node, Variable, Constant, Operator, UnaryOperator, Graph, PassReport,
+        TensorFuture, Future, Tape,
+        # memory accounting
+        MemoryReport, NodeMemory, memory_stats, reset_peak,
+        # int8 inference
+        QuantReport, QuantError,
+        # kernel dispatch
+        kernel_isa, kernel_isas,
+        Optimizer, SGD, Momentum, Adam, AdamW,
         # operators (binary)
-        add, mul, divide, power, log_base, matmul, dot, cross,sub,
+        add, mul, divide, power, log_base, matmul, linear, conv2d, dot, cross,sub,
+        # sparse
+        CsrTensor, SparseVariable, sparse_matmul,
+        # multi-process training
+        ShmCommunicator, DataParallel,
+        # data loading
+        DataSource, BinarySource, CsvSource, DataLoader,
         # operators (unary)
-        ln, exp, sqrt,
+        ln, exp, sqrt, softmax, log_softmax, logsumexp, softmax_cross_entropy, dropout,
+        # random numbers
+        Generator, default_generator, manual_seed,
         # (optional) low-level types if you bound them
         Tensor, Device,
     )
@@ -34,10 +50,19 @@ except Exception as _e:  # pragma: no cover
 __all__ = [
     name for name in (
         # core
-        "Node", "Variable", "Constant", "Operator", "UnaryOperator", "Graph",
+        "Node", "Variable", "Constant", "Operator", "UnaryOperator", "Graph", "PassReport",
+        "TensorFuture", "Future", "Tape",
+        "MemoryReport", "NodeMemory", "memory_stats", "reset_peak",
+        "QuantReport", "QuantError",
+        "kernel_isa", "kernel_isas",
+        "Optimizer", "SGD", "Momentum", "Adam", "AdamW",
         # ops
-        "add", "mul", "divide", "power", "log_base", "matmul", "dot", "cross",
-        "ln", "exp", "sqrt",
+        "add", "mul", "divide", "power", "log_base", "matmul", "linear", "conv2d", "dot", "cross",
+        "ln", "exp", "sqrt", "softmax", "log_softmax", "logsumexp", "softmax_cross_entropy", "dropout",
+        "Generator", "default_generator", "manual_seed",
+        "CsrTensor", "SparseVariable", "sparse_matmul",
+        "ShmCommunicator", "DataParallel",
+        "DataSource", "BinarySource", "CsvSource", "DataLoader",
         # optional low-level
         "Tensor", "Device",
     )
@@ -59,13 +84,17 @@ name : str
 """
 
 if "Constant" in globals():
-    Constant.__doc__ = """Constant(value, name)
+    Constant.__doc__ = """Constant(value, name, literal=False)
 A non-differentiable leaf node (gradient does not propagate into it).
 
 Parameters
 ----------
 value : Tensor | float
 name : str
+    Name for graph bookkeeping; inputs are fed by this name (Graph.train, DataParallel.step, ...).
+literal : bool
+    The value is fixed: Graph's construction passes may fold and simplify it away (x * 1, x + 0,
+    all-literal subtrees), and it cannot be fed. Unnamed Constants are literals too.
 """
 
 if "add" in globals():
@@ -92,9 +121,43 @@ if "exp" in globals():
 if "sqrt" in globals():
     sqrt.__doc__ = "sqrt(x, name='') -> Node\nSquare root (elementwise)."
 
+if "softmax" in globals():
+    softmax.__doc__ = "softmax(x, axis=-1, name='') -> Node\nFused, max-shifted softmax along `axis`."
+
+if "log_softmax" in globals():
+    log_softmax.__doc__ = "log_softmax(x, axis=-1, name='') -> Node\nFused x - logsumexp(x) along `axis`."
+
+if "logsumexp" in globals():
+    logsumexp.__doc__ = ("logsumexp(x, axis=-1, name='') -> Node\nlog(sum(exp(x))) along `axis`, "
+                         "which is kept with size 1 so the result broadcasts against x.")
+
+if "softmax_cross_entropy" in globals():
+    softmax_cross_entropy.__doc__ = ("softmax_cross_entropy(logits, target, axis=-1, name='') -> Node\n"
+                                     "Scalar mean over rows of -sum(target * log_softmax(logits)); "
+                                     "target holds class probabilities (e.g. one-hot) of the logits' shape.")
+
 if "matmul" in globals():
     matmul.__doc__ = "matmul(A, B, name='') -> Node\nMatrix product: (m,k) @ (k,n) -> (m,n)."
 
+if "linear" in globals():
+    linear.__doc__ = ("linear(X, W, bias=None, activation='none', name='') -> Node\n"
+                      "Fused dense layer act(X @ W + bias): (m,k) @ (k,n) + (n,) -> (m,n).\n"
+                      "activation: 'none', 'relu', 'gelu' (erf form), 'tanh' or 'sigmoid'.")
+
+if "conv2d" in globals():
+    conv2d.__doc__ = ("conv2d(x, w, stride=1, padding=0, dilation=1, groups=1, name='') -> Node\n"
+                      "2D convolution, NCHW: (N,C,H,W) * (F,C/groups,KH,KW) -> (N,F,OH,OW).\n"
+                      "stride/padding/dilation take an int or an (h, w) pair. Add a bias of shape (F,1,1).")
+
+if "sparse_matmul" in globals():
+    sparse_matmul.__doc__ = ("sparse_matmul(S, D, name='') -> Node\nSparse (CSR) @ dense: (m,k) @ (k,n) -> (m,n).\n"
+                             "S is a SparseVariable; its gradient (S.grad_csr) keeps S's sparsity pattern.")
+
+if "CsrTensor" in globals():
+    CsrTensor.__doc__ = ("CsrTensor(rows, cols, indptr, indices, values)\n"
+                         "CsrTensor.from_scipy(m) borrows a scipy.sparse.csr_matrix without copying "
+                         "(float64 data, int32/int64 indices).")
+
 if "dot" in globals():
     dot.__doc__ = "dot(a, b, name='') -> Node\nVector dot product -> scalar."
 
@@ -102,13 +165,100 @@ if "cross" in globals():
     cross.__doc__ = "cross(a, b, name='') -> Node\n3D vector cross product (3,) × (3,) -> (3,)."
 
 if "Graph" in globals():
-    Graph.__doc__ = """Graph(root)
+    Graph.__doc__ = """Graph(root, optimize=True)
 A computation graph wrapper.
 
+With optimize=True the graph is rewritten at construction (constant folding,
+algebraic simplification, common-subexpression elimination); `report` holds
+how many nodes each pass removed. Only literal Constants are folded or
+simplified, so named Constants stay feedable inputs. Read results from forward()/Variable.grad:
+intermediate nodes merged away are no longer evaluated.
+
 Methods
 -------
 forward() -> Tensor
+    Recomputes only nodes downstream of leaves changed since the last call
+    (assigning `node.value = t` marks it; `node.value` returns a copy, so
+    editing that copy leaves the node unchanged). `recomputed` counts the
+    operators evaluated.
 backward() -> None
+jvp(tangents: dict[str, Tensor]) -> Tensor
+    Forward-mode directional derivative of the root along the given Variable tangents.
+    Raises if a name is unknown, shared by several leaves, or not a Variable.
+hvp(v: dict[str, Tensor]) -> dict[str, Tensor]
+    Hessian-vector product of a scalar root (forward-over-reverse), per Variable.
+jacobian(wrt=[], chunk=0) -> dict[str, Tensor]
+    Dense Jacobian of the root w.r.t. each Variable (or the leaves named in
+    `wrt`), shape (*root.shape, *leaf.shape). Each reverse sweep carries a
+    block of `chunk` one-hot seeds through batched VJPs (0 = sized
+    automatically). Overwrites grads.
+calibrate(batches) -> None
+quantize(on=True) -> None
+quantization_report(batches) -> QuantReport
+    Post-training int8 inference. `batches` is a list of {leaf name: Tensor}.
+    calibrate() runs fp64 forwards and records the activation range of every
+    matmul/linear with a Variable weight; quantize() packs those weights to
+    int8 (per output column) and runs them on int8 GEMM kernels, quantizing
+    activations with the calibrated range (or each batch's own range when not
+    calibrated). `quantized` tells the mode; backward/jvp/hvp/jacobian raise
+    while it is on. quantization_report() compares int8 with fp64 per batch.
+train(steps, optimizer, feed={}) -> list[float]
+    forward/backward/optimizer.step for `steps` iterations entirely in C++ (GIL
+    released). `feed` maps a leaf name to a list of batches, used round-robin.
+    Returns the scalar root value of every step.
+forward_async(feed={}) -> TensorFuture
+backward_async() -> Future
+step_async(optimizer) -> Future
+    Enqueue on the graph's execution stream (one worker thread) and return at
+    once; work runs in submission order and forward()/backward()/train() wait
+    for it first. `feed` is copied at the call, so the next batch can be
+    prepared while this one runs. result() waits without holding the GIL.
+synchronize() -> None
+    Wait for all enqueued work.
+memory_report() -> MemoryReport
+    Bytes held per node and per category (parameters, inputs, activations,
+    grads, temporaries). Set `memory_budget` (bytes, 0 = unlimited) to make
+    shape inference, forward and backward raise once the graph would exceed
+    it; the error lists the largest holders.
+"""
+
+if "DataParallel" in globals():
+    DataParallel.__doc__ = """DataParallel(graph, optimizer, comm, bucket_elems=262144)
+Synchronous data-parallel training across processes on one machine.
+
+Run one process per rank, each with an identical graph and its own data shard,
+and a ShmCommunicator(name, rank, world_size) sharing the same name. Parameters
+are broadcast from rank 0 at construction. step(feed) runs forward/backward,
+averages Variable grads with bucketed ring all-reduces that overlap the backward
+sweep, then applies the optimizer; every rank ends the step with equal weights.
+"""
+
+if "kernel_isa" in globals():
+    kernel_isa.__doc__ = ("kernel_isa(kernel='') -> str\n"
+                          "ISA variant ('baseline', 'avx2', 'avx512') the named kernel (e.g. 'matmul2d_into') "
+                          "runs, or the default one; 'default' in single-variant builds. Chosen at import "
+                          "from the CPU; set ELHAMMATH_KERNEL_ISA (e.g. 'avx2' or "
+                          "'baseline,matmul2d_into=avx512') before importing to force variants.")
+
+if "DataLoader" in globals():
+    DataLoader.__doc__ = """DataLoader(source, batch_size, fields=[], shuffle=True, seed=0, workers=2, prefetch=4, drop_last=False)
+Streams minibatches from a BinarySource (raw float64/float32 rows) or CsvSource.
+
+Worker threads read (shuffled) rows straight into batch Tensors, keeping up to
+`prefetch` batches ready. `fields` splits each row into named column groups,
+e.g. [("x", 784), ("y", 10)]; the default is one field "x" spanning the row.
+Iterating yields dicts of (batch, width) Tensors, directly usable as a feed:
+
+    for batch in loader:
+        graph.forward_async(batch); graph.backward_async(); graph.step_async(opt)
+
+Each loop is one epoch (reshuffled with seed and epoch number); the next epoch
+starts prefetching when the loop ends. Each yielded dict owns its Tensors, so
+batches may be kept (list(loader), the previous batch, a pending forward_async).
+
+recycle(batch)
+    Hand a batch you are done with back to the loader, which refills its buffers
+    instead of allocating new ones; the batch's Tensors are left empty.
 """
 
 def _prod(shape):
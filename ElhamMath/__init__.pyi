@@ -44,12 +44,50 @@ class Tensor(_CTensor):
     def size(self) -> int: ...
     def is_scalar(self) -> bool: ...
     def desc(self) -> str: ...
+    @staticmethod
+    def rand(shape: Sequence[int], generator: Optional[Generator] = None) -> Tensor: ...
+    @staticmethod
+    def randn(shape: Sequence[int], generator: Optional[Generator] = None) -> Tensor: ...
+    @staticmethod
+    def uniform(shape: Sequence[int], low: float = 0.0, high: float = 1.0,
+                generator: Optional[Generator] = None) -> Tensor: ...
+    @staticmethod
+    def normal(shape: Sequence[int], mean: float = 0.0, std: float = 1.0,
+               generator: Optional[Generator] = None) -> Tensor: ...
+
+class Generator:
+    """Counter-based (Philox) random source: (seed, offset) determine every later draw."""
+    seed: int
+    offset: int
+    def __init__(self, seed: int = 0) -> None: ...
+    def manual_seed(self, seed: int) -> None: ...
+
+def default_generator() -> Generator: ...
+def manual_seed(seed: int) -> None: ...
+
+class CsrTensor:
+    """2D CSR sparse matrix (may borrow SciPy buffers)."""
+    rows: int
+    cols: int
+    nnz: int
+    def __init__(self, rows: int, cols: int, indptr: Sequence[int], indices: Sequence[int],
+                 values: Sequence[float]) -> None: ...
+    @staticmethod
+    def from_dense(dense: Tensor) -> CsrTensor: ...
+    @staticmethod
+    def from_scipy(matrix: object) -> CsrTensor: ...
+    def to_dense(self) -> Tensor: ...
+    def desc(self) -> str: ...
 
 class Node:
     """Abstract differentiable node."""
     name: str
-    value: Tensor
+    value: Tensor  # a copy; assign a Tensor to change it (marks the node dirty)
     grad: Tensor
+    tangent: Tensor
+    grad_tangent: Tensor
+    version: int
+    def mark_dirty(self) -> None: ...
     def forward(self) -> Tensor: ...
     def backward(self, g: Tensor) -> None: ...
 
@@ -71,6 +109,13 @@ class Constant(Node):
     @overload
     def __init__(self, value: float, name: str) -> None: ...
 
+class SparseVariable(Node):
+    """Sparse leaf; its gradient keeps the sparsity pattern (grad_csr)."""
+    csr: CsrTensor
+    requires_grad: bool
+    grad_csr: CsrTensor
+    def __init__(self, value: CsrTensor, name: str, requires_grad: bool = True) -> None: ...
+
 # ---- Binary operators (return a Node) ----
 class add(Operator):
     def __init__(self, x1: Node, x2: Node, name: str = ...) -> None: ...
@@ -109,6 +154,52 @@ class matmul(Operator):
     def forward(self) -> Tensor: ...
     def backward(self, g: Tensor) -> None: ...
 
+class linear(Operator):
+    """Fused act(X @ W + bias)."""
+    def __init__(self, X: Node, W: Node, bias: Optional[Node] = None,
+                 activation: Literal["none", "relu", "gelu", "tanh", "sigmoid"] = "none",
+                 name: str = ...) -> None: ...
+
+class dropout(UnaryOperator):
+    """Inverted dropout; the mask is regenerated from the RNG counter in backward."""
+    p: float
+    training: bool
+    def __init__(self, x: Node, p: float = 0.5, name: str = ...,
+                 generator: Optional[Generator] = None) -> None: ...
+
+class softmax(UnaryOperator):
+    axis: int
+    def __init__(self, x: Node, axis: int = -1, name: str = ...) -> None: ...
+
+class log_softmax(UnaryOperator):
+    axis: int
+    def __init__(self, x: Node, axis: int = -1, name: str = ...) -> None: ...
+
+class logsumexp(UnaryOperator):
+    """Reduces `axis` to size 1."""
+    axis: int
+    def __init__(self, x: Node, axis: int = -1, name: str = ...) -> None: ...
+
+class softmax_cross_entropy(Operator):
+    """Scalar mean over rows of -sum(target * log_softmax(logits))."""
+    axis: int
+    def __init__(self, logits: Node, target: Node, axis: int = -1, name: str = ...) -> None: ...
+
+class conv2d(Operator):
+    """2D convolution over NCHW input: (N,C,H,W) * (F,C/groups,KH,KW) -> (N,F,OH,OW)."""
+    stride: Tuple[int, int]
+    padding: Tuple[int, int]
+    dilation: Tuple[int, int]
+    groups: int
+    def __init__(self, x: Node, w: Node, stride: Union[int, Tuple[int, int]] = 1,
+                 padding: Union[int, Tuple[int, int]] = 0, dilation: Union[int, Tuple[int, int]] = 1,
+                 groups: int = 1, name: str = ...) -> None: ...
+
+class sparse_matmul(Operator):
+    def __init__(self, S: SparseVariable, D: Node, name: str = ...) -> None: ...
+    def forward(self) -> Tensor: ...
+    def backward(self, g: Tensor) -> None: ...
+
 class dot(Operator):
     def __init__(self, a: Node, b: Node, name: str = ...) -> None: ...
     def forward(self) -> Tensor: ...
@@ -135,10 +226,181 @@ class sqrt(UnaryOperator):
     def forward(self) -> Tensor: ...
     def backward(self, g: Tensor) -> None: ...
 
+class Optimizer:
+    """In-place parameter update rule (C++ side)."""
+    @overload
+    def step(self, params: Sequence[Node]) -> None: ...
+    @overload
+    def step(self, graph: Graph) -> None: ...
+
+class SGD(Optimizer):
+    lr: float
+    weight_decay: float
+    def __init__(self, lr: float, weight_decay: float = 0.0) -> None: ...
+
+class Momentum(Optimizer):
+    lr: float
+    momentum: float
+    weight_decay: float
+    nesterov: bool
+    def __init__(self, lr: float, momentum: float = 0.9, weight_decay: float = 0.0,
+                 nesterov: bool = False) -> None: ...
+
+class Adam(Optimizer):
+    lr: float
+    beta1: float
+    beta2: float
+    eps: float
+    weight_decay: float
+    t: int
+    def __init__(self, lr: float = 1e-3, beta1: float = 0.9, beta2: float = 0.999,
+                 eps: float = 1e-8, weight_decay: float = 0.0) -> None: ...
+
+class AdamW(Adam):
+    def __init__(self, lr: float = 1e-3, beta1: float = 0.9, beta2: float = 0.999,
+                 eps: float = 1e-8, weight_decay: float = 1e-2) -> None: ...
+
+class PassReport:
+    """Nodes removed by each construction-time optimization pass."""
+    folded: int
+    simplified: int
+    cse: int
+
+class NodeMemory:
+    """Tensor bytes held by one node, by category."""
+    name: str
+    parameters: int
+    inputs: int
+    activations: int
+    grads: int
+    temporaries: int
+    total: int
+
+class MemoryReport:
+    """Per-node and per-category tensor bytes of a Graph."""
+    nodes: List[NodeMemory]
+    parameters: int
+    inputs: int
+    activations: int
+    grads: int
+    temporaries: int
+    total: int
+    def largest(self, k: int = 5) -> List[NodeMemory]: ...
+
+class QuantError:
+    """int8 vs fp64 output error of one node."""
+    name: str
+    max_abs_error: float
+    rel_error: float
+
+class QuantReport:
+    """Accuracy of a Graph's int8 path against fp64."""
+    quantized_ops: int
+    root: QuantError
+    ops: List[QuantError]
+
+def memory_stats() -> dict[str, int]: ...
+def reset_peak() -> None: ...
+def kernel_isa(kernel: str = "") -> str: ...
+def kernel_isas() -> List[str]: ...
+
+class TensorFuture:
+    """Pending result of Graph.forward_async."""
+    def result(self) -> Tensor: ...
+    def wait(self) -> None: ...
+    def done(self) -> bool: ...
+
+class Future:
+    """Pending completion of Graph.backward_async / step_async."""
+    def result(self) -> None: ...
+    def wait(self) -> None: ...
+    def done(self) -> bool: ...
+
 class Graph:
     """Computation graph wrapper."""
     nodes: Mapping[str, Node]
-    def __init__(self, root: Node) -> None: ...
+    report: PassReport
+    recomputed: int
+    memory_budget: int
+    def __init__(self, root: Node, optimize: bool = True) -> None: ...
+    def memory_report(self) -> MemoryReport: ...
+    def check_memory_budget(self) -> None: ...
+    def invalidate(self) -> None: ...
     def forward(self) -> Tensor: ...
     def backward(self) -> None: ...
+    def jvp(self, tangents: Mapping[str, Tensor]) -> Tensor: ...
+    def hvp(self, v: Mapping[str, Tensor]) -> dict[str, Tensor]: ...
+    def jacobian(self, wrt: Sequence[str] = ..., chunk: int = 0) -> dict[str, Tensor]: ...
+    def calibrate(self, batches: Sequence[Mapping[str, Tensor]]) -> None: ...
+    def quantize(self, on: bool = True) -> None: ...
+    @property
+    def quantized(self) -> bool: ...
+    def quantization_report(self, batches: Sequence[Mapping[str, Tensor]]) -> QuantReport: ...
+    def forward_async(self, feed: Mapping[str, Tensor] = ...) -> TensorFuture: ...
+    def backward_async(self) -> Future: ...
+    def step_async(self, optimizer: Optimizer) -> Future: ...
+    def synchronize(self) -> None: ...
+    def infer_shapes(self) -> None: ...
+    def parameters(self) -> List[Node]: ...
+    def train(self, steps: int, optimizer: Optimizer,
+              feed: Mapping[str, Sequence[Tensor]] = ...) -> List[float]: ...
     def printGrads(self) -> None: ...
+
+class Tape:
+    """Flat compiled form of a Graph; leaf grads land in the Graph's nodes."""
+    def __init__(self, graph: Graph) -> None: ...
+    def __len__(self) -> int: ...
+    def forward(self) -> Tensor: ...
+    def backward(self) -> None: ...
+    def slot(self, name: str) -> int: ...
+    @overload
+    def value(self, name: str) -> Tensor: ...
+    @overload
+    def value(self, slot: int) -> Tensor: ...
+    @overload
+    def grad(self, name: str) -> Tensor: ...
+    @overload
+    def grad(self, slot: int) -> Tensor: ...
+
+class ShmCommunicator:
+    """Shared-memory collectives between processes on one machine."""
+    rank: int
+    world_size: int
+    def __init__(self, name: str, rank: int, world_size: int, chunk_elems: int = 65536,
+                 timeout: float = 120.0) -> None: ...
+    def allreduce(self, tensor: Tensor) -> None: ...
+    def broadcast(self, tensor: Tensor, root: int = 0) -> None: ...
+    def barrier(self) -> None: ...
+
+class DataSource:
+    """Table of `rows` samples with `cols` values each."""
+    rows: int
+    cols: int
+
+class BinarySource(DataSource):
+    """Headerless row-major float64/float32 records (e.g. ndarray.tofile)."""
+    def __init__(self, path: str, cols: int, dtype: Literal["float64", "float32"] = "float64",
+                 offset: int = 0) -> None: ...
+
+class CsvSource(DataSource):
+    """Numeric delimited text; `header` skips the first line."""
+    def __init__(self, path: str, delimiter: str = ",", header: bool = False) -> None: ...
+
+class DataLoader:
+    """Shuffled, batched, prefetched minibatches from a DataSource."""
+    epoch: int
+    def __init__(self, source: DataSource, batch_size: int, fields: Sequence[Tuple[str, int]] = ...,
+                 shuffle: bool = True, seed: int = 0, workers: int = 2, prefetch: int = 4,
+                 drop_last: bool = False) -> None: ...
+    def __len__(self) -> int: ...
+    def __iter__(self) -> DataLoader: ...
+    def __next__(self) -> dict[str, Tensor]: ...
+    def restart(self) -> None: ...
+
+class DataParallel:
+    """Synchronous data-parallel training with overlapped gradient all-reduce."""
+    bucket_count: int
+    def __init__(self, graph: Graph, optimizer: Optimizer, comm: ShmCommunicator,
+                 bucket_elems: int = 262144) -> None: ...
+    def step(self, feed: Mapping[str, Tensor] = ...) -> float: ...
+    def train(self, steps: int, feed: Mapping[str, Sequence[Tensor]] = ...) -> List[float]: ...
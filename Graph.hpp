@@ -1,17 +1,51 @@
 #pragma once
+#include <array>
 #include <map>
 #include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 #include "Node.hpp"
+#include "Memory.hpp"
+#include "Passes.hpp"
+#include "Optimizer.hpp"
+#include "Stream.hpp"
+
+// int8 vs fp64 output error of one node over a set of batches (Graph::quantization_report).
+struct QuantError
+{
+    std::string name;
+    double max_abs_error = 0.0;
+    double rel_error = 0.0; // ||int8 - fp64|| / ||fp64|| over all batches
+};
+
+struct QuantReport
+{
+    int64_t quantized_ops = 0;
+    QuantError root;
+    std::vector<QuantError> ops; // each quantized operator, errors compounding along the graph
+};
 
 class Graph
 {
 public:
     NodePtr root;
     std::map<std::string, NodePtr> nodes;
+    std::vector<NodePtr> order; // topological: inputs before consumers, each node once
+    PassReport report;          // nodes removed by the construction-time passes
+    std::vector<Shape> leaf_shapes;                // leaf shapes the current inference was done for
+    int64_t recomputed = 0;                        // operators evaluated by the last forward()
+    int64_t memory_budget = 0;                     // max bytes of this graph's tensors (0 = unlimited)
 
-    explicit Graph(NodePtr r) : root(std::move(r))
+    explicit Graph(NodePtr r, bool optimize = true) : root(std::move(r))
     {
+        if (optimize)
+            report = optimize_graph(root);
         build(root);
+        std::unordered_set<Node *> seen;
+        topo_sort(root, seen);
+        index_inputs();
+        infer_shapes();
     }
 
     void build(const NodePtr &n)
@@ -29,18 +63,549 @@ public:
                 build(op->a);
             if (op->b)
                 build(op->b);
+            if (op->c)
+                build(op->c);
+        }
+    }
+
+    // Post-order DFS keyed on node identity (names may repeat, e.g. the default "").
+    void topo_sort(const NodePtr &n, std::unordered_set<Node *> &seen)
+    {
+        if (!n || !seen.insert(n.get()).second)
+            return;
+        if (auto op = std::dynamic_pointer_cast<Operator>(n))
+        {
+            topo_sort(op->a, seen);
+            topo_sort(op->b, seen);
+            topo_sort(op->c, seen);
+        }
+        order.push_back(n);
+    }
+
+    // Position of each operator's inputs in 'order' (-1 if absent), for dirty propagation.
+    void index_inputs()
+    {
+        std::unordered_map<const Node *, int32_t> pos;
+        for (size_t i = 0; i < order.size(); ++i)
+            pos[order[i].get()] = static_cast<int32_t>(i);
+        auto at = [&](const NodePtr &in)
+        { return in ? pos.at(in.get()) : -1; };
+        input_pos.assign(order.size(), {-1, -1, -1});
+        ops.assign(order.size(), nullptr);
+        for (size_t i = 0; i < order.size(); ++i)
+            if (auto op = dynamic_cast<Operator *>(order[i].get()))
+            {
+                ops[i] = op;
+                input_pos[i] = {at(op->a), at(op->b), at(op->c)};
+            }
+        dirty.assign(order.size(), 1);
+        seen_version.assign(order.size(), 0);
+        // leaves by name from 'order' ('nodes' keeps one node per name, and unnamed operators
+        // all share ""); a repeated name maps to null
+        leaves_by_name.clear();
+        for (size_t i = 0; i < order.size(); ++i)
+            if (!ops[i])
+            {
+                auto ins = leaves_by_name.emplace(order[i]->name, order[i].get());
+                if (!ins.second)
+                    ins.first->second = nullptr;
+            }
+    }
+
+    // Force the next forward() to recompute every node (e.g. after editing a leaf's
+    // value in place without calling mark_dirty()).
+    void invalidate() { full_recompute = true; }
+
+    // Static shape pass: validate every operator against its inputs' shapes and preallocate
+    // its value and grad buffers. Leaves define the shapes; re-run only when one changes.
+    // Shapes are settled first so a memory budget rejects the plan before anything is allocated.
+    void infer_shapes()
+    {
+        leaf_shapes.clear();
+        for (auto &n : order)
+            if (auto op = dynamic_cast<Operator *>(n.get()))
+            {
+                try
+                {
+                    auto s = op->infer_shape();
+                    if (op->value.shape != s)
+                    {
+                        op->value.shape = std::move(s);
+                        op->value.recompute_strides();
+                    }
+                }
+                catch (const std::exception &e)
+                {
+                    throw std::runtime_error("shape inference failed at '" + op->name + "': " + e.what());
+                }
+            }
+        if (memory_budget > 0)
+            enforce_budget(planned_memory(), "planned");
+        for (auto &n : order)
+        {
+            if (auto op = dynamic_cast<Operator *>(n.get()))
+            {
+                op->value.ensure_shape(op->value.shape);
+                op->zero_grad();
+            }
+            else
+                leaf_shapes.push_back(n->value.shape);
         }
+        full_recompute = true;
+    }
+
+    bool shapes_changed() const
+    {
+        size_t i = 0;
+        for (auto &n : order)
+            if (!dynamic_cast<Operator *>(n.get()) &&
+                (i >= leaf_shapes.size() || n->value.shape != leaf_shapes[i++]))
+                return true;
+        return false;
+    }
+
+    // Bytes currently held by this graph's nodes, per node and per category.
+    MemoryReport memory_report() const { return ::memory_report(order); }
+
+    // Throws when the graph holds more than memory_budget bytes, naming the largest holders.
+    void check_memory_budget() const
+    {
+        if (memory_budget > 0)
+            enforce_budget(memory_report(), "held");
     }
 
-    Tensor forward() { return root->forward(); }
+    // Each node is evaluated at most once, in topological order, into its preallocated buffer.
+    // Only the downstream cone of leaves whose version changed since the last call (and of
+    // stochastic operators such as dropout) is recomputed; every other operator keeps its
+    // cached value.
+    const Tensor &forward()
+    {
+        wait_for_stream();
+        if (shapes_changed())
+            infer_shapes();
+        recomputed = 0;
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            Node *n = order[i].get();
+            Operator *op = ops[i];
+            if (!op)
+            {
+                dirty[i] = full_recompute || n->version != seen_version[i];
+                seen_version[i] = n->version;
+                continue;
+            }
+            dirty[i] = full_recompute || op->stochastic();
+            for (int32_t in : input_pos[i])
+                dirty[i] = dirty[i] || (in >= 0 && dirty[in]);
+            if (dirty[i])
+            {
+                op->compute();
+                ++recomputed;
+            }
+        }
+        full_recompute = false;
+        check_memory_budget();
+        return root->value;
+    }
 
     void backward()
     {
+        backward_sweep([](size_t) {});
+    }
+
+    // Reverse sweep calling done(i) after order[i] is processed; once the sweep has passed a
+    // leaf's first consumer, that leaf's grad is final (used to overlap gradient communication).
+    template <class F>
+    void backward_sweep(F &&done)
+    {
+        wait_for_stream();
+        require_fp64("Graph::backward");
         // zero grads to shape of each node's value
-        for (auto &kv : nodes)
-            kv.second->grad = Tensor::like(kv.second->value, 0.0);
-        // seed with ones matching root's shape
-        Tensor seed = Tensor::like(root->value, 1.0);
-        root->backward(seed);
+        for (auto &n : order)
+            n->zero_grad();
+        // seed with ones matching root's shape, then sweep consumers before inputs
+        std::fill(root->grad.data.begin(), root->grad.data.end(), 1.0);
+        for (size_t i = order.size(); i-- > 0;)
+        {
+            if (ops[i])
+                ops[i]->vjp();
+            done(i);
+        }
+        check_memory_budget();
+    }
+
+    // The leaf called 'name', for feeding data by name; 'who' prefixes the error when there is
+    // none, when several leaves share the name, or when it is a literal Constant.
+    Node *leaf_named(const std::string &name, const char *who) const
+    {
+        auto it = leaves_by_name.find(name);
+        if (it == leaves_by_name.end())
+            throw std::runtime_error(std::string(who) + ": no leaf named '" + name +
+                                     "' (if it was folded away, build the Graph with optimize=false)");
+        if (!it->second)
+            throw std::runtime_error(std::string(who) + ": several leaves are named '" + name + "'");
+        auto c = dynamic_cast<Constant *>(it->second);
+        if (c && c->literal)
+            throw std::runtime_error(std::string(who) + ": '" + name +
+                                     "' is a literal Constant (its value may be folded into the graph)");
+        return it->second;
+    }
+
+    // Trainable leaves (Variables), in topological order.
+    std::vector<NodePtr> parameters() const
+    {
+        std::vector<NodePtr> out;
+        for (auto &n : order)
+            if (dynamic_cast<Variable *>(n.get()))
+                out.push_back(n);
+        return out;
+    }
+
+    // Run 'steps' iterations of forward -> backward -> optimizer step without leaving C++.
+    // 'feed' maps a leaf name to its batches; step s uses batch s % batches.size().
+    // Returns the (scalar) root value of every step.
+    std::vector<double> train(int64_t steps, Optimizer &opt,
+                              const std::map<std::string, std::vector<Tensor>> &feed = {})
+    {
+        wait_for_stream();
+        std::vector<std::pair<Node *, const std::vector<Tensor> *>> inputs;
+        for (auto &kv : feed)
+        {
+            if (kv.second.empty())
+                throw std::runtime_error("Graph::train: empty feed for '" + kv.first + "'");
+            inputs.emplace_back(leaf_named(kv.first, "Graph::train"), &kv.second);
+        }
+        const auto params = parameters();
+        std::vector<double> losses;
+        losses.reserve(static_cast<size_t>(std::max<int64_t>(steps, 0)));
+        for (int64_t s = 0; s < steps; ++s)
+        {
+            for (auto &in : inputs)
+                in.first->set_value((*in.second)[static_cast<size_t>(s) % in.second->size()]);
+            forward();
+            if (root->value.size() != 1)
+                throw std::runtime_error("Graph::train: root must be scalar");
+            losses.push_back(root->value.data[0]);
+            backward();
+            opt.step(params);
+        }
+        return losses;
+    }
+
+    // Asynchronous execution on this Graph's stream (a worker thread started on first use).
+    // Work runs in submission order, and the synchronous calls above wait for it first. 'feed'
+    // is copied now and written to the leaves when the forward starts, so the caller can
+    // prepare the next batch while this one computes. The future holds a copy of the root value.
+    std::shared_future<Tensor> forward_async(const std::map<std::string, Tensor> &feed = {})
+    {
+        std::vector<std::pair<Node *, Tensor>> inputs;
+        for (auto &kv : feed)
+            inputs.emplace_back(leaf_named(kv.first, "Graph::forward_async"), kv.second);
+        return stream().submit([this, inputs = std::move(inputs)]
+                               {
+            for (auto &in : inputs)
+                in.first->set_value(in.second);
+            return Tensor(forward()); });
+    }
+
+    std::shared_future<void> backward_async()
+    {
+        return stream().submit([this]
+                               { backward(); });
+    }
+
+    // Optimizer step on the parameters, ordered after the backward enqueued before it.
+    std::shared_future<void> step_async(Optimizer &opt)
+    {
+        return stream().submit([this, &opt]
+                               { opt.step(parameters()); });
+    }
+
+    // Block until all enqueued work has run.
+    void synchronize()
+    {
+        if (exec)
+            exec->synchronize();
+    }
+
+    // Forward mode: directional derivative of root along 'tangents' (Variable name -> direction).
+    // Every name must resolve to exactly one Variable; Variables not listed get a zero tangent.
+    // Also refreshes every node's value.
+    Tensor jvp(const std::map<std::string, Tensor> &tangents)
+    {
+        require_fp64("Graph::jvp");
+        std::unordered_map<const Node *, const Tensor *> seeds;
+        for (auto &kv : tangents)
+        {
+            Node *n = leaf_named(kv.first, "Graph::jvp");
+            if (!dynamic_cast<Variable *>(n))
+                throw std::runtime_error("Graph::jvp: '" + kv.first + "' is not a Variable");
+            if (kv.second.shape != n->value.shape)
+                throw std::runtime_error("Graph::jvp: tangent shape mismatch for '" + kv.first + "'");
+            seeds[n] = &kv.second;
+        }
+        forward();
+        for (auto &n : order)
+        {
+            if (std::dynamic_pointer_cast<Operator>(n))
+            {
+                n->jvp();
+                continue;
+            }
+            auto it = seeds.find(n.get());
+            n->tangent = it != seeds.end() ? *it->second : Tensor::like(n->value, 0.0);
+        }
+        check_memory_budget();
+        return root->tangent;
+    }
+
+    // Hessian-vector product H·v of a scalar root w.r.t. all Variables (forward-over-reverse).
+    // Returns Variable name -> (H·v) slice; each Variable's 'grad' holds the gradient afterwards.
+    std::map<std::string, Tensor> hvp(const std::map<std::string, Tensor> &v)
+    {
+        jvp(v);
+        if (root->value.size() != 1)
+            throw std::runtime_error("Graph::hvp: root must be scalar");
+        for (auto &n : order)
+        {
+            n->grad = Tensor::like(n->value, 0.0);
+            n->grad_tangent = Tensor::like(n->value, 0.0);
+        }
+        root->grad = Tensor::like(root->value, 1.0);
+        for (auto it = order.rbegin(); it != order.rend(); ++it)
+            (*it)->backward_dual();
+        check_memory_budget();
+
+        std::map<std::string, Tensor> out;
+        for (auto &n : order)
+            if (std::dynamic_pointer_cast<Variable>(n))
+                out[n->name] = n->grad_tangent;
+        return out;
+    }
+
+    // Dense Jacobian of the root w.r.t. each Variable (or the leaves named in 'wrt'):
+    // J[name] has shape (*root.shape, *leaf.shape). Reverse mode with a block of one-hot seeds
+    // per sweep: every grad carries a leading seed axis and each operator runs one batched VJP
+    // for the whole block. An operator's seed grads and scratch are freed once it has run, so a
+    // sweep holds chunk x (the live frontier) values; 'chunk' caps the seeds per sweep (0 = sized
+    // so a seed block of the widest node is ~512 KB). Overwrites grads.
+    std::map<std::string, Tensor> jacobian(const std::vector<std::string> &wrt = {}, int64_t chunk = 0)
+    {
+        require_fp64("Graph::jacobian");
+        forward();
+        std::vector<Node *> leaves;
+        if (wrt.empty())
+            for (auto &p : parameters())
+                leaves.push_back(p.get());
+        for (auto &name : wrt)
+        {
+            Node *n = leaf_named(name, "Graph::jacobian");
+            if (!dynamic_cast<Variable *>(n))
+                throw std::runtime_error("Graph::jacobian: '" + name + "' is not a Variable");
+            leaves.push_back(n);
+        }
+        const int64_t m = root->value.size();
+        if (chunk <= 0)
+        {
+            // keep one seed block of the largest value near 512 KB so a sweep stays in cache
+            int64_t widest = 1;
+            for (auto &n : order)
+                widest = std::max(widest, n->value.size());
+            chunk = std::max<int64_t>(1, (int64_t(1) << 16) / widest);
+        }
+        chunk = std::min(chunk, m);
+        std::map<std::string, Tensor> out;
+        for (Node *l : leaves)
+        {
+            Shape s = root->value.shape;
+            for (auto d : l->value.shape)
+                s.push_back(d);
+            out[l->name] = Tensor(s, 0.0);
+        }
+        for (int64_t s0 = 0; s0 < m; s0 += chunk)
+        {
+            const int64_t S = std::min(chunk, m - s0);
+            for (auto &n : order)
+                n->seed_grad = Tensor(); // allocated on first use by backward_seeds
+            root->seed_grad = Tensor(Node::seeds_shape(S, root->value.shape), 0.0);
+            for (int64_t r = 0; r < S; ++r)
+                root->seed_grad.data[r * m + s0 + r] = 1.0; // seed r selects root element s0 + r
+            for (size_t i = order.size(); i-- > 0;)
+                if (ops[i] && !ops[i]->seed_grad.data.empty())
+                {
+                    ops[i]->vjp_seeds();
+                    ops[i]->seed_grad = Tensor(); // its inputs have it now
+                    ops[i]->release_seed_scratch();
+                }
+            check_memory_budget();
+            for (Node *l : leaves)
+            {
+                const TensorStorage &g = l->seed_grad.data;
+                std::copy(g.begin(), g.end(), out[l->name].data.begin() + s0 * l->value.size());
+                l->seed_grad = Tensor();
+            }
+        }
+        return out;
+    }
+
+    // Post-training int8 quantization for inference. calibrate() runs an fp64 forward per batch
+    // (leaf name -> value) and widens the activation range seen by every matmul / linear whose
+    // weight is a Variable; quantize() packs those weights to int8 and runs the operators on the
+    // int8 kernels (uncalibrated ones use each batch's own range). Re-run quantize() after the
+    // weights change. Gradients are unavailable while quantized.
+    void calibrate(const std::vector<std::map<std::string, Tensor>> &batches)
+    {
+        wait_for_stream();
+        const bool was = int8;
+        enable_int8(false);
+        const auto qs = quantizable();
+        for (auto &feed : batches)
+        {
+            for (auto &kv : feed)
+                leaf_named(kv.first, "Graph::calibrate")->set_value(kv.second);
+            forward();
+            for (Operator *op : qs)
+                op->quantized_gemm()->observe(op->a->value);
+        }
+        enable_int8(was);
+    }
+
+    void quantize(bool on = true)
+    {
+        wait_for_stream();
+        for (Operator *op : quantizable())
+        {
+            QuantizedGemm &q = *op->quantized_gemm();
+            if (on)
+                ::quantize_weights(op->b->value, q.w);
+            else
+                q.release();
+        }
+        enable_int8(on);
+    }
+
+    bool quantized() const { return int8; }
+
+    // Error of the int8 path against fp64 on each batch, at the root and at every quantized
+    // operator. Leaves the graph in its current mode (with the last batch's leaf values).
+    QuantReport quantization_report(const std::vector<std::map<std::string, Tensor>> &batches)
+    {
+        wait_for_stream();
+        const bool was = int8;
+        if (!was)
+            quantize(true);
+        const auto qs = quantizable();
+        std::vector<Node *> watched(qs.begin(), qs.end());
+        watched.push_back(root.get());
+        std::vector<double> max_abs(watched.size(), 0.0), err2(watched.size(), 0.0), ref2(watched.size(), 0.0);
+        std::vector<Tensor> ref(watched.size());
+        for (auto &feed : batches)
+        {
+            for (auto &kv : feed)
+                leaf_named(kv.first, "Graph::quantization_report")->set_value(kv.second);
+            enable_int8(false);
+            forward();
+            for (size_t k = 0; k < watched.size(); ++k)
+                ref[k] = watched[k]->value;
+            enable_int8(true);
+            forward();
+            for (size_t k = 0; k < watched.size(); ++k)
+                for (int64_t e = 0; e < ref[k].size(); ++e)
+                {
+                    const double r = ref[k].data[e], d = watched[k]->value.data[e] - r;
+                    max_abs[k] = std::max(max_abs[k], std::abs(d));
+                    err2[k] += d * d;
+                    ref2[k] += r * r;
+                }
+        }
+        if (!was)
+            quantize(false);
+        auto error = [&](size_t k)
+        {
+            return QuantError{watched[k]->name, max_abs[k], ref2[k] > 0.0 ? std::sqrt(err2[k] / ref2[k]) : std::sqrt(err2[k])};
+        };
+        QuantReport r;
+        r.quantized_ops = static_cast<int64_t>(qs.size());
+        for (size_t k = 0; k < qs.size(); ++k)
+            r.ops.push_back(error(k));
+        r.root = error(watched.size() - 1);
+        return r;
+    }
+
+private:
+    // matmul / linear operators whose weight input is a Variable.
+    std::vector<Operator *> quantizable() const
+    {
+        std::vector<Operator *> out;
+        for (Operator *op : ops)
+            if (op && op->quantized_gemm() && dynamic_cast<Variable *>(op->b.get()))
+                out.push_back(op);
+        return out;
+    }
+
+    void enable_int8(bool on)
+    {
+        for (Operator *op : quantizable())
+            op->quantized_gemm()->enabled = on;
+        if (on != int8)
+            invalidate();
+        int8 = on;
+    }
+
+    void require_fp64(const char *who) const
+    {
+        if (int8)
+            throw std::runtime_error(std::string(who) + ": the graph is quantized (inference only); call quantize(false) first");
+    }
+
+    // Current holdings with every operator's value and grad grown to its inferred size.
+    MemoryReport planned_memory() const
+    {
+        MemoryReport r;
+        for (auto &n : order)
+        {
+            NodeMemory m = node_memory(*n);
+            if (dynamic_cast<Operator *>(n.get()))
+            {
+                const int64_t elems = n->value.size();
+                const int64_t bytes = // tiny values stay inline
+                    elems > static_cast<int64_t>(TensorStorage::kInline) ? elems * static_cast<int64_t>(sizeof(double)) : 0;
+                m.activations = std::max(m.activations, bytes);
+                m.grads = std::max(m.grads, bytes);
+            }
+            r.add(std::move(m));
+        }
+        return r;
+    }
+
+    void enforce_budget(const MemoryReport &r, const char *when) const
+    {
+        if (r.total() > memory_budget)
+            throw std::runtime_error("Graph: " + std::to_string(r.total()) + " bytes " + when +
+                                     " exceed memory_budget of " + std::to_string(memory_budget) +
+                                     " bytes; largest holders:" + r.largest_summary(5));
+    }
+
+    ExecutionStream &stream()
+    {
+        if (!exec)
+            exec = std::make_unique<ExecutionStream>();
+        return *exec;
     }
+
+    // Synchronous entry points called from outside the stream wait for the work queued on it.
+    void wait_for_stream()
+    {
+        if (exec && !exec->on_stream())
+            exec->synchronize();
+    }
+
+    std::vector<std::array<int32_t, 3>> input_pos;
+    std::vector<Operator *> ops; // order[i] as an Operator, or null for leaves
+    std::unordered_map<std::string, Node *> leaves_by_name; // null when the name is not unique
+    std::vector<char> dirty;
+    std::vector<uint64_t> seen_version;
+    bool full_recompute = true;
+    bool int8 = false; // quantize(true) is in effect
+    std::unique_ptr<ExecutionStream> exec; // last: its worker may still use the members above
 };
@@ -1,5 +1,5 @@
 #pragma once
-#include "Tensor.hpp"
+#include "Kernels_types.hpp"
 
 // Elementwise (supports broadcasting of any inputs, including scalars)
 Tensor ew_add(const Tensor &a, const Tensor &b); // a + b
@@ -10,12 +10,114 @@ Tensor ew_pow(const Tensor &a, const Tensor &b); // a ^ b (elementwise)
 Tensor ew_exp(const Tensor &x);
 Tensor ew_ln(const Tensor &x); // natural log
 Tensor ew_sqrt(const Tensor &x);
+Tensor ew_neg(const Tensor &x);
+Tensor ew_xlogy(const Tensor &x, const Tensor &y); // x * ln(y), 0 where x == 0
+
+// In-place variants: write into 'out', reusing its storage when the shape already matches
+// (no allocation in steady state). 'out' may alias an input that already has the result shape.
+void ew_add_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_sub_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_mul_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_div_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_pow_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_xlogy_into(const Tensor &a, const Tensor &b, Tensor &out);
+void ew_exp_into(const Tensor &x, Tensor &out);
+void ew_ln_into(const Tensor &x, Tensor &out);
+void ew_sqrt_into(const Tensor &x, Tensor &out);
+void ew_affine_into(const Tensor &x, double s, double c, Tensor &out); // s * x + c
+
+// Softmax family along one axis (negative counts from the end); every other axis indexes an
+// independent row. Forward is one online max/sum pass plus one write pass; no temporaries.
+void softmax_into(const Tensor &x, int64_t axis, Tensor &y);
+void log_softmax_into(const Tensor &x, int64_t axis, Tensor &y);
+void logsumexp_into(const Tensor &x, int64_t axis, Tensor &y); // axis kept with size 1
+void softmax_backward_into(const Tensor &y, const Tensor &g, int64_t axis, Tensor &dx);     // y ⊙ (g - Σ g⊙y)
+void log_softmax_backward_into(const Tensor &y, const Tensor &g, int64_t axis, Tensor &dx); // g - exp(y) Σ g
+// dx = g ⊙ exp(x - lse) (g and lse have the axis kept with size 1)
+void logsumexp_backward_into(const Tensor &x, const Tensor &lse, const Tensor &g, int64_t axis, Tensor &dx);
+// Mean over rows of -Σ t ⊙ log_softmax(x); 'logp' receives log_softmax(x) for the backward pass.
+void softmax_cross_entropy_into(const Tensor &x, const Tensor &t, int64_t axis, Tensor &logp, Tensor &loss);
+// dx = scale * (exp(logp) Σ t - t): cross-entropy gradient w.r.t. the logits (Σ t = 1 for
+// probability targets)
+void softmax_cross_entropy_backward_into(const Tensor &logp, const Tensor &t, int64_t axis, double scale, Tensor &dx);
+Tensor sum_axis(const Tensor &x, int64_t axis); // axis kept with size 1
 
 // Linear algebra
 Tensor matmul2d(const Tensor &A, const Tensor &B); // (m,k)@(k,n)->(m,n)
 Tensor dotvec(const Tensor &a, const Tensor &b); // (k,)·(k,)-> scalar
 Tensor cross3(const Tensor &a, const Tensor &b); // (3,)×(3,)->(3,)
+Tensor transpose2d(const Tensor &A);               // (m,n)->(n,m)
+void swap_leading_axes_into(const Tensor &x, Tensor &out); // (a,b,...)->(b,a,...)
+// C = op(A) @ op(B), op = transpose when flagged (no transposed copy is made)
+void matmul2d_into(const Tensor &A, const Tensor &B, Tensor &C, bool trans_a = false, bool trans_b = false);
+void dotvec_into(const Tensor &a, const Tensor &b, Tensor &out);
+
+// Fused dense layer Y = act(X @ W + bias): X (m,k), W (k,n), bias (n,) / (1,n) or null. Bias and
+// activation are applied to each output row as the GEMM finishes it. 'pre' receives
+// X @ W + bias only when the backward needs it (GELU).
+void linear_into(const Tensor &X, const Tensor &W, const Tensor *bias, Activation act, Tensor &Y, Tensor &pre);
+// dZ = G ⊙ act'(·) and, in the same pass, db = column sums of dZ (db may be null; it must
+// already hold n elements, its shape is kept). G may also be seed-batched (S,m,n), without db.
+void linear_backward_into(const Tensor &G, const Tensor &Y, const Tensor &pre, Activation act, Tensor &dZ, Tensor *db);
+// act(z), act'(z) or act''(z) for order 0, 1, 2 (reference path for forward-mode rules)
+Tensor activation_eval(const Tensor &z, Activation act, int order);
+void cross3_into(const Tensor &a, const Tensor &b, Tensor &out);
+
+// int8 inference (post-training quantization, see Graph::quantize). Activations are uint8 with a
+// zero point, weights int8 symmetric per output column; products accumulate exactly in int32.
+void quantize_into(const Tensor &X, const QuantParams &qp, QActivations &q); // X (m,k), saturating
+void quantize_weights(const Tensor &W, QWeights &q);                          // W (k,n) -> packed (n,k)
+// Y = act(X @ W + bias) from the int8 GEMM: the epilogue removes the zero point and applies the
+// scales, bias and activation to each output row (fp64 out). Needs k <= 65536.
+void qlinear_into(const QActivations &X, const QWeights &W, const Tensor *bias, Activation act, Tensor &Y);
+
+// 2D convolution over NCHW input (N,C,H,W) with weight (F, C/groups, KH, KW) -> (N,F,OH,OW).
+// Lowered to im2col + GEMM per (image, group); 'ws' is the reusable column buffer.
+Shape conv2d_shape(const Shape &x, const Shape &w, const Conv2dParams &p); // validates, returns (N,F,OH,OW)
+Tensor conv2d_nchw(const Tensor &X, const Tensor &W, const Conv2dParams &p);
+void conv2d_into(const Tensor &X, const Tensor &W, const Conv2dParams &p, Tensor &Y, TensorStorage &ws);
+void conv2d_grad_input_into(const Tensor &G, const Tensor &W, const Shape &x_shape,
+                            const Conv2dParams &p, Tensor &dX, TensorStorage &ws);
+// dW is overwritten (not accumulated)
+void conv2d_grad_weight_into(const Tensor &G, const Tensor &X, const Shape &w_shape,
+                             const Conv2dParams &p, Tensor &dW, TensorStorage &ws);
+
+// Sparse (CSR) x dense
+Tensor spmm(const CsrTensor &A, const Tensor &B);   // (m,k)csr @ (k,n)->(m,n)
+Tensor spmm_t(const CsrTensor &A, const Tensor &G); // (m,k)csr^T @ (m,n)->(k,n)
+// (G @ B^T) sampled at A's nonzeros: values of the sparsity-preserving gradient of A
+std::vector<double> sddmm(const CsrTensor &A, const Tensor &G, const Tensor &B);
+void spmm_into(const CsrTensor &A, const Tensor &B, Tensor &C);
+void spmm_t_into(const CsrTensor &A, const Tensor &G, Tensor &C);
+void sddmm_add_into(const CsrTensor &A, const Tensor &G, const Tensor &B, std::vector<double> &acc);
+
+// Counter-based random numbers (Philox4x32-10; seeds and offsets come from a Generator, see
+// Random.hpp). Element e uses block offset + e / 2 (offset + e / 4 for dropout), so results do
+// not depend on the thread count. Fills keep t's shape.
+void fill_uniform(Tensor &t, uint64_t seed, uint64_t offset, double lo, double hi); // [lo, hi)
+void fill_normal(Tensor &t, uint64_t seed, uint64_t offset, double mean, double std);
+// y = x ⊙ mask / (1 - p), each element dropped with probability p. The mask is a function of
+// (seed, offset) only: applying the same call to the upstream grad is the backward.
+void dropout_into(const Tensor &x, double p, uint64_t seed, uint64_t offset, Tensor &y);
+
+// Optimizer updates: in place, one fused pass per element, every slice in one parallel launch.
+void sgd_update(const std::vector<ParamSlice> &ps, double lr, double weight_decay);
+void momentum_update(const std::vector<ParamSlice> &ps, double lr, double mu,
+                     double weight_decay, bool nesterov);
+// decoupled=false: L2 penalty folded into g (Adam) ; decoupled=true: w -= lr*wd*w (AdamW)
+void adam_update(const std::vector<ParamSlice> &ps, double lr, double beta1, double beta2,
+                 double eps, double weight_decay, bool decoupled, int64_t t);
 
 // Reduction helper (for gradients of broadcasted inputs)
 // Reduces 'src' to 'target_shape' by summing over broadcasted axes.
-Tensor reduce_to_shape(const Tensor &src, const std::vector<int64_t> &target_shape);
+Tensor reduce_to_shape(const Tensor &src, const Shape &target_shape);
+// dst += src summed over the axes along which dst was broadcast (no allocation).
+void reduce_add_into(const Tensor &src, Tensor &dst);
+
+// Runtime ISA dispatch. Builds with Kernels_dispatch.cpp carry one copy of every kernel per
+// ISA and pick, per kernel, the best one this CPU runs when first used (the Python module does
+// so at import). ELHAMMATH_KERNEL_ISA overrides the choice for testing: "avx2" forces every
+// kernel, "baseline,matmul2d_into=avx512" sets a default plus per-kernel exceptions.
+// Single-variant builds (Kernels_cpu.cpp alone) report "default".
+const char *kernel_isa(const std::string &kernel = ""); // variant used by 'kernel' (or the default)
+std::vector<std::string> kernel_isas();                 // variants this build can run on this CPU
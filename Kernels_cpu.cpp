@@ -1,139 +1,1088 @@
-#include "Kernels.hpp"
 #include <cmath>
+#include <utility>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+// Built either alone (the kernels are the global API declared in Kernels.hpp) or once per ISA
+// with KERNEL_ISA_BASELINE / _AVX2 / _AVX512 defined, for Kernels_dispatch.cpp. A variant build
+// puts every definition below in its own namespace and compiles it for that target with a
+// pragma rather than -m flags, so inline code from the headers stays baseline (the linker may
+// keep any one copy of it).
+#if defined(KERNEL_ISA_BASELINE) || defined(KERNEL_ISA_AVX2) || defined(KERNEL_ISA_AVX512)
+#define KERNEL_VARIANT
+#include "Kernels_types.hpp"
+#if defined(KERNEL_ISA_AVX2) || defined(KERNEL_ISA_AVX512)
+#include <immintrin.h> // int8 dot products (the only hand-written intrinsics)
+#endif
+#if defined(KERNEL_ISA_AVX2)
+#define KERNEL_NS kernels_avx2
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+#endif
+#elif defined(KERNEL_ISA_AVX512)
+#define KERNEL_NS kernels_avx512
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512dq,avx512vl,avx512bw,avx2,fma"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512dq,avx512vl,avx512bw,avx2,fma")
+#endif
+#else
+#define KERNEL_NS kernels_baseline
+#endif
+namespace KERNEL_NS
+{
+#define KERNEL(R, name, params, args) R name params;
+#include "Kernels_list.hpp"
+#undef KERNEL
+#else
+#include "Kernels.hpp"
+#endif
+
+// Broadcast geometry of a binary op, kept on the stack so steady-state kernels never allocate.
+struct BroadcastPlan
+{
+    static constexpr int kMaxRank = static_cast<int>(Shape::kMaxRank);
+    int rank = 0;
+    int64_t dims[kMaxRank];
+    int64_t sa[kMaxRank], sb[kMaxRank]; // aligned input strides (0 on broadcast axes)
+    int64_t size = 1;
+};
+
+static void plan_broadcast(const Tensor &A, const Tensor &B, BroadcastPlan &p, const char *name)
+{
+    const int na = int(A.shape.size()), nb = int(B.shape.size());
+    p.rank = std::max(na, nb);
+    if (p.rank > BroadcastPlan::kMaxRank)
+        throw std::runtime_error(std::string(name) + ": rank > 8 not supported");
+    p.size = 1;
+    for (int i = 0; i < p.rank; ++i)
+    {
+        const int ia = i - (p.rank - na), ib = i - (p.rank - nb);
+        const int64_t da = ia < 0 ? 1 : A.shape[ia], db = ib < 0 ? 1 : B.shape[ib];
+        if (!(da == db || da == 1 || db == 1))
+            throw std::runtime_error(std::string(name) + ": incompatible broadcast shapes");
+        p.dims[i] = std::max(da, db);
+        p.sa[i] = (ia < 0 || da == 1) ? 0 : A.strides[ia];
+        p.sb[i] = (ib < 0 || db == 1) ? 0 : B.strides[ib];
+        p.size *= p.dims[i];
+    }
+}
 
-static Tensor binary_ew_impl(const Tensor &A, const Tensor &B,
-                             double (*op)(double, double), const char *name)
+// Give 'out' the requested shape, reusing its storage when it already matches.
+static void set_shape(Tensor &out, const int64_t *dims, int rank)
 {
-    // Output shape via broadcasting
-    auto out_shape = broadcast_shape(A.shape, B.shape);
-    Tensor out(out_shape);
+    bool same = int(out.shape.size()) == rank;
+    for (int i = 0; same && i < rank; ++i)
+        same = out.shape[i] == dims[i];
+    if (!same)
+    {
+        out.shape.assign(dims, dims + rank);
+        out.recompute_strides();
+    }
+    out.data.resize(static_cast<size_t>(out.size()));
+}
 
-    // Aligned strides for inputs
-    auto a_as = align_strides_for_broadcast(A.shape, A.strides, out_shape);
-    auto b_as = align_strides_for_broadcast(B.shape, B.strides, out_shape);
+// 'out' may alias an input whose shape already equals the result shape.
+template <class F>
+static void binary_ew_into(const Tensor &A, const Tensor &B, Tensor &out, F op, const char *name)
+{
+    if (A.shape.empty() && B.shape.empty())
+    {
+        // scalars: skip the broadcast plan and the parallel region entirely
+        set_shape(out, nullptr, 0);
+        out.data[0] = op(A.data[0], B.data[0]);
+        return;
+    }
+    if (A.shape == B.shape)
+    {
+        set_shape(out, A.shape.data(), int(A.shape.size()));
+        const int64_t N = out.size();
+        const double *a = A.data.data(), *b = B.data.data();
+        double *o = out.data.data();
+#if defined(_OPENMP)
+#pragma omp parallel for simd if (N > 32768)
+#endif
+        for (int64_t i = 0; i < N; ++i)
+            o[i] = op(a[i], b[i]);
+        return;
+    }
 
-    const int64_t N = out.size();
+    BroadcastPlan p;
+    plan_broadcast(A, B, p, name);
+    set_shape(out, p.dims, p.rank);
+    // rows over all but the innermost axis; the inner run has a fixed stride per input
+    const int64_t inner = p.rank ? p.dims[p.rank - 1] : 1;
+    const int64_t ia = p.rank ? p.sa[p.rank - 1] : 0, ib = p.rank ? p.sb[p.rank - 1] : 0;
+    const int64_t rows = p.size / inner;
+    const double *a = A.data.data(), *b = B.data.data();
+    double *o = out.data.data();
 #if defined(_OPENMP)
-#pragma omp parallel for
+#pragma omp parallel for if (p.size > 32768)
 #endif
-    for (int64_t idx = 0; idx < N; ++idx)
+    for (int64_t r = 0; r < rows; ++r)
     {
-        const int64_t ao = offset_from_linear(idx, out_shape, a_as);
-        const int64_t bo = offset_from_linear(idx, out_shape, b_as);
-        out.data[idx] = op(A.data[ao], B.data[bo]);
+        int64_t rem = r, ao = 0, bo = 0;
+        for (int d = p.rank - 2; d >= 0; --d)
+        {
+            const int64_t c = rem % p.dims[d];
+            rem /= p.dims[d];
+            ao += c * p.sa[d];
+            bo += c * p.sb[d];
+        }
+        double *orow = o + r * inner;
+        if (ia == 1 && ib == 1)
+        {
+            // both runs contiguous (e.g. a (S, n) seed block against an (n,) value)
+            const double *arow = a + ao, *brow = b + bo;
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+            for (int64_t j = 0; j < inner; ++j)
+                orow[j] = op(arow[j], brow[j]);
+        }
+        else
+            for (int64_t j = 0; j < inner; ++j)
+                orow[j] = op(a[ao + j * ia], b[bo + j * ib]);
     }
-    return out;
 }
 
-static Tensor unary_ew_impl(const Tensor &X, double (*op)(double), const char *name)
+template <class F>
+static void unary_ew_into(const Tensor &X, Tensor &out, F op, const char *)
 {
-    Tensor out(X.shape);
+    if (X.shape.empty())
+    {
+        set_shape(out, nullptr, 0);
+        out.data[0] = op(X.data[0]);
+        return;
+    }
+    set_shape(out, X.shape.data(), int(X.shape.size()));
     const int64_t N = X.size();
+    const double *x = X.data.data();
+    double *o = out.data.data();
 #if defined(_OPENMP)
-#pragma omp parallel for
+#pragma omp parallel for simd if (N > 32768)
 #endif
     for (int64_t i = 0; i < N; ++i)
-        out.data[i] = op(X.data[i]);
-    return out;
+        o[i] = op(x[i]);
 }
 
 // ---- elementwise ----
+void ew_add_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return x + y; }, "add");
+}
+void ew_sub_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return x - y; }, "sub");
+}
+void ew_mul_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return x * y; }, "mul");
+}
+void ew_div_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return x / y; }, "div");
+}
+void ew_pow_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return std::pow(x, y); }, "pow");
+}
+void ew_xlogy_into(const Tensor &a, const Tensor &b, Tensor &out)
+{
+    // keeps 0 * ln(0) and 0 * ln(<0) at 0 (needed by tangents of a^b with constant b)
+    binary_ew_into(a, b, out, [](double x, double y)
+                   { return x == 0.0 ? 0.0 : x * std::log(y); }, "xlogy");
+}
+void ew_exp_into(const Tensor &x, Tensor &out)
+{
+    unary_ew_into(x, out, [](double v)
+                  { return std::exp(v); }, "exp");
+}
+void ew_ln_into(const Tensor &x, Tensor &out)
+{
+    unary_ew_into(x, out, [](double v)
+                  { return std::log(v); }, "ln");
+}
+void ew_sqrt_into(const Tensor &x, Tensor &out)
+{
+    unary_ew_into(x, out, [](double v)
+                  { return std::sqrt(v); }, "sqrt");
+}
+void ew_affine_into(const Tensor &x, double s, double c, Tensor &out)
+{
+    unary_ew_into(x, out, [s, c](double v)
+                  { return s * v + c; }, "affine");
+}
+
 Tensor ew_add(const Tensor &a, const Tensor &b)
 {
-    return binary_ew_impl(a, b, [](double x, double y)
-                          { return x + y; }, "add");
+    Tensor out;
+    ew_add_into(a, b, out);
+    return out;
 }
 Tensor ew_sub(const Tensor &a, const Tensor &b)
 {
-    return binary_ew_impl(a, b, [](double x, double y)
-                          { return x - y; }, "sub");
+    Tensor out;
+    ew_sub_into(a, b, out);
+    return out;
 }
 Tensor ew_mul(const Tensor &a, const Tensor &b)
 {
-    return binary_ew_impl(a, b, [](double x, double y)
-                          { return x * y; }, "mul");
+    Tensor out;
+    ew_mul_into(a, b, out);
+    return out;
 }
 Tensor ew_div(const Tensor &a, const Tensor &b)
 {
-    return binary_ew_impl(a, b, [](double x, double y)
-                          { return x / y; }, "div");
+    Tensor out;
+    ew_div_into(a, b, out);
+    return out;
 }
 Tensor ew_pow(const Tensor &a, const Tensor &b)
 {
-    return binary_ew_impl(a, b, [](double x, double y)
-                          { return std::pow(x, y); }, "pow");
+    Tensor out;
+    ew_pow_into(a, b, out);
+    return out;
 }
 Tensor ew_exp(const Tensor &x)
 {
-    return unary_ew_impl(x, [](double v)
-                         { return std::exp(v); }, "exp");
+    Tensor out;
+    ew_exp_into(x, out);
+    return out;
 }
 Tensor ew_ln(const Tensor &x)
 {
-    return unary_ew_impl(x, [](double v)
-                         { return std::log(v); }, "ln");
+    Tensor out;
+    ew_ln_into(x, out);
+    return out;
 }
 Tensor ew_sqrt(const Tensor &x)
 {
-    return unary_ew_impl(x, [](double v)
-                         { return std::sqrt(v); }, "sqrt");
+    Tensor out;
+    ew_sqrt_into(x, out);
+    return out;
+}
+Tensor ew_neg(const Tensor &x)
+{
+    Tensor out;
+    ew_affine_into(x, -1.0, 0.0, out);
+    return out;
+}
+Tensor ew_xlogy(const Tensor &a, const Tensor &b)
+{
+    Tensor out;
+    ew_xlogy_into(a, b, out);
+    return out;
 }
 
 // ---- reductions for broadcasted grads ----
-Tensor reduce_to_shape(const Tensor &src, const std::vector<int64_t> &target_shape)
+void reduce_add_into(const Tensor &src, Tensor &dst)
+{
+    const int64_t N = src.size();
+    if (N == 1 && dst.size() == 1)
+    {
+        dst.data[0] += src.data[0];
+        return;
+    }
+    if (src.shape == dst.shape)
+    {
+        double *d = dst.data.data();
+        const double *s = src.data.data();
+#if defined(_OPENMP)
+#pragma omp parallel for simd if (N > 32768)
+#endif
+        for (int64_t i = 0; i < N; ++i)
+            d[i] += s[i];
+        return;
+    }
+    if (dst.size() == 1 && dst.shape.size() <= src.shape.size())
+    {
+        // a single-element target broadcasts to anything of at least its rank: sum it all
+        double acc = 0.0;
+#if defined(_OPENMP)
+#pragma omp parallel for reduction(+ : acc) if (N > 32768)
+#endif
+        for (int64_t i = 0; i < N; ++i)
+            acc += src.data[i];
+        dst.data[0] += acc;
+        return;
+    }
+    // General case: dst's aligned strides are 0 on broadcast axes (serial: rows collide)
+    BroadcastPlan p;
+    plan_broadcast(src, dst, p, "reduce_to_shape");
+    if (p.size != N)
+        throw std::runtime_error("reduce_to_shape: target does not broadcast to source");
+    const int64_t inner = p.rank ? p.dims[p.rank - 1] : 1;
+    const int64_t id = p.rank ? p.sb[p.rank - 1] : 0;
+    for (int64_t r = 0; r < N / inner; ++r)
+    {
+        int64_t rem = r, off = 0;
+        for (int d = p.rank - 2; d >= 0; --d)
+        {
+            off += (rem % p.dims[d]) * p.sb[d];
+            rem /= p.dims[d];
+        }
+        const double *s = src.data.data() + r * inner;
+        for (int64_t j = 0; j < inner; ++j)
+            dst.data[off + j * id] += s[j];
+    }
+}
+
+Tensor reduce_to_shape(const Tensor &src, const Shape &target_shape)
 {
     // Fast path: already same shape
     if (src.shape == target_shape)
         return src;
 
     Tensor out(target_shape, 0.0);
-    // Align target strides against src shape (for offset calc)
-    auto t_as = align_strides_for_broadcast(target_shape,
-                                            contiguous_strides_for(target_shape),
-                                            src.shape);
-    const int64_t N = src.size();
-    // NOTE: reduction uses atomic adds to avoid race (ok for medium sizes)
+    reduce_add_into(src, out);
+    return out;
+}
+
+// ---- softmax family ----
+// x viewed as (outer, n, inner) around 'axis'; a row is n elements 'inner' apart.
+struct AxisGeom
+{
+    int64_t outer = 1, n = 1, inner = 1;
+    int64_t rows() const { return outer * inner; }
+    int64_t base(int64_t r) const { return (r / inner) * n * inner + r % inner; }
+};
+
+static AxisGeom axis_geom(const Shape &shape, int64_t &axis, const char *name)
+{
+    axis = normalize_axis(axis, shape.size(), name);
+    const int64_t rank = static_cast<int64_t>(shape.size());
+    AxisGeom g;
+    for (int64_t i = 0; i < rank; ++i)
+        (i < axis ? g.outer : i == axis ? g.n : g.inner) *= shape[i];
+    return g;
+}
+
+// One pass: running max m and Σ exp(x - m), rescaled whenever the max grows.
+static inline void online_max_sum(const double *x, int64_t n, int64_t st, double &m, double &s)
+{
+    m = -INFINITY;
+    s = 0.0;
+    for (int64_t i = 0; i < n; ++i)
+    {
+        const double v = x[i * st];
+        if (v > m)
+        {
+            s = s * std::exp(m - v) + 1.0;
+            m = v;
+        }
+        else if (m != -INFINITY) // masked (-inf) entries before any finite one add nothing
+            s += std::exp(v - m);
+    }
+}
+
+template <class F>
+static void for_each_row(const AxisGeom &g, F f)
+{
+    const int64_t rows = g.rows();
 #if defined(_OPENMP)
-#pragma omp parallel for
+#pragma omp parallel for if (rows * g.n > 32768)
 #endif
-    for (int64_t idx = 0; idx < N; ++idx)
-    {
-        const int64_t to = offset_from_linear(idx, src.shape, t_as);
+    for (int64_t r = 0; r < rows; ++r)
+        f(r, g.base(r));
+}
+
+void softmax_into(const Tensor &x, int64_t axis, Tensor &y)
+{
+    const AxisGeom g = axis_geom(x.shape, axis, "softmax");
+    set_shape(y, x.shape.data(), int(x.shape.size()));
+    const double *xd = x.data.data();
+    double *yd = y.data.data();
+    for_each_row(g, [&](int64_t, int64_t b)
+                 {
+        double m, s;
+        online_max_sum(xd + b, g.n, g.inner, m, s);
+        const double inv = 1.0 / s;
+        for (int64_t i = 0; i < g.n; ++i)
+            yd[b + i * g.inner] = std::exp(xd[b + i * g.inner] - m) * inv; });
+}
+
+void log_softmax_into(const Tensor &x, int64_t axis, Tensor &y)
+{
+    const AxisGeom g = axis_geom(x.shape, axis, "log_softmax");
+    set_shape(y, x.shape.data(), int(x.shape.size()));
+    const double *xd = x.data.data();
+    double *yd = y.data.data();
+    for_each_row(g, [&](int64_t, int64_t b)
+                 {
+        double m, s;
+        online_max_sum(xd + b, g.n, g.inner, m, s);
+        const double lse = m + std::log(s);
+        for (int64_t i = 0; i < g.n; ++i)
+            yd[b + i * g.inner] = xd[b + i * g.inner] - lse; });
+}
+
+void logsumexp_into(const Tensor &x, int64_t axis, Tensor &y)
+{
+    const AxisGeom g = axis_geom(x.shape, axis, "logsumexp");
+    const int rank = int(x.shape.size());
+    if (rank > BroadcastPlan::kMaxRank)
+        throw std::runtime_error("logsumexp: rank > 8 not supported");
+    int64_t dims[BroadcastPlan::kMaxRank];
+    for (int i = 0; i < rank; ++i)
+        dims[i] = i == axis ? 1 : x.shape[i];
+    set_shape(y, dims, rank);
+    const double *xd = x.data.data();
+    double *yd = y.data.data();
+    for_each_row(g, [&](int64_t r, int64_t b)
+                 {
+        double m, s;
+        online_max_sum(xd + b, g.n, g.inner, m, s);
+        yd[r] = m + std::log(s); });
+}
+
+static void require_same_shape(const Tensor &a, const Tensor &b, const char *name)
+{
+    if (a.shape != b.shape)
+        throw std::runtime_error(std::string(name) + ": shape mismatch");
+}
+
+void softmax_backward_into(const Tensor &y, const Tensor &gr, int64_t axis, Tensor &dx)
+{
+    const AxisGeom g = axis_geom(y.shape, axis, "softmax_backward");
+    require_same_shape(y, gr, "softmax_backward");
+    set_shape(dx, y.shape.data(), int(y.shape.size()));
+    const double *yd = y.data.data(), *gd = gr.data.data();
+    double *dd = dx.data.data();
+    for_each_row(g, [&](int64_t, int64_t b)
+                 {
+        double dot = 0.0;
+        for (int64_t i = 0; i < g.n; ++i)
+            dot += gd[b + i * g.inner] * yd[b + i * g.inner];
+        for (int64_t i = 0; i < g.n; ++i)
+        {
+            const int64_t k = b + i * g.inner;
+            dd[k] = yd[k] * (gd[k] - dot);
+        } });
+}
+
+void log_softmax_backward_into(const Tensor &y, const Tensor &gr, int64_t axis, Tensor &dx)
+{
+    const AxisGeom g = axis_geom(y.shape, axis, "log_softmax_backward");
+    require_same_shape(y, gr, "log_softmax_backward");
+    set_shape(dx, y.shape.data(), int(y.shape.size()));
+    const double *yd = y.data.data(), *gd = gr.data.data();
+    double *dd = dx.data.data();
+    for_each_row(g, [&](int64_t, int64_t b)
+                 {
+        double sum = 0.0;
+        for (int64_t i = 0; i < g.n; ++i)
+            sum += gd[b + i * g.inner];
+        for (int64_t i = 0; i < g.n; ++i)
+        {
+            const int64_t k = b + i * g.inner;
+            dd[k] = gd[k] - std::exp(yd[k]) * sum;
+        } });
+}
+
+void logsumexp_backward_into(const Tensor &x, const Tensor &lse, const Tensor &gr, int64_t axis, Tensor &dx)
+{
+    const AxisGeom g = axis_geom(x.shape, axis, "logsumexp_backward");
+    if (lse.size() != g.rows() || gr.size() != g.rows())
+        throw std::runtime_error("logsumexp_backward: reduced shapes mismatch");
+    set_shape(dx, x.shape.data(), int(x.shape.size()));
+    const double *xd = x.data.data(), *ld = lse.data.data(), *gd = gr.data.data();
+    double *dd = dx.data.data();
+    for_each_row(g, [&](int64_t r, int64_t b)
+                 {
+        for (int64_t i = 0; i < g.n; ++i)
+        {
+            const int64_t k = b + i * g.inner;
+            dd[k] = gd[r] * std::exp(xd[k] - ld[r]);
+        } });
+}
+
+void softmax_cross_entropy_into(const Tensor &x, const Tensor &t, int64_t axis, Tensor &logp, Tensor &loss)
+{
+    require_same_shape(x, t, "softmax_cross_entropy");
+    const AxisGeom g = axis_geom(x.shape, axis, "softmax_cross_entropy");
+    set_shape(logp, x.shape.data(), int(x.shape.size()));
+    const double *xd = x.data.data(), *td = t.data.data();
+    double *lp = logp.data.data();
+    const int64_t rows = g.rows();
+    double total = 0.0;
 #if defined(_OPENMP)
-#pragma omp atomic
+#pragma omp parallel for reduction(+ : total) if (rows * g.n > 32768)
 #endif
-        out.data[to] += src.data[idx];
+    for (int64_t r = 0; r < rows; ++r)
+    {
+        const int64_t b = g.base(r);
+        double m, s;
+        online_max_sum(xd + b, g.n, g.inner, m, s);
+        const double lse = m + std::log(s);
+        for (int64_t i = 0; i < g.n; ++i)
+        {
+            const int64_t k = b + i * g.inner;
+            lp[k] = xd[k] - lse;
+            if (td[k] != 0.0)
+                total -= td[k] * lp[k];
+        }
+    }
+    set_shape(loss, nullptr, 0);
+    loss.data[0] = total / static_cast<double>(rows);
+}
+
+void softmax_cross_entropy_backward_into(const Tensor &logp, const Tensor &t, int64_t axis, double scale, Tensor &dx)
+{
+    require_same_shape(logp, t, "softmax_cross_entropy_backward");
+    const AxisGeom g = axis_geom(logp.shape, axis, "softmax_cross_entropy_backward");
+    set_shape(dx, logp.shape.data(), int(logp.shape.size()));
+    const double *lp = logp.data.data(), *td = t.data.data();
+    double *dd = dx.data.data();
+    for_each_row(g, [&](int64_t, int64_t b)
+                 {
+        double tsum = 0.0;
+        for (int64_t i = 0; i < g.n; ++i)
+            tsum += td[b + i * g.inner];
+        for (int64_t i = 0; i < g.n; ++i)
+        {
+            const int64_t k = b + i * g.inner;
+            dd[k] = scale * (std::exp(lp[k]) * tsum - td[k]);
+        } });
+}
+
+Tensor sum_axis(const Tensor &x, int64_t axis)
+{
+    const AxisGeom g = axis_geom(x.shape, axis, "sum_axis");
+    Shape shape = x.shape;
+    shape[axis] = 1;
+    Tensor out(shape, 0.0);
+    for (int64_t r = 0; r < g.rows(); ++r)
+    {
+        const int64_t b = g.base(r);
+        double acc = 0.0;
+        for (int64_t i = 0; i < g.n; ++i)
+            acc += x.data[b + i * g.inner];
+        out.data[r] = acc;
     }
     return out;
 }
 
 // ---- matmul (2D) ----
-Tensor matmul2d(const Tensor &A, const Tensor &B)
+struct NoEpilogue
 {
-    require_matmul_shapes_2d(A, B, "matmul");
-    const int64_t m = A.shape[0], k = A.shape[1], n = B.shape[1];
-    Tensor C({m, n}, 0.0);
+    void operator()(int64_t, double *) const {}
+};
+
+// Blocked GEMM over KC x NC panels of op(B) (sized to stay in L2), each reused by all rows of
+// C. Panels of a transposed B are packed so the inner loop is unit-stride; rows that are
+// already contiguous (bs1 == 1) are read in place.
+constexpr int64_t GEMM_KC = 256, GEMM_NC = 128;
+
+// crow_r[0..nc) += a_r(p) * panel[p][0..nc) for R rows at once: each panel row is loaded once
+// for all R rows of C. a_r(p) = a[r * as0 + p * as1]; panel rows are ldp apart.
+template <int R>
+static inline void gemm_panel_rows(int64_t kc, int64_t nc, const double *a, int64_t as0, int64_t as1,
+                                   const double *panel, int64_t ldp, double *c, int64_t ldc)
+{
+    for (int64_t p = 0; p < kc; ++p)
+    {
+        double ap[R];
+        for (int r = 0; r < R; ++r)
+            ap[r] = a[r * as0 + p * as1];
+        const double *brow = panel + p * ldp;
+        for (int r = 0; r < R; ++r)
+        {
+            double *crow = c + r * ldc;
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+            for (int64_t j = 0; j < nc; ++j)
+                crow[j] += ap[r] * brow[j];
+        }
+    }
+}
+
+// C (m,n; row stride ldc) = or += op(A) @ op(B), where op(X)[i][j] = x[i * s0 + j * s1].
+// epi(i, crow) runs on each finished row of C while it is still in cache.
+template <class Epilogue = NoEpilogue>
+static void gemm_strided(int64_t m, int64_t n, int64_t k,
+                         const double *a, int64_t as0, int64_t as1,
+                         const double *b, int64_t bs0, int64_t bs1,
+                         double *c, int64_t ldc, bool accumulate, Epilogue epi = {})
+{
+    if (m >= 4 && n > 1)
+    {
+        // one panel buffer per calling thread (graphs may run on several threads at once)
+        thread_local std::vector<double> panel;
+        if (bs1 != 1)
+            panel.resize(static_cast<size_t>(GEMM_KC * GEMM_NC));
+        for (int64_t j0 = 0; j0 < n; j0 += GEMM_NC)
+        {
+            const int64_t nc = std::min(GEMM_NC, n - j0);
+            for (int64_t p0 = 0; p0 < k; p0 += GEMM_KC)
+            {
+                const int64_t kc = std::min(GEMM_KC, k - p0);
+                // rows of op(B) that are already contiguous are used in place
+                const double *bsrc = b + p0 * bs0 + j0 * bs1, *bp = bsrc;
+                int64_t ldp = bs0;
+                if (bs1 != 1)
+                {
+                    // read along p, B's contiguous axis when it is transposed
+                    for (int64_t j = 0; j < nc; ++j)
+                        for (int64_t p = 0; p < kc; ++p)
+                            panel[p * nc + j] = bsrc[p * bs0 + j * bs1];
+                    bp = panel.data();
+                    ldp = nc;
+                }
+                const bool first = p0 == 0 && !accumulate;
+                const bool last = p0 + kc == k && j0 + nc == n; // the rows of C are complete
+                const int64_t blocks = (m + 3) / 4;
+#if defined(_OPENMP)
+#pragma omp parallel for if (m * n * k > 32768)
+#endif
+                for (int64_t blk = 0; blk < blocks; ++blk)
+                {
+                    const int64_t i0 = blk * 4, rows = std::min<int64_t>(4, m - i0);
+                    double *cblk = c + i0 * ldc + j0;
+                    if (first)
+                        for (int64_t r = 0; r < rows; ++r)
+                            std::fill(cblk + r * ldc, cblk + r * ldc + nc, 0.0);
+                    const double *ablk = a + i0 * as0 + p0 * as1;
+                    if (rows == 4)
+                        gemm_panel_rows<4>(kc, nc, ablk, as0, as1, bp, ldp, cblk, ldc);
+                    else
+                        for (int64_t r = 0; r < rows; ++r)
+                            gemm_panel_rows<1>(kc, nc, ablk + r * as0, as0, as1, bp, ldp, cblk + r * ldc, ldc);
+                    if (last)
+                        for (int64_t r = 0; r < rows; ++r)
+                            epi(i0 + r, c + (i0 + r) * ldc);
+                }
+            }
+        }
+        return;
+    }
+
+    // op(B) with contiguous rows that stays in cache unpacked, or a single row / column of C
+    const bool rows_of_b = bs0 != 1 || (bs1 == 1 && n > 1);
 #if defined(_OPENMP)
-#pragma omp parallel for collapse(2)
+#pragma omp parallel for if (m * n * k > 32768)
 #endif
     for (int64_t i = 0; i < m; ++i)
     {
-        for (int64_t j = 0; j < n; ++j)
+        double *crow = c + i * ldc;
+        if (rows_of_b)
         {
-            double acc = 0.0;
+            // i-p-j order: the inner loop streams a row of op(B) into a row of C
+            if (!accumulate)
+                for (int64_t j = 0; j < n; ++j)
+                    crow[j] = 0.0;
             for (int64_t p = 0; p < k; ++p)
             {
-                acc += A.data[i * A.strides[0] + p * A.strides[1]] *
-                       B.data[p * B.strides[0] + j * B.strides[1]];
+                const double aip = a[i * as0 + p * as1];
+                const double *brow = b + p * bs0;
+                if (bs1 == 1)
+                    for (int64_t j = 0; j < n; ++j)
+                        crow[j] += aip * brow[j];
+                else
+                    for (int64_t j = 0; j < n; ++j)
+                        crow[j] += aip * brow[j * bs1];
             }
-            C.data[i * C.strides[0] + j * C.strides[1]] = acc;
         }
+        else
+        {
+            // op(B) is a transposed row-major matrix: contiguous dot products along p
+            for (int64_t j = 0; j < n; ++j)
+            {
+                const double *bcol = b + j * bs1;
+                double acc = 0.0;
+                for (int64_t p = 0; p < k; ++p)
+                    acc += a[i * as0 + p * as1] * bcol[p];
+                crow[j] = accumulate ? crow[j] + acc : acc;
+            }
+        }
+        epi(i, crow);
     }
+}
+
+void matmul2d_into(const Tensor &A, const Tensor &B, Tensor &C, bool trans_a, bool trans_b)
+{
+    if (A.shape.size() != 2 || B.shape.size() != 2)
+        throw std::runtime_error("matmul: need 2D matrices");
+    // transposing just swaps the strides
+    const int64_t m = trans_a ? A.shape[1] : A.shape[0], k = trans_a ? A.shape[0] : A.shape[1];
+    const int64_t kb = trans_b ? B.shape[1] : B.shape[0], n = trans_b ? B.shape[0] : B.shape[1];
+    if (k != kb)
+        throw std::runtime_error("matmul: inner dims mismatch");
+    const int64_t as0 = trans_a ? A.strides[1] : A.strides[0], as1 = trans_a ? A.strides[0] : A.strides[1];
+    const int64_t bs0 = trans_b ? B.strides[1] : B.strides[0], bs1 = trans_b ? B.strides[0] : B.strides[1];
+    const int64_t dims[2] = {m, n};
+    set_shape(C, dims, 2);
+    gemm_strided(m, n, k, A.data.data(), as0, as1, B.data.data(), bs0, bs1, C.data.data(), n, false);
+}
+
+Tensor matmul2d(const Tensor &A, const Tensor &B)
+{
+    require_matmul_shapes_2d(A, B, "matmul");
+    Tensor C;
+    matmul2d_into(A, B, C, false, false);
     return C;
 }
 
+// ---- linear: act(X @ W + bias) ----
+static inline double gelu_cdf(double z) { return 0.5 * (1.0 + std::erf(z * 0.7071067811865476)); } // Φ(z)
+static inline double gelu_pdf(double z) { return 0.3989422804014327 * std::exp(-0.5 * z * z); }      // φ(z)
+
+static inline double activate(double z, Activation act)
+{
+    switch (act)
+    {
+    case Activation::ReLU:
+        return z > 0.0 ? z : 0.0;
+    case Activation::GELU:
+        return z * gelu_cdf(z);
+    case Activation::Tanh:
+        return std::tanh(z);
+    case Activation::Sigmoid:
+        return 1.0 / (1.0 + std::exp(-z));
+    default:
+        return z;
+    }
+}
+
+// act'(z), taken from the output y where that is enough (GELU needs z itself)
+static inline double activation_slope(double y, double z, Activation act)
+{
+    switch (act)
+    {
+    case Activation::ReLU:
+        return y > 0.0 ? 1.0 : 0.0;
+    case Activation::GELU:
+        return gelu_cdf(z) + z * gelu_pdf(z);
+    case Activation::Tanh:
+        return 1.0 - y * y;
+    case Activation::Sigmoid:
+        return y * (1.0 - y);
+    default:
+        return 1.0;
+    }
+}
+
+static void require_linear_shapes(const Tensor &X, const Tensor &W, const Tensor *bias)
+{
+    require_matmul_shapes_2d(X, W, "linear");
+    if (bias && !(bias->size() == W.shape[1] && bias->shape.size() <= 2 &&
+                  (bias->shape.size() < 2 || bias->shape[0] == 1)))
+        throw std::runtime_error("linear: bias must have shape (n,) or (1, n) with n = " + std::to_string(W.shape[1]));
+}
+
+void linear_into(const Tensor &X, const Tensor &W, const Tensor *bias, Activation act, Tensor &Y, Tensor &pre)
+{
+    require_linear_shapes(X, W, bias);
+    const int64_t m = X.shape[0], k = X.shape[1], n = W.shape[1];
+    const int64_t dims[2] = {m, n};
+    set_shape(Y, dims, 2);
+    const bool keep_pre = act == Activation::GELU;
+    if (keep_pre)
+        set_shape(pre, dims, 2);
+    const double *bd = bias ? bias->data.data() : nullptr;
+    double *pd = keep_pre ? pre.data.data() : nullptr;
+    gemm_strided(m, n, k, X.data.data(), X.strides[0], X.strides[1], W.data.data(), W.strides[0], W.strides[1],
+                 Y.data.data(), n, false, [=](int64_t i, double *row)
+                 {
+        for (int64_t j = 0; j < n; ++j)
+        {
+            const double z = bd ? row[j] + bd[j] : row[j];
+            if (pd)
+                pd[i * n + j] = z;
+            row[j] = activate(z, act);
+        } });
+}
+
+void linear_backward_into(const Tensor &G, const Tensor &Y, const Tensor &pre, Activation act, Tensor &dZ, Tensor *db)
+{
+    // G is (m,n) or seed-batched (S,m,n); act' comes from Y/pre once per element either way
+    const bool seeded = G.shape.size() == 3;
+    if (Y.shape.size() != 2 || (seeded ? G.shape[1] != Y.shape[0] || G.shape[2] != Y.shape[1] : G.shape != Y.shape))
+        throw std::runtime_error("linear_backward: gradient/output shape mismatch");
+    if (act == Activation::GELU && pre.shape != Y.shape)
+        throw std::runtime_error("linear_backward: missing pre-activation for GELU");
+    const int64_t S = seeded ? G.shape[0] : 1, m = Y.shape[0], n = Y.shape[1];
+    set_shape(dZ, G.shape.data(), int(G.shape.size()));
+    if (db && (seeded || db->size() != n))
+        throw std::runtime_error("linear_backward: bias gradient must have n elements (unseeded only)");
+    const double *gd = G.data.data(), *yd = Y.data.data();
+    const double *zd = act == Activation::GELU ? pre.data.data() : yd;
+    double *dz = dZ.data.data();
+    double *dbd = db ? db->data.data() : nullptr;
+    // column blocks per thread: dZ and the bias reduction in a single pass, without races
+    constexpr int64_t COLS = 64;
+    const int64_t nblocks = (n + COLS - 1) / COLS;
+#if defined(_OPENMP)
+#pragma omp parallel for if (S * m * n > 32768)
+#endif
+    for (int64_t blk = 0; blk < nblocks; ++blk)
+    {
+        const int64_t j0 = blk * COLS, j1 = std::min(n, j0 + COLS);
+        double acc[COLS] = {}, slope[COLS];
+        for (int64_t i = 0; i < m; ++i)
+        {
+            for (int64_t j = j0; j < j1; ++j)
+                slope[j - j0] = activation_slope(yd[i * n + j], zd[i * n + j], act);
+            for (int64_t s = 0; s < S; ++s)
+                for (int64_t j = j0; j < j1; ++j)
+                {
+                    const int64_t e = (s * m + i) * n + j;
+                    const double v = gd[e] * slope[j - j0];
+                    dz[e] = v;
+                    acc[j - j0] += v;
+                }
+        }
+        if (dbd)
+            for (int64_t j = j0; j < j1; ++j)
+                dbd[j] = acc[j - j0];
+    }
+}
+
+Tensor activation_eval(const Tensor &z, Activation act, int order)
+{
+    Tensor out = Tensor::like(z);
+    for (int64_t e = 0; e < z.size(); ++e)
+    {
+        const double v = z.data[e];
+        if (order == 0)
+            out.data[e] = activate(v, act);
+        else if (order == 1)
+            out.data[e] = activation_slope(activate(v, act), v, act);
+        else
+        {
+            const double y = activate(v, act);
+            switch (act)
+            {
+            case Activation::GELU:
+                out.data[e] = gelu_pdf(v) * (2.0 - v * v);
+                break;
+            case Activation::Tanh:
+                out.data[e] = -2.0 * y * (1.0 - y * y);
+                break;
+            case Activation::Sigmoid:
+                out.data[e] = y * (1.0 - y) * (1.0 - 2.0 * y);
+                break;
+            default:
+                out.data[e] = 0.0; // piecewise linear
+            }
+        }
+    }
+    return out;
+}
+
+// ---- int8 inference ----
+// Dots of one uint8 activation row with 4 packed int8 weight rows (ldb apart), exact in int32.
+// The AVX2 / AVX-512 variants use intrinsics (mixed-sign byte products are not auto-vectorised
+// well); the portable path relies on an OpenMP simd reduction.
+static inline void qdot4_tail(const uint8_t *a, const int8_t *b, int64_t ldb, int64_t p0, int64_t k, int32_t *out)
+{
+    for (int64_t p = p0; p < k; ++p)
+        for (int r = 0; r < 4; ++r)
+            out[r] += int32_t(a[p]) * int32_t(b[r * ldb + p]);
+}
+
+#if defined(KERNEL_ISA_AVX512)
+static inline int32_t hsum_epi32(__m512i v)
+{
+    alignas(64) int32_t t[16];
+    _mm512_store_si512(t, v);
+    int32_t s = 0;
+    for (int i = 0; i < 16; ++i)
+        s += t[i];
+    return s;
+}
+
+// VNNI: vpdpbusd multiplies 4 u8 x s8 pairs per int32 lane and accumulates without saturation.
+// Not every AVX-512 CPU has it, so it is picked at run time.
+__attribute__((target("avx512f,avx512dq,avx512vl,avx512bw,avx2,fma,avx512vnni"))) static void qdot4_vnni(const uint8_t *a, const int8_t *b, int64_t ldb, int64_t k, int32_t *out)
+{
+    __m512i acc[4] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512()};
+    int64_t p = 0;
+    for (; p + 64 <= k; p += 64)
+    {
+        const __m512i va = _mm512_loadu_si512(a + p);
+        for (int r = 0; r < 4; ++r)
+            acc[r] = _mm512_dpbusd_epi32(acc[r], va, _mm512_loadu_si512(b + r * ldb + p));
+    }
+    for (int r = 0; r < 4; ++r)
+        out[r] = hsum_epi32(acc[r]);
+    qdot4_tail(a, b, ldb, p, k, out);
+}
+
+// AVX-512BW without VNNI: widen to int16 and multiply-add pairs into int32.
+static void qdot4(const uint8_t *a, const int8_t *b, int64_t ldb, int64_t k, int32_t *out)
+{
+    static const bool vnni = __builtin_cpu_supports("avx512vnni");
+    if (vnni)
+        return qdot4_vnni(a, b, ldb, k, out);
+    __m512i acc[4] = {_mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512()};
+    int64_t p = 0;
+    for (; p + 32 <= k; p += 32)
+    {
+        const __m512i va = _mm512_cvtepu8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + p)));
+        for (int r = 0; r < 4; ++r)
+        {
+            const __m512i vb = _mm512_cvtepi8_epi16(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + r * ldb + p)));
+            acc[r] = _mm512_add_epi32(acc[r], _mm512_madd_epi16(va, vb));
+        }
+    }
+    for (int r = 0; r < 4; ++r)
+        out[r] = hsum_epi32(acc[r]);
+    qdot4_tail(a, b, ldb, p, k, out);
+}
+#elif defined(KERNEL_ISA_AVX2)
+// Widen to int16 and multiply-add pairs into int32 (vpmaddubsw would saturate at int16).
+static void qdot4(const uint8_t *a, const int8_t *b, int64_t ldb, int64_t k, int32_t *out)
+{
+    __m256i acc[4] = {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256()};
+    int64_t p = 0;
+    for (; p + 16 <= k; p += 16)
+    {
+        const __m256i va = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(a + p)));
+        for (int r = 0; r < 4; ++r)
+        {
+            const __m256i vb = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(b + r * ldb + p)));
+            acc[r] = _mm256_add_epi32(acc[r], _mm256_madd_epi16(va, vb));
+        }
+    }
+    for (int r = 0; r < 4; ++r)
+    {
+        const __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc[r]), _mm256_extracti128_si256(acc[r], 1));
+        const __m128i t = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+        out[r] = _mm_cvtsi128_si32(_mm_add_epi32(t, _mm_shuffle_epi32(t, 0xb1)));
+    }
+    qdot4_tail(a, b, ldb, p, k, out);
+}
+#else
+static void qdot4(const uint8_t *a, const int8_t *b, int64_t ldb, int64_t k, int32_t *out)
+{
+    for (int r = 0; r < 4; ++r)
+    {
+        const int8_t *br = b + r * ldb;
+        int32_t s = 0;
+#if defined(_OPENMP)
+#pragma omp simd reduction(+ : s)
+#endif
+        for (int64_t p = 0; p < k; ++p)
+            s += int32_t(a[p]) * int32_t(br[p]);
+        out[r] = s;
+    }
+}
+#endif
+
+void quantize_into(const Tensor &X, const QuantParams &qp, QActivations &q)
+{
+    if (X.shape.size() != 2)
+        throw std::runtime_error("quantize: need a 2D tensor");
+    q.rows = X.shape[0];
+    q.cols = X.shape[1];
+    q.qp = qp;
+    q.data.resize(static_cast<size_t>(X.size()));
+    const int64_t N = X.size();
+    const double *x = X.data.data();
+    uint8_t *o = q.data.data();
+    const double inv = 1.0 / qp.scale, zp = qp.zero_point;
+#if defined(_OPENMP)
+#pragma omp parallel for simd if (N > 32768)
+#endif
+    for (int64_t i = 0; i < N; ++i)
+        o[i] = static_cast<uint8_t>(std::min(255.0, std::max(0.0, std::nearbyint(x[i] * inv) + zp)));
+}
+
+void quantize_weights(const Tensor &W, QWeights &q)
+{
+    if (W.shape.size() != 2)
+        throw std::runtime_error("quantize_weights: need a 2D weight");
+    const int64_t k = W.shape[0], n = W.shape[1];
+    q.k = k;
+    q.n = n;
+    q.data.resize(static_cast<size_t>(k * n));
+    q.scale.resize(static_cast<size_t>(n));
+    q.col_sum.resize(static_cast<size_t>(n));
+    const double *w = W.data.data();
+#if defined(_OPENMP)
+#pragma omp parallel for if (k * n > 32768)
+#endif
+    for (int64_t j = 0; j < n; ++j)
+    {
+        double amax = 0.0;
+        for (int64_t p = 0; p < k; ++p)
+            amax = std::max(amax, std::abs(w[p * W.strides[0] + j * W.strides[1]]));
+        const double s = amax > 0.0 ? amax / 127.0 : 1.0;
+        int8_t *row = q.data.data() + j * k;
+        int32_t sum = 0;
+        for (int64_t p = 0; p < k; ++p)
+        {
+            row[p] = static_cast<int8_t>(std::nearbyint(w[p * W.strides[0] + j * W.strides[1]] / s));
+            sum += row[p];
+        }
+        q.scale[j] = s;
+        q.col_sum[j] = sum;
+    }
+}
+
+void qlinear_into(const QActivations &X, const QWeights &W, const Tensor *bias, Activation act, Tensor &Y)
+{
+    if (X.cols != W.k)
+        throw std::runtime_error("qlinear: inner dimensions differ (" + std::to_string(X.cols) + " vs " +
+                                 std::to_string(W.k) + ")");
+    if (W.k > 65536)
+        throw std::runtime_error("qlinear: inner dimension > 65536 may overflow the int32 accumulators");
+    if (bias && bias->size() != W.n)
+        throw std::runtime_error("qlinear: bias must have n = " + std::to_string(W.n) + " elements");
+    const int64_t m = X.rows, k = W.k, n = W.n;
+    const int64_t dims[2] = {m, n};
+    set_shape(Y, dims, 2);
+    const uint8_t *xd = X.data.data();
+    const int8_t *wd = W.data.data();
+    const double *bd = bias ? bias->data.data() : nullptr;
+    const double xs = X.qp.scale;
+    const int32_t zp = X.qp.zero_point;
+    double *yd = Y.data.data();
+#if defined(_OPENMP)
+#pragma omp parallel for if (m * n * k > 32768)
+#endif
+    for (int64_t i = 0; i < m; ++i)
+    {
+        const uint8_t *xrow = xd + i * k;
+        double *yrow = yd + i * n;
+        int32_t acc[4];
+        for (int64_t j0 = 0; j0 < n; j0 += 4)
+        {
+            const int64_t nj = std::min<int64_t>(4, n - j0);
+            if (nj == 4)
+                qdot4(xrow, wd + j0 * k, k, k, acc);
+            else
+                for (int64_t r = 0; r < nj; ++r)
+                {
+                    acc[r] = 0;
+                    for (int64_t p = 0; p < k; ++p)
+                        acc[r] += int32_t(xrow[p]) * int32_t(wd[(j0 + r) * k + p]);
+                }
+            // dequantization epilogue: remove the zero point, rescale, then bias and activation
+            for (int64_t r = 0; r < nj; ++r)
+            {
+                const int64_t j = j0 + r;
+                const double z = xs * W.scale[j] * double(acc[r] - zp * W.col_sum[j]) + (bd ? bd[j] : 0.0);
+                yrow[j] = activate(z, act);
+            }
+        }
+    }
+}
+
 // ---- dot for 1D ----
-Tensor dotvec(const Tensor &a, const Tensor &b)
+void dotvec_into(const Tensor &a, const Tensor &b, Tensor &out)
 {
     if (!(a.shape.size() == 1 && b.shape.size() == 1 && a.shape[0] == b.shape[0]))
         throw std::runtime_error("dotvec: need same-length 1D vectors");
@@ -144,19 +1093,609 @@ Tensor dotvec(const Tensor &a, const Tensor &b)
 #endif
     for (int64_t i = 0; i < k; ++i)
         acc += a.data[i] * b.data[i];
-    return Tensor::scalar(acc);
+    set_shape(out, nullptr, 0);
+    out.data[0] = acc;
+}
+
+Tensor dotvec(const Tensor &a, const Tensor &b)
+{
+    Tensor out;
+    dotvec_into(a, b, out);
+    return out;
 }
 
 // ---- cross (3,) × (3,) ----
-Tensor cross3(const Tensor &a, const Tensor &b)
+void cross3_into(const Tensor &a, const Tensor &b, Tensor &c)
 {
     require_vec3(a, "cross3");
     require_vec3(b, "cross3");
-    Tensor c({3});
     const double ax = a.data[0], ay = a.data[1], az = a.data[2];
     const double bx = b.data[0], by = b.data[1], bz = b.data[2];
+    const int64_t dims[1] = {3};
+    set_shape(c, dims, 1);
     c.data[0] = ay * bz - az * by;
     c.data[1] = az * bx - ax * bz;
     c.data[2] = ax * by - ay * bx;
+}
+
+Tensor cross3(const Tensor &a, const Tensor &b)
+{
+    Tensor c;
+    cross3_into(a, b, c);
     return c;
 }
+
+// ---- transpose (2D) ----
+Tensor transpose2d(const Tensor &A)
+{
+    if (A.shape.size() != 2)
+        throw std::runtime_error("transpose2d: need 2D matrix");
+    Tensor At({A.shape[1], A.shape[0]});
+    for (int64_t i = 0; i < A.shape[0]; ++i)
+        for (int64_t j = 0; j < A.shape[1]; ++j)
+            At.data[j * At.strides[0] + i * At.strides[1]] = A.data[i * A.strides[0] + j * A.strides[1]];
+    return At;
+}
+
+// Swap the two leading axes: rows of 'inner' contiguous elements move as blocks.
+void swap_leading_axes_into(const Tensor &x, Tensor &out)
+{
+    if (x.shape.size() < 2)
+        throw std::runtime_error("swap_leading_axes: need rank >= 2");
+    Shape s = x.shape;
+    std::swap(s[0], s[1]);
+    out.ensure_shape(s);
+    const int64_t A = x.shape[0], B = x.shape[1], inner = x.size() / (A * B);
+    const double *src = x.data.data();
+    double *dst = out.data.data();
+#if defined(_OPENMP)
+#pragma omp parallel for if (x.size() > 32768)
+#endif
+    for (int64_t b = 0; b < B; ++b)
+        for (int64_t a = 0; a < A; ++a)
+            std::copy(src + (a * B + b) * inner, src + (a * B + b + 1) * inner, dst + (b * A + a) * inner);
+}
+
+// ---- conv2d (NCHW) via im2col + GEMM ----
+Shape conv2d_shape(const Shape &x, const Shape &w, const Conv2dParams &p)
+{
+    if (x.size() != 4 || w.size() != 4)
+        throw std::runtime_error("conv2d: need input (N,C,H,W) and weight (F,C/groups,KH,KW)");
+    for (int d = 0; d < 2; ++d)
+        if (p.stride[d] <= 0 || p.dilation[d] <= 0 || p.padding[d] < 0)
+            throw std::runtime_error("conv2d: stride/dilation must be positive, padding non-negative");
+    if (p.groups <= 0 || x[1] % p.groups != 0 || w[0] % p.groups != 0 || w[1] != x[1] / p.groups)
+        throw std::runtime_error("conv2d: channels (" + std::to_string(x[1]) + " in, " + std::to_string(w[0]) +
+                                 " out) incompatible with weight (" + std::to_string(w[1]) +
+                                 " per group) and groups=" + std::to_string(p.groups));
+    int64_t out[2];
+    for (int d = 0; d < 2; ++d)
+    {
+        const int64_t span = p.dilation[d] * (w[2 + d] - 1) + 1;
+        out[d] = (x[2 + d] + 2 * p.padding[d] - span) / p.stride[d] + 1;
+        if (x[2 + d] + 2 * p.padding[d] < span)
+            throw std::runtime_error("conv2d: kernel larger than padded input");
+    }
+    return {x[0], w[0], out[0], out[1]};
+}
+
+// Geometry of one (image, group) slice of a convolution.
+struct ConvGeom
+{
+    int64_t N, C, H, W, F, KH, KW, OH, OW, G, Cg, Fg;
+    int64_t K() const { return Cg * KH * KW; } // rows of the column matrix
+    int64_t L() const { return OH * OW; }      // output positions
+    // 1x1, stride 1, no padding: the input slice already is the column matrix
+    bool pointwise(const Conv2dParams &p) const
+    {
+        return KH == 1 && KW == 1 && p.stride[0] == 1 && p.stride[1] == 1 && p.padding[0] == 0 && p.padding[1] == 0;
+    }
+};
+
+static ConvGeom conv_geom(const Shape &x, const Shape &w, const Conv2dParams &p)
+{
+    const auto y = conv2d_shape(x, w, p);
+    return ConvGeom{x[0], x[1], x[2], x[3], w[0], w[2], w[3], y[2], y[3], p.groups, x[1] / p.groups, w[0] / p.groups};
+}
+
+// cols[(c,kh,kw), (oh,ow)] = x[c, oh*s - pad + kh*dil, ow*s - pad + kw*dil] (0 outside)
+static void im2col(const double *x, const ConvGeom &g, const Conv2dParams &p, double *cols)
+{
+    const int64_t L = g.L();
+#if defined(_OPENMP)
+#pragma omp parallel for if (g.K() * L > 32768)
+#endif
+    for (int64_t r = 0; r < g.K(); ++r)
+    {
+        const int64_t c = r / (g.KH * g.KW), kh = (r / g.KW) % g.KH, kw = r % g.KW;
+        const double *xc = x + c * g.H * g.W;
+        double *row = cols + r * L;
+        for (int64_t oh = 0; oh < g.OH; ++oh)
+        {
+            const int64_t ih = oh * p.stride[0] - p.padding[0] + kh * p.dilation[0];
+            double *out = row + oh * g.OW;
+            if (ih < 0 || ih >= g.H)
+            {
+                std::fill(out, out + g.OW, 0.0);
+                continue;
+            }
+            for (int64_t ow = 0; ow < g.OW; ++ow)
+            {
+                const int64_t iw = ow * p.stride[1] - p.padding[1] + kw * p.dilation[1];
+                out[ow] = (iw >= 0 && iw < g.W) ? xc[ih * g.W + iw] : 0.0;
+            }
+        }
+    }
+}
+
+// Adjoint of im2col: dx[c, ih, iw] += cols[...] (parallel over channels; writes are disjoint)
+static void col2im_add(const double *cols, const ConvGeom &g, const Conv2dParams &p, double *dx)
+{
+    const int64_t L = g.L();
+#if defined(_OPENMP)
+#pragma omp parallel for if (g.K() * L > 32768)
+#endif
+    for (int64_t c = 0; c < g.Cg; ++c)
+    {
+        double *dxc = dx + c * g.H * g.W;
+        for (int64_t kh = 0; kh < g.KH; ++kh)
+            for (int64_t kw = 0; kw < g.KW; ++kw)
+            {
+                const double *row = cols + ((c * g.KH + kh) * g.KW + kw) * L;
+                for (int64_t oh = 0; oh < g.OH; ++oh)
+                {
+                    const int64_t ih = oh * p.stride[0] - p.padding[0] + kh * p.dilation[0];
+                    if (ih < 0 || ih >= g.H)
+                        continue;
+                    for (int64_t ow = 0; ow < g.OW; ++ow)
+                    {
+                        const int64_t iw = ow * p.stride[1] - p.padding[1] + kw * p.dilation[1];
+                        if (iw >= 0 && iw < g.W)
+                            dxc[ih * g.W + iw] += row[oh * g.OW + ow];
+                    }
+                }
+            }
+    }
+}
+void conv2d_into(const Tensor &X, const Tensor &Wt, const Conv2dParams &p, Tensor &Y, TensorStorage &ws)
+{
+    const ConvGeom g = conv_geom(X.shape, Wt.shape, p);
+    const int64_t dims[4] = {g.N, g.F, g.OH, g.OW};
+    set_shape(Y, dims, 4);
+    const int64_t K = g.K(), L = g.L();
+    const bool direct = g.pointwise(p);
+    if (!direct)
+        ws.resize(static_cast<size_t>(K * L));
+    for (int64_t n = 0; n < g.N; ++n)
+        for (int64_t gr = 0; gr < g.G; ++gr)
+        {
+            const double *x = X.data.data() + (n * g.C + gr * g.Cg) * g.H * g.W;
+            const double *cols = x;
+            if (!direct)
+            {
+                im2col(x, g, p, ws.data());
+                cols = ws.data();
+            }
+            // Y[n, group] (Fg, L) = W[group] (Fg, K) @ cols (K, L)
+            gemm_strided(g.Fg, L, K, Wt.data.data() + gr * g.Fg * K, K, 1, cols, L, 1,
+                         Y.data.data() + (n * g.F + gr * g.Fg) * L, L, false);
+        }
+}
+
+void conv2d_grad_input_into(const Tensor &G, const Tensor &Wt, const Shape &x_shape,
+                            const Conv2dParams &p, Tensor &dX, TensorStorage &ws)
+{
+    const ConvGeom g = conv_geom(x_shape, Wt.shape, p);
+    if (G.shape != Shape{g.N, g.F, g.OH, g.OW})
+        throw std::runtime_error("conv2d: output gradient has the wrong shape");
+    set_shape(dX, x_shape.data(), 4);
+    const int64_t K = g.K(), L = g.L();
+    const bool direct = g.pointwise(p);
+    if (!direct)
+        ws.resize(static_cast<size_t>(K * L));
+    for (int64_t n = 0; n < g.N; ++n)
+        for (int64_t gr = 0; gr < g.G; ++gr)
+        {
+            double *dx = dX.data.data() + (n * g.C + gr * g.Cg) * g.H * g.W;
+            if (!direct)
+                std::fill(dx, dx + g.Cg * g.H * g.W, 0.0);
+            // dcols (K, L) = W[group]^T (K, Fg) @ G[n, group] (Fg, L)
+            gemm_strided(K, L, g.Fg, Wt.data.data() + gr * g.Fg * K, 1, K,
+                         G.data.data() + (n * g.F + gr * g.Fg) * L, L, 1,
+                         direct ? dx : ws.data(), L, false);
+            if (!direct)
+                col2im_add(ws.data(), g, p, dx);
+        }
+}
+
+void conv2d_grad_weight_into(const Tensor &G, const Tensor &X, const Shape &w_shape,
+                             const Conv2dParams &p, Tensor &dW, TensorStorage &ws)
+{
+    const ConvGeom g = conv_geom(X.shape, w_shape, p);
+    if (G.shape != Shape{g.N, g.F, g.OH, g.OW})
+        throw std::runtime_error("conv2d: output gradient has the wrong shape");
+    set_shape(dW, w_shape.data(), 4);
+    const int64_t K = g.K(), L = g.L();
+    const bool direct = g.pointwise(p);
+    if (!direct)
+        ws.resize(static_cast<size_t>(K * L));
+    for (int64_t n = 0; n < g.N; ++n)
+        for (int64_t gr = 0; gr < g.G; ++gr)
+        {
+            const double *x = X.data.data() + (n * g.C + gr * g.Cg) * g.H * g.W;
+            const double *cols = x;
+            if (!direct)
+            {
+                im2col(x, g, p, ws.data());
+                cols = ws.data();
+            }
+            // dW[group] (Fg, K) += G[n, group] (Fg, L) @ cols^T (L, K)
+            gemm_strided(g.Fg, K, L, G.data.data() + (n * g.F + gr * g.Fg) * L, L, 1, cols, 1, L,
+                         dW.data.data() + gr * g.Fg * K, K, n > 0);
+        }
+}
+
+Tensor conv2d_nchw(const Tensor &X, const Tensor &W, const Conv2dParams &p)
+{
+    Tensor Y;
+    TensorStorage ws;
+    conv2d_into(X, W, p, Y, ws);
+    return Y;
+}
+
+// ---- sparse (CSR) x dense ----
+static void require_spmm_shapes(const Tensor &B, int64_t inner, const char *op)
+{
+    if (B.shape.size() != 2)
+        throw std::runtime_error(std::string(op) + ": dense operand must be 2D");
+    if (B.shape[0] != inner)
+        throw std::runtime_error(std::string(op) + ": inner dims mismatch");
+}
+
+template <class Idx>
+static void spmm_impl(const CsrTensor &A, const Idx *indptr, const Idx *indices, const Tensor &B, Tensor &C)
+{
+    const int64_t n = B.shape[1];
+    // rows of C are independent; each row streams its nonzeros over contiguous rows of B
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64) if (A.nnz * n > 32768)
+#endif
+    for (int64_t i = 0; i < A.rows; ++i)
+    {
+        double *c = C.data.data() + i * n;
+        for (int64_t p = indptr[i]; p < indptr[i + 1]; ++p)
+        {
+            const double v = A.values[p];
+            const double *b = B.data.data() + static_cast<int64_t>(indices[p]) * B.strides[0];
+            for (int64_t j = 0; j < n; ++j)
+                c[j] += v * b[j * B.strides[1]];
+        }
+    }
+}
+
+template <class Idx>
+static void spmm_t_impl(const CsrTensor &A, const Idx *indptr, const Idx *indices, const Tensor &G, Tensor &C)
+{
+    const int64_t n = G.shape[1];
+    constexpr int64_t COLS = 64;
+    const int64_t nblk = (n + COLS - 1) / COLS;
+    // scatter into rows of C. Owner-computes: a task is (range of C rows, column block); it scans
+    // all of A and applies only the nonzeros landing in its rows, so threads never share an
+    // output element. Rows are split only when there are fewer column blocks than threads.
+    int64_t parts = 1;
+#if defined(_OPENMP)
+    if (A.nnz * n > 32768)
+        parts = std::min<int64_t>(std::max<int64_t>(A.cols, 1), (omp_get_max_threads() + nblk - 1) / nblk);
+#endif
+    const int64_t span = (A.cols + parts - 1) / parts;
+#if defined(_OPENMP)
+#pragma omp parallel for collapse(2) if (A.nnz * n > 32768)
+#endif
+    for (int64_t part = 0; part < parts; ++part)
+        for (int64_t blk = 0; blk < nblk; ++blk)
+        {
+            const int64_t r0 = part * span, r1 = std::min(A.cols, r0 + span);
+            const int64_t j0 = blk * COLS, j1 = std::min(n, j0 + COLS);
+            for (int64_t i = 0; i < A.rows; ++i)
+            {
+                const double *g = G.data.data() + i * G.strides[0];
+                for (int64_t p = indptr[i]; p < indptr[i + 1]; ++p)
+                {
+                    const int64_t r = static_cast<int64_t>(indices[p]);
+                    if (r < r0 || r >= r1)
+                        continue;
+                    const double v = A.values[p];
+                    double *c = C.data.data() + r * n;
+                    for (int64_t j = j0; j < j1; ++j)
+                        c[j] += v * g[j * G.strides[1]];
+                }
+            }
+        }
+}
+
+template <class Idx>
+static void sddmm_impl(const CsrTensor &A, const Idx *indptr, const Idx *indices,
+                       const Tensor &G, const Tensor &B, std::vector<double> &out)
+{
+    const int64_t n = G.shape[1];
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 64) if (A.nnz * n > 32768)
+#endif
+    for (int64_t i = 0; i < A.rows; ++i)
+    {
+        const double *g = G.data.data() + i * G.strides[0];
+        for (int64_t p = indptr[i]; p < indptr[i + 1]; ++p)
+        {
+            const double *b = B.data.data() + static_cast<int64_t>(indices[p]) * B.strides[0];
+            double acc = 0.0;
+            for (int64_t j = 0; j < n; ++j)
+                acc += g[j * G.strides[1]] * b[j * B.strides[1]];
+            out[p] += acc;
+        }
+    }
+}
+
+void spmm_into(const CsrTensor &A, const Tensor &B, Tensor &C)
+{
+    require_spmm_shapes(B, A.cols, "spmm");
+    const int64_t dims[2] = {A.rows, B.shape[1]};
+    set_shape(C, dims, 2);
+    std::fill(C.data.begin(), C.data.end(), 0.0);
+    if (A.indptr64)
+        spmm_impl(A, A.indptr64, A.indices64, B, C);
+    else
+        spmm_impl(A, A.indptr32, A.indices32, B, C);
+}
+
+void spmm_t_into(const CsrTensor &A, const Tensor &G, Tensor &C)
+{
+    require_spmm_shapes(G, A.rows, "spmm_t");
+    const int64_t dims[2] = {A.cols, G.shape[1]};
+    set_shape(C, dims, 2);
+    std::fill(C.data.begin(), C.data.end(), 0.0);
+    if (A.indptr64)
+        spmm_t_impl(A, A.indptr64, A.indices64, G, C);
+    else
+        spmm_t_impl(A, A.indptr32, A.indices32, G, C);
+}
+
+void sddmm_add_into(const CsrTensor &A, const Tensor &G, const Tensor &B, std::vector<double> &acc)
+{
+    require_spmm_shapes(G, A.rows, "sddmm");
+    require_spmm_shapes(B, A.cols, "sddmm");
+    if (G.shape[1] != B.shape[1])
+        throw std::runtime_error("sddmm: G and B need the same number of columns");
+    if (static_cast<int64_t>(acc.size()) != A.nnz)
+        throw std::runtime_error("sddmm: accumulator size must equal nnz");
+    if (A.indptr64)
+        sddmm_impl(A, A.indptr64, A.indices64, G, B, acc);
+    else
+        sddmm_impl(A, A.indptr32, A.indices32, G, B, acc);
+}
+
+Tensor spmm(const CsrTensor &A, const Tensor &B)
+{
+    Tensor C;
+    spmm_into(A, B, C);
+    return C;
+}
+
+Tensor spmm_t(const CsrTensor &A, const Tensor &G)
+{
+    Tensor C;
+    spmm_t_into(A, G, C);
+    return C;
+}
+
+std::vector<double> sddmm(const CsrTensor &A, const Tensor &G, const Tensor &B)
+{
+    std::vector<double> out(static_cast<size_t>(A.nnz), 0.0);
+    sddmm_add_into(A, G, B, out);
+    return out;
+}
+
+// ---- random numbers (Philox4x32-10) ----
+struct Philox4
+{
+    uint32_t w[4];
+};
+
+// The 4 words of block 'ctr' under key 'seed' (10 rounds, Salmon et al. 2011).
+static inline Philox4 philox(uint64_t seed, uint64_t ctr)
+{
+    uint32_t c0 = uint32_t(ctr), c1 = uint32_t(ctr >> 32), c2 = 0, c3 = 0;
+    uint32_t k0 = uint32_t(seed), k1 = uint32_t(seed >> 32);
+    for (int r = 0; r < 10; ++r)
+    {
+        const uint64_t p0 = uint64_t(0xD2511F53u) * c0, p1 = uint64_t(0xCD9E8D57u) * c2;
+        const uint32_t n0 = uint32_t(p1 >> 32) ^ c1 ^ k0, n2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c1 = uint32_t(p1);
+        c3 = uint32_t(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return {{c0, c1, c2, c3}};
+}
+
+// 53 random bits from two words -> [0, 1)
+static inline double unit_double(uint32_t hi, uint32_t lo)
+{
+    return double((uint64_t(hi >> 5) << 26) | (lo >> 6)) * 0x1.0p-53;
+}
+
+// Element e of a draw uses block offset + e / per of 'per' elements, so any split of the loop
+// (threads, chunks) yields the same values.
+template <int per, class F>
+static void philox_fill(double *out, int64_t N, uint64_t seed, uint64_t offset, F block)
+{
+    const int64_t blocks = (N + per - 1) / per;
+#if defined(_OPENMP)
+#pragma omp parallel for if (N > 32768)
+#endif
+    for (int64_t b = 0; b < blocks; ++b)
+    {
+        double v[per];
+        block(philox(seed, offset + uint64_t(b)), v);
+        const int64_t e0 = b * per, n = std::min<int64_t>(per, N - e0);
+        for (int64_t i = 0; i < n; ++i)
+            out[e0 + i] = v[i];
+    }
+}
+
+void fill_uniform(Tensor &t, uint64_t seed, uint64_t offset, double lo, double hi)
+{
+    const double span = hi - lo;
+    philox_fill<2>(t.data.data(), t.size(), seed, offset, [=](const Philox4 &x, double *v)
+                   {
+        v[0] = lo + span * unit_double(x.w[0], x.w[1]);
+        v[1] = lo + span * unit_double(x.w[2], x.w[3]); });
+}
+
+void fill_normal(Tensor &t, uint64_t seed, uint64_t offset, double mean, double std)
+{
+    // Box-Muller: one block gives the pair (r cos θ, r sin θ)
+    philox_fill<2>(t.data.data(), t.size(), seed, offset, [=](const Philox4 &x, double *v)
+                   {
+        const double u = 1.0 - unit_double(x.w[0], x.w[1]); // (0, 1]
+        const double r = std::sqrt(-2.0 * std::log(u)), th = 6.283185307179586 * unit_double(x.w[2], x.w[3]);
+        v[0] = mean + std * r * std::cos(th);
+        v[1] = mean + std * r * std::sin(th); });
+}
+
+void dropout_into(const Tensor &x, double p, uint64_t seed, uint64_t offset, Tensor &y)
+{
+    if (!(p >= 0.0 && p <= 1.0))
+        throw std::runtime_error("dropout: p must be in [0, 1]");
+    set_shape(y, x.shape.data(), int(x.shape.size()));
+    // one 32-bit word per element: kept when it is >= p * 2^32
+    const uint64_t cut = p >= 1.0 ? (uint64_t(1) << 32) : uint64_t(p * 4294967296.0);
+    const double scale = p < 1.0 ? 1.0 / (1.0 - p) : 0.0;
+    const double *xd = x.data.data();
+    double *yd = y.data.data();
+    const int64_t N = x.size(), blocks = (N + 3) / 4;
+#if defined(_OPENMP)
+#pragma omp parallel for if (N > 32768)
+#endif
+    for (int64_t b = 0; b < blocks; ++b)
+    {
+        const Philox4 r = philox(seed, offset + uint64_t(b));
+        const int64_t e0 = b * 4, n = std::min<int64_t>(4, N - e0);
+        for (int64_t i = 0; i < n; ++i)
+            yd[e0 + i] = r.w[i] >= cut ? xd[e0 + i] * scale : 0.0;
+    }
+}
+
+// ---- optimizer updates ----
+// Split every slice into fixed-size blocks so one parallel region covers all parameters,
+// small and large alike; each block is a contiguous, vectorizable run. Thread t of T takes
+// blocks [t nb / T, (t + 1) nb / T) of the concatenated slices, found by walking the slices.
+template <class F>
+static void for_each_param_block(const std::vector<ParamSlice> &ps, F f)
+{
+    constexpr int64_t BLOCK = 8192;
+    int64_t nb = 0, N = 0;
+    for (auto &p : ps)
+    {
+        nb += (p.n + BLOCK - 1) / BLOCK;
+        N += p.n;
+    }
+#if defined(_OPENMP)
+#pragma omp parallel if (N > 32768)
+#endif
+    {
+        int64_t t = 0, T = 1;
+#if defined(_OPENMP)
+        t = omp_get_thread_num();
+        T = omp_get_num_threads();
+#endif
+        const int64_t b0 = nb * t / T, b1 = nb * (t + 1) / T;
+        int64_t first = 0; // global index of the current slice's first block
+        for (size_t s = 0; s < ps.size() && first < b1; ++s)
+        {
+            const ParamSlice &p = ps[s];
+            const int64_t count = (p.n + BLOCK - 1) / BLOCK;
+            for (int64_t j = std::max<int64_t>(b0 - first, 0); j < count && first + j < b1; ++j)
+                f(p, j * BLOCK, std::min((j + 1) * BLOCK, p.n));
+            first += count;
+        }
+    }
+}
+
+void sgd_update(const std::vector<ParamSlice> &ps, double lr, double weight_decay)
+{
+    for_each_param_block(ps, [=](const ParamSlice &p, int64_t i0, int64_t i1)
+                         {
+        double *__restrict w = p.w;
+        const double *__restrict g = p.g;
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (int64_t i = i0; i < i1; ++i)
+            w[i] -= lr * (g[i] + weight_decay * w[i]); });
+}
+
+void momentum_update(const std::vector<ParamSlice> &ps, double lr, double mu,
+                     double weight_decay, bool nesterov)
+{
+    for_each_param_block(ps, [=](const ParamSlice &p, int64_t i0, int64_t i1)
+                         {
+        double *__restrict w = p.w;
+        double *__restrict m = p.m;
+        const double *__restrict g = p.g;
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (int64_t i = i0; i < i1; ++i)
+        {
+            const double gi = g[i] + weight_decay * w[i];
+            const double mi = mu * m[i] + gi;
+            m[i] = mi;
+            w[i] -= lr * (nesterov ? gi + mu * mi : mi);
+        } });
+}
+
+void adam_update(const std::vector<ParamSlice> &ps, double lr, double beta1, double beta2,
+                 double eps, double weight_decay, bool decoupled, int64_t t)
+{
+    // bias corrections folded into the step size and epsilon
+    const double bc1 = 1.0 - std::pow(beta1, static_cast<double>(t));
+    const double bc2 = 1.0 - std::pow(beta2, static_cast<double>(t));
+    const double step = lr * std::sqrt(bc2) / bc1;
+    const double eps_hat = eps * std::sqrt(bc2);
+    const double l2 = decoupled ? 0.0 : weight_decay;
+    const double shrink = decoupled ? 1.0 - lr * weight_decay : 1.0;
+    for_each_param_block(ps, [=](const ParamSlice &p, int64_t i0, int64_t i1)
+                         {
+        double *__restrict w = p.w;
+        double *__restrict m = p.m;
+        double *__restrict v = p.v;
+        const double *__restrict g = p.g;
+#if defined(_OPENMP)
+#pragma omp simd
+#endif
+        for (int64_t i = i0; i < i1; ++i)
+        {
+            const double gi = g[i] + l2 * w[i];
+            const double mi = beta1 * m[i] + (1.0 - beta1) * gi;
+            const double vi = beta2 * v[i] + (1.0 - beta2) * gi * gi;
+            m[i] = mi;
+            v[i] = vi;
+            w[i] = shrink * w[i] - step * mi / (std::sqrt(vi) + eps_hat);
+        } });
+}
+
+#if defined(KERNEL_VARIANT)
+} // namespace KERNEL_NS
+#if !defined(KERNEL_ISA_BASELINE)
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
+#endif
+#else
+const char *kernel_isa(const std::string &) { return "default"; }
+std::vector<std::string> kernel_isas() { return {"default"}; }
+#endif
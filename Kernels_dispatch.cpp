@@ -0,0 +1,174 @@
+#include "Kernels.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Global kernel API forwarding to the ISA variants of Kernels_cpu.cpp (compiled with
+// KERNEL_ISA_BASELINE / _AVX2 / _AVX512). x86 GCC/Clang only; other toolchains build
+// Kernels_cpu.cpp alone.
+#if !(defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#error "Kernels_dispatch.cpp needs GCC or Clang on x86; build Kernels_cpu.cpp alone instead"
+#endif
+
+#define KERNEL(R, name, params, args) R name params;
+namespace kernels_baseline
+{
+#include "Kernels_list.hpp"
+}
+namespace kernels_avx2
+{
+#include "Kernels_list.hpp"
+}
+namespace kernels_avx512
+{
+#include "Kernels_list.hpp"
+}
+#undef KERNEL
+
+namespace
+{
+enum Isa
+{
+    Baseline,
+    AVX2,
+    AVX512,
+    IsaCount
+};
+const char *const isa_names[IsaCount] = {"baseline", "avx2", "avx512"};
+
+bool cpu_supports(int isa)
+{
+    __builtin_cpu_init();
+    switch (isa)
+    {
+    case AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    case AVX512:
+        return cpu_supports(AVX2) && __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") &&
+               __builtin_cpu_supports("avx512vl") && __builtin_cpu_supports("avx512bw");
+    default:
+        return true;
+    }
+}
+
+int parse_isa(const std::string &s, const char *env)
+{
+    for (int i = 0; i < IsaCount; ++i)
+        if (s == isa_names[i])
+        {
+            if (!cpu_supports(i))
+                throw std::runtime_error(std::string(env) + ": this CPU cannot run the " + s + " kernels");
+            return i;
+        }
+    throw std::runtime_error(std::string(env) + ": unknown ISA '" + s + "' (baseline, avx2, avx512)");
+}
+
+struct Dispatch
+{
+    struct
+    {
+#define KERNEL(R, name, params, args) R(*name) params;
+#include "Kernels_list.hpp"
+#undef KERNEL
+    } fn;
+    int default_isa = Baseline;
+    std::vector<std::pair<std::string, int>> chosen; // kernel name -> variant
+
+    // Best supported variant for every kernel, then ELHAMMATH_KERNEL_ISA: a bare ISA name sets
+    // the default, "kernel=isa" pins one kernel.
+    Dispatch()
+    {
+        while (default_isa + 1 < IsaCount && cpu_supports(default_isa + 1))
+            ++default_isa;
+        std::vector<std::pair<std::string, int>> pinned;
+        const char *env = "ELHAMMATH_KERNEL_ISA";
+        if (const char *spec = std::getenv(env))
+        {
+            std::string item;
+            for (const char *p = spec;; ++p)
+            {
+                if (*p && *p != ',')
+                {
+                    if (*p != ' ')
+                        item += *p;
+                    continue;
+                }
+                const size_t eq = item.find('=');
+                if (eq != std::string::npos)
+                    pinned.emplace_back(item.substr(0, eq), parse_isa(item.substr(eq + 1), env));
+                else if (!item.empty())
+                    default_isa = parse_isa(item, env);
+                item.clear();
+                if (!*p)
+                    break;
+            }
+        }
+        auto choose = [&](const char *name)
+        {
+            int isa = default_isa;
+            for (auto &p : pinned)
+                if (p.first == name)
+                    isa = p.second;
+            chosen.emplace_back(name, isa);
+            return isa;
+        };
+#define KERNEL(R, name, params, args)                                     \
+    switch (choose(#name))                                                \
+    {                                                                     \
+    case AVX512:                                                          \
+        fn.name = &kernels_avx512::name;                                  \
+        break;                                                            \
+    case AVX2:                                                            \
+        fn.name = &kernels_avx2::name;                                    \
+        break;                                                            \
+    default:                                                              \
+        fn.name = &kernels_baseline::name;                                \
+    }
+#include "Kernels_list.hpp"
+#undef KERNEL
+        for (auto &p : pinned)
+        {
+            bool known = false;
+            for (auto &c : chosen)
+                known = known || c.first == p.first;
+            if (!known)
+                throw std::runtime_error(std::string(env) + ": unknown kernel '" + p.first + "'");
+        }
+    }
+};
+
+// Selected once, on first use (thread-safe static initialization).
+const Dispatch &dispatch()
+{
+    static const Dispatch d;
+    return d;
+}
+} // namespace
+
+#define KERNEL(R, name, params, args) \
+    R name params { return dispatch().fn.name args; }
+#include "Kernels_list.hpp"
+#undef KERNEL
+
+const char *kernel_isa(const std::string &kernel)
+{
+    const Dispatch &d = dispatch();
+    if (kernel.empty())
+        return isa_names[d.default_isa];
+    for (auto &c : d.chosen)
+        if (c.first == kernel)
+            return isa_names[c.second];
+    throw std::runtime_error("kernel_isa: unknown kernel '" + kernel + "'");
+}
+
+std::vector<std::string> kernel_isas()
+{
+    std::vector<std::string> out;
+    for (int i = 0; i < IsaCount; ++i)
+        if (cpu_supports(i))
+            out.push_back(isa_names[i]);
+    return out;
+}
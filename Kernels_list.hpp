@@ -0,0 +1,96 @@
+// X-macro list of every dispatched kernel: KERNEL(return type, name, (parameters), (arguments)).
+// Must match the declarations in Kernels.hpp (defaults live there). No include guard: the
+// includer defines KERNEL, includes this file and undefines it again.
+
+KERNEL(Tensor, ew_add, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, ew_sub, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, ew_mul, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, ew_div, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, ew_pow, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, ew_exp, (const Tensor &x), (x))
+KERNEL(Tensor, ew_ln, (const Tensor &x), (x))
+KERNEL(Tensor, ew_sqrt, (const Tensor &x), (x))
+KERNEL(Tensor, ew_neg, (const Tensor &x), (x))
+KERNEL(Tensor, ew_xlogy, (const Tensor &x, const Tensor &y), (x, y))
+
+KERNEL(void, ew_add_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_sub_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_mul_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_div_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_pow_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_xlogy_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, ew_exp_into, (const Tensor &x, Tensor &out), (x, out))
+KERNEL(void, ew_ln_into, (const Tensor &x, Tensor &out), (x, out))
+KERNEL(void, ew_sqrt_into, (const Tensor &x, Tensor &out), (x, out))
+KERNEL(void, ew_affine_into, (const Tensor &x, double s, double c, Tensor &out), (x, s, c, out))
+
+KERNEL(void, softmax_into, (const Tensor &x, int64_t axis, Tensor &y), (x, axis, y))
+KERNEL(void, log_softmax_into, (const Tensor &x, int64_t axis, Tensor &y), (x, axis, y))
+KERNEL(void, logsumexp_into, (const Tensor &x, int64_t axis, Tensor &y), (x, axis, y))
+KERNEL(void, softmax_backward_into, (const Tensor &y, const Tensor &g, int64_t axis, Tensor &dx), (y, g, axis, dx))
+KERNEL(void, log_softmax_backward_into, (const Tensor &y, const Tensor &g, int64_t axis, Tensor &dx), (y, g, axis, dx))
+KERNEL(void, logsumexp_backward_into, (const Tensor &x, const Tensor &lse, const Tensor &g, int64_t axis, Tensor &dx),
+       (x, lse, g, axis, dx))
+KERNEL(void, softmax_cross_entropy_into, (const Tensor &x, const Tensor &t, int64_t axis, Tensor &logp, Tensor &loss),
+       (x, t, axis, logp, loss))
+KERNEL(void, softmax_cross_entropy_backward_into,
+       (const Tensor &logp, const Tensor &t, int64_t axis, double scale, Tensor &dx), (logp, t, axis, scale, dx))
+KERNEL(Tensor, sum_axis, (const Tensor &x, int64_t axis), (x, axis))
+
+KERNEL(Tensor, matmul2d, (const Tensor &A, const Tensor &B), (A, B))
+KERNEL(Tensor, dotvec, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, cross3, (const Tensor &a, const Tensor &b), (a, b))
+KERNEL(Tensor, transpose2d, (const Tensor &A), (A))
+KERNEL(void, swap_leading_axes_into, (const Tensor &x, Tensor &out), (x, out))
+KERNEL(void, matmul2d_into, (const Tensor &A, const Tensor &B, Tensor &C, bool trans_a, bool trans_b),
+       (A, B, C, trans_a, trans_b))
+KERNEL(void, dotvec_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, linear_into, (const Tensor &X, const Tensor &W, const Tensor *bias, Activation act, Tensor &Y, Tensor &pre),
+       (X, W, bias, act, Y, pre))
+KERNEL(void, linear_backward_into,
+       (const Tensor &G, const Tensor &Y, const Tensor &pre, Activation act, Tensor &dZ, Tensor *db),
+       (G, Y, pre, act, dZ, db))
+KERNEL(Tensor, activation_eval, (const Tensor &z, Activation act, int order), (z, act, order))
+KERNEL(void, cross3_into, (const Tensor &a, const Tensor &b, Tensor &out), (a, b, out))
+KERNEL(void, quantize_into, (const Tensor &X, const QuantParams &qp, QActivations &q), (X, qp, q))
+KERNEL(void, quantize_weights, (const Tensor &W, QWeights &q), (W, q))
+KERNEL(void, qlinear_into, (const QActivations &X, const QWeights &W, const Tensor *bias, Activation act, Tensor &Y),
+       (X, W, bias, act, Y))
+
+KERNEL(Shape, conv2d_shape, (const Shape &x, const Shape &w, const Conv2dParams &p), (x, w, p))
+KERNEL(Tensor, conv2d_nchw, (const Tensor &X, const Tensor &W, const Conv2dParams &p), (X, W, p))
+KERNEL(void, conv2d_into, (const Tensor &X, const Tensor &W, const Conv2dParams &p, Tensor &Y, TensorStorage &ws),
+       (X, W, p, Y, ws))
+KERNEL(void, conv2d_grad_input_into,
+       (const Tensor &G, const Tensor &W, const Shape &x_shape, const Conv2dParams &p, Tensor &dX,
+        TensorStorage &ws),
+       (G, W, x_shape, p, dX, ws))
+KERNEL(void, conv2d_grad_weight_into,
+       (const Tensor &G, const Tensor &X, const Shape &w_shape, const Conv2dParams &p, Tensor &dW,
+        TensorStorage &ws),
+       (G, X, w_shape, p, dW, ws))
+
+KERNEL(Tensor, spmm, (const CsrTensor &A, const Tensor &B), (A, B))
+KERNEL(Tensor, spmm_t, (const CsrTensor &A, const Tensor &G), (A, G))
+KERNEL(std::vector<double>, sddmm, (const CsrTensor &A, const Tensor &G, const Tensor &B), (A, G, B))
+KERNEL(void, spmm_into, (const CsrTensor &A, const Tensor &B, Tensor &C), (A, B, C))
+KERNEL(void, spmm_t_into, (const CsrTensor &A, const Tensor &G, Tensor &C), (A, G, C))
+KERNEL(void, sddmm_add_into, (const CsrTensor &A, const Tensor &G, const Tensor &B, std::vector<double> &acc),
+       (A, G, B, acc))
+
+KERNEL(void, fill_uniform, (Tensor &t, uint64_t seed, uint64_t offset, double lo, double hi), (t, seed, offset, lo, hi))
+KERNEL(void, fill_normal, (Tensor &t, uint64_t seed, uint64_t offset, double mean, double std), (t, seed, offset, mean, std))
+KERNEL(void, dropout_into, (const Tensor &x, double p, uint64_t seed, uint64_t offset, Tensor &y),
+       (x, p, seed, offset, y))
+
+KERNEL(void, sgd_update, (const std::vector<ParamSlice> &ps, double lr, double weight_decay), (ps, lr, weight_decay))
+KERNEL(void, momentum_update,
+       (const std::vector<ParamSlice> &ps, double lr, double mu, double weight_decay, bool nesterov),
+       (ps, lr, mu, weight_decay, nesterov))
+KERNEL(void, adam_update,
+       (const std::vector<ParamSlice> &ps, double lr, double beta1, double beta2, double eps, double weight_decay,
+        bool decoupled, int64_t t),
+       (ps, lr, beta1, beta2, eps, weight_decay, decoupled, t))
+
+KERNEL(Tensor, reduce_to_shape, (const Tensor &src, const Shape &target_shape), (src, target_shape))
+KERNEL(void, reduce_add_into, (const Tensor &src, Tensor &dst), (src, dst))
@@ -0,0 +1,74 @@
+#pragma once
+#include "Tensor.hpp"
+#include "SparseTensor.hpp"
+#include <cmath>
+
+// Plain argument types of the kernel API, shared by every ISA variant of Kernels_cpu.cpp.
+
+// Activation fused into linear_into's GEMM epilogue.
+enum class Activation
+{
+    None,
+    ReLU,
+    GELU, // exact (erf) form
+    Tanh,
+    Sigmoid
+};
+
+// conv2d geometry, per spatial axis (h, w).
+struct Conv2dParams
+{
+    int64_t stride[2] = {1, 1};
+    int64_t padding[2] = {0, 0};
+    int64_t dilation[2] = {1, 1};
+    int64_t groups = 1;
+};
+
+// One parameter tensor seen by the optimizer update kernels.
+struct ParamSlice
+{
+    double *w;       // parameter
+    const double *g; // gradient
+    double *m;       // velocity / first moment (unused by sgd)
+    double *v;       // second moment (adam only)
+    int64_t n;
+};
+
+// Affine uint8 quantization of activations: real = scale * (q - zero_point).
+struct QuantParams
+{
+    double scale = 1.0;
+    int32_t zero_point = 0;
+
+    // Covers [lo, hi] widened to include 0, so that zero (padding, ReLU) is exact.
+    static QuantParams from_range(double lo, double hi)
+    {
+        lo = std::min(lo, 0.0);
+        hi = std::max(hi, 0.0);
+        QuantParams p;
+        if (hi > lo)
+        {
+            p.scale = (hi - lo) / 255.0;
+            p.zero_point = static_cast<int32_t>(std::lround(-lo / p.scale));
+        }
+        return p;
+    }
+};
+
+// uint8 activations (rows, cols), row-major.
+struct QActivations
+{
+    int64_t rows = 0, cols = 0;
+    std::vector<uint8_t> data;
+    QuantParams qp;
+};
+
+// int8 weights of Y = X @ W for W (k, n), packed transposed as n rows of k so every output is
+// one contiguous dot product. Symmetric per output column: W[p][j] = scale[j] * q[j][p].
+struct QWeights
+{
+    int64_t k = 0, n = 0;
+    std::vector<int8_t> data;
+    std::vector<double> scale;
+    std::vector<int32_t> col_sum; // Σ_p q[j][p], folds the activation zero point out of the GEMM
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "Node.hpp"
+
+// Tensor bytes held by one node, by category.
+struct NodeMemory
+{
+    std::string name;
+    int64_t parameters = 0;  // Variable values / SparseVariable CSR arrays
+    int64_t inputs = 0;      // Constant values (data fed to the graph)
+    int64_t activations = 0; // Operator values
+    int64_t grads = 0;       // reverse-mode grads
+    int64_t temporaries = 0; // tangents, grad tangents, Jacobian seed grads and per-operator scratch
+    int64_t total() const { return parameters + inputs + activations + grads + temporaries; }
+};
+
+// Per-node and per-category totals of a graph's tensor bytes (allocated heap capacity;
+// tensors small enough for inline storage count as 0).
+struct MemoryReport
+{
+    std::vector<NodeMemory> nodes; // topological order
+    int64_t parameters = 0, inputs = 0, activations = 0, grads = 0, temporaries = 0;
+    int64_t total() const { return parameters + inputs + activations + grads + temporaries; }
+
+    void add(NodeMemory m)
+    {
+        parameters += m.parameters;
+        inputs += m.inputs;
+        activations += m.activations;
+        grads += m.grads;
+        temporaries += m.temporaries;
+        nodes.push_back(std::move(m));
+    }
+
+    // The k nodes holding the most bytes, largest first.
+    std::vector<NodeMemory> largest(size_t k) const
+    {
+        std::vector<NodeMemory> out = nodes;
+        std::stable_sort(out.begin(), out.end(), [](const NodeMemory &x, const NodeMemory &y)
+                         { return x.total() > y.total(); });
+        out.resize(std::min(k, out.size()));
+        return out;
+    }
+
+    // One line per holder, e.g. "'h1' 12.0 MiB (activations 4.0 MiB, grads 8.0 MiB)".
+    std::string largest_summary(size_t k) const
+    {
+        auto human = [](int64_t b)
+        {
+            const char *units[] = {"B", "KiB", "MiB", "GiB"};
+            double v = static_cast<double>(b);
+            int u = 0;
+            while (v >= 1024 && u < 3)
+            {
+                v /= 1024;
+                ++u;
+            }
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.1f %s", v, units[u]);
+            return std::string(buf);
+        };
+        std::string s;
+        for (auto &n : largest(k))
+        {
+            s += "\n  '" + n.name + "' " + human(n.total()) + " (";
+            const std::pair<const char *, int64_t> parts[] = {{"parameters", n.parameters}, {"inputs", n.inputs}, {"activations", n.activations}, {"grads", n.grads}, {"temporaries", n.temporaries}};
+            bool first = true;
+            for (auto &p : parts)
+                if (p.second)
+                {
+                    s += (first ? "" : ", ") + std::string(p.first) + " " + human(p.second);
+                    first = false;
+                }
+            s += ")";
+        }
+        return s;
+    }
+};
+
+inline NodeMemory node_memory(const Node &n)
+{
+    NodeMemory m;
+    m.name = n.name;
+    if (auto *s = dynamic_cast<const SparseVariable *>(&n))
+    {
+        // values plus the index arrays (int64 or int32, as the CSR holds them)
+        const int64_t idx = s->csr.indptr64 ? 8 : 4;
+        m.parameters = s->csr.nnz * (static_cast<int64_t>(sizeof(double)) + idx) + (s->csr.rows + 1) * idx;
+        m.grads = static_cast<int64_t>(s->grad_values.capacity() * sizeof(double));
+    }
+    else if (dynamic_cast<const Operator *>(&n))
+        m.activations = n.value.nbytes();
+    else if (dynamic_cast<const Constant *>(&n))
+        m.inputs = n.value.nbytes();
+    else
+        m.parameters = n.value.nbytes();
+    m.grads += n.grad.nbytes();
+    m.temporaries = n.tangent.nbytes() + n.grad_tangent.nbytes() + n.seed_grad.nbytes() + n.scratch_bytes();
+    return m;
+}
+
+inline MemoryReport memory_report(const std::vector<NodePtr> &order)
+{
+    MemoryReport r;
+    r.nodes.reserve(order.size());
+    for (auto &n : order)
+        r.add(node_memory(*n));
+    return r;
+}
@@ -1,8 +1,10 @@
 #pragma once
+#include <cstring>
 #include <string>
 #include <memory>
 #include "Tensor.hpp"
 #include "Kernels.hpp"
+#include "Random.hpp"
 
 class Node
 {
@@ -10,11 +12,89 @@ public:
     std::string name;
     Tensor value;
     Tensor grad;
+    Tensor tangent;      // forward mode: d(value)/dt along the seeded direction
+    Tensor grad_tangent; // forward-over-reverse: d(grad)/dt (Hessian-vector product on leaves)
+    Tensor seed_grad;    // Graph::jacobian: grads of a block of S seeds, shape (S, *value.shape)
+    uint64_t version = 0; // bumped on every leaf write; Graph::forward recomputes only what changed
 
     explicit Node(std::string n) : name(std::move(n)) {}
 
+    void set_value(const Tensor &v)
+    {
+        value = v; // copy-assign reuses the buffer when the size is unchanged
+        ++version;
+    }
+    // Call after writing 'value' (or a SparseVariable's csr) in place.
+    void mark_dirty() { ++version; }
+
     virtual Tensor forward() = 0;
-    virtual void backward(const Tensor &upstream) = 0;
+    // Accumulate an upstream gradient into 'grad' (summed over broadcast axes).
+    virtual void backward(const Tensor &upstream)
+    {
+        if (grad.shape != value.shape || grad.data.size() != value.data.size())
+            grad = Tensor::like(value, 0.0);
+        reduce_add_into(upstream, grad);
+    }
+
+    // Accumulate a seed-batched upstream (S, *broadcast shape) into 'seed_grad', summing over
+    // broadcast axes like backward() does for each seed. An empty seed_grad starts at zero.
+    virtual void backward_seeds(const Tensor &upstream)
+    {
+        if (seed_grad.data.empty())
+            seed_grad = Tensor(seeds_shape(upstream.shape[0], value.shape), 0.0);
+        const size_t pad = upstream.shape.size() - seed_grad.shape.size();
+        if (pad == 0)
+        {
+            reduce_add_into(upstream, seed_grad);
+            return;
+        }
+        // view seed_grad as (S, 1.., *value.shape) so its seed axis lines up with upstream's
+        const Shape full = seed_grad.shape;
+        Shape aligned(pad + 1, 1);
+        aligned[0] = full[0];
+        for (size_t d = 1; d < full.size(); ++d)
+            aligned.push_back(full[d]);
+        seed_grad.reshape(aligned);
+        reduce_add_into(upstream, seed_grad);
+        seed_grad.reshape(full);
+    }
+
+    // (S, *shape): a seed axis in front of 'shape'
+    static Shape seeds_shape(int64_t S, const Shape &shape)
+    {
+        Shape out{S};
+        for (auto d : shape)
+            out.push_back(d);
+        return out;
+    }
+
+    // Reset gradient state before a backward sweep (in place when the shape is unchanged).
+    virtual void zero_grad()
+    {
+        grad.ensure_shape(value.shape);
+        std::fill(grad.data.begin(), grad.data.end(), 0.0);
+    }
+
+    // Forward mode: set 'tangent' from the inputs' value/tangent (value must be current).
+    virtual void jvp() {}
+    // Forward-over-reverse: push (grad, grad_tangent) of this node into its inputs.
+    virtual void backward_dual() {}
+    virtual void accumulate_dual(const Tensor &g, const Tensor &g_dot)
+    {
+        if (grad.data.size() != value.data.size())
+            grad = Tensor::like(value, 0.0);
+        if (grad_tangent.data.size() != value.data.size())
+            grad_tangent = Tensor::like(value, 0.0);
+        Tensor g_like = reduce_to_shape(g, value.shape);
+        Tensor gd_like = reduce_to_shape(g_dot, value.shape);
+        for (int64_t i = 0; i < grad.size(); ++i)
+        {
+            grad.data[i] += g_like.data[i];
+            grad_tangent.data[i] += gd_like.data[i];
+        }
+    }
+    // Bytes held in private workspaces beyond value/grad/tangent (memory accounting).
+    virtual int64_t scratch_bytes() const { return 0; }
     virtual ~Node() = default;
 };
 
@@ -29,34 +109,155 @@ public:
         grad = Tensor::like(v, 0.0);
     }
     Tensor forward() override { return value; }
-    void backward(const Tensor &upstream) override
-    {
-        if (grad.shape.empty())
-            grad = Tensor::like(value, 0.0);
-        // accumulate with reduction if broadcasting happened upstream
-        Tensor g_like = reduce_to_shape(upstream, value.shape);
-        for (int64_t i = 0; i < grad.size(); ++i)
-            grad.data[i] += g_like.data[i];
-    }
 };
 
+// A non-differentiable leaf. By default it is an input that may be fed by name (Graph::train,
+// DataParallel::step, ...); a literal Constant (or an unnamed one) is fixed at construction, so
+// the Graph passes may fold and simplify it into its consumers.
 class Constant : public Node
 {
 public:
-    Constant(const Tensor &v, const std::string &n) : Node(n)
+    bool literal;
+    Constant(const Tensor &v, const std::string &n, bool is_literal = false) : Node(n), literal(is_literal)
     {
         value = v;
         grad = Tensor::like(v, 0.0);
     }
     Tensor forward() override { return value; }
     void backward(const Tensor &) override { /* no-op */ }
+    void backward_seeds(const Tensor &) override { /* no-op */ }
+    void accumulate_dual(const Tensor &, const Tensor &) override { /* no-op */ }
+};
+
+// Post-training int8 path of a matmul / linear whose weight is a Variable (Graph::quantize).
+// Weights are packed once per quantize(); activations are quantized on every forward with the
+// range seen by Graph::calibrate, or with the batch's own range when never calibrated.
+struct QuantizedGemm
+{
+    bool enabled = false;
+    bool calibrated = false;
+    double lo = 0.0, hi = 0.0; // calibrated activation range
+    QWeights w;
+    QActivations x; // per-forward activation buffer
+
+    void observe(const Tensor &X)
+    {
+        if (X.data.empty())
+            return;
+        const auto mm = std::minmax_element(X.data.begin(), X.data.end());
+        lo = calibrated ? std::min(lo, *mm.first) : *mm.first;
+        hi = calibrated ? std::max(hi, *mm.second) : *mm.second;
+        calibrated = true;
+    }
+    // Y = act(X @ W + bias) on the int8 kernels.
+    void run(const Tensor &X, const Tensor *bias, Activation act, Tensor &Y)
+    {
+        double l = lo, h = hi;
+        if (!calibrated && !X.data.empty())
+        {
+            const auto mm = std::minmax_element(X.data.begin(), X.data.end());
+            l = *mm.first;
+            h = *mm.second;
+        }
+        ::quantize_into(X, QuantParams::from_range(l, h), x);
+        ::qlinear_into(x, w, bias, act, Y);
+    }
+    void release()
+    {
+        w = QWeights();
+        x = QActivations();
+    }
+    int64_t bytes() const
+    {
+        return static_cast<int64_t>(w.data.capacity() + x.data.capacity() + w.scale.capacity() * sizeof(double) +
+                                    w.col_sum.capacity() * sizeof(int32_t));
+    }
 };
 
 class Operator : public Node
 {
 public:
     NodePtr a, b; // b may be null for unary
+    NodePtr c;    // optional third input of fused operators (e.g. linear's bias)
     Operator(NodePtr x, NodePtr y, const std::string &n) : Node(n), a(std::move(x)), b(std::move(y)) {}
+
+    // Graph execution: 'value' from the inputs' current values / push 'grad' into the inputs.
+    virtual void compute() = 0;
+    virtual void vjp() = 0;
+    // Output shape from the inputs' (already inferred) shapes; throws on mismatch.
+    virtual Shape infer_shape() const = 0;
+    // Non-input settings that make two operators of the same type differ (keyed by CSE).
+    virtual std::vector<int64_t> attributes() const { return {}; }
+    // Draws random numbers in some mode (structural, unlike stochastic()): never constant-folded
+    // or merged by CSE, since 'training' may be switched on after the passes have run.
+    virtual bool randomized() const { return false; }
+    // Draws fresh random numbers on the next evaluation: recomputed by every Graph::forward.
+    virtual bool stochastic() const { return false; }
+
+    // Standalone use: pull the inputs recursively, then compute.
+    Tensor forward() override
+    {
+        a->forward();
+        if (b)
+            b->forward();
+        if (c)
+            c->forward();
+        compute();
+        return value;
+    }
+
+    // Graph::jacobian: push 'seed_grad' (S, *value.shape) into the inputs' seed_grad for all S
+    // seeds at once. This default replays vjp() once per seed (overwriting 'grad' and the
+    // inputs' grads); the common operators override it with batched kernels.
+    virtual void vjp_seeds()
+    {
+        const int64_t S = seed_grad.shape[0], n = value.size();
+        Node *in[3] = {a.get(), b.get() != a.get() ? b.get() : nullptr,
+                       c.get() != a.get() && c.get() != b.get() ? c.get() : nullptr};
+        Tensor per[3]; // seed-batched grad of each distinct input
+        for (int k = 0; k < 3; ++k)
+            if (in[k])
+                per[k] = Tensor(seeds_shape(S, in[k]->value.shape), 0.0);
+        for (int64_t s = 0; s < S; ++s)
+        {
+            for (Node *x : in)
+                if (x)
+                    x->zero_grad();
+            grad.ensure_shape(value.shape);
+            std::copy(seed_grad.data.begin() + s * n, seed_grad.data.begin() + (s + 1) * n, grad.data.begin());
+            vjp();
+            for (int k = 0; k < 3; ++k)
+                if (in[k] && in[k]->grad.data.size() * S == per[k].data.size())
+                    std::copy(in[k]->grad.data.begin(), in[k]->grad.data.end(),
+                              per[k].data.begin() + s * in[k]->grad.size());
+        }
+        for (int k = 0; k < 3; ++k)
+            if (in[k])
+                in[k]->backward_seeds(per[k]);
+    }
+
+    // int8 state of operators that can run quantized (matmul, linear), else null.
+    virtual QuantizedGemm *quantized_gemm() { return nullptr; }
+
+    // Drop the scratch vjp_seeds() left S times larger than backward needs.
+    virtual void release_seed_scratch()
+    {
+        tmp_a = Tensor();
+        tmp_b = Tensor();
+    }
+
+    int64_t scratch_bytes() const override { return tmp_a.nbytes() + tmp_b.nbytes(); }
+
+protected:
+    Tensor tmp_a, tmp_b; // persistent scratch for vjp temporaries (reused across steps)
+
+    // seed_grad of a scalar-valued operator as (S, 1 x rank), broadcasting against a rank-'rank' input
+    Tensor seed_column(size_t rank) const
+    {
+        Tensor g = seed_grad;
+        g.reshape(seeds_shape(seed_grad.shape[0], Shape(rank, 1)));
+        return g;
+    }
 };
 
 // ---------- elementwise add ----------
@@ -64,16 +265,32 @@ class add : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_add(a->forward(), b->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
+    }
+    void compute() override
+    {
+        ew_add_into(a->value, b->value, value);
+    }
+    void vjp() override
+    {
+        a->backward(grad);
+        b->backward(grad);
+    }
+    void vjp_seeds() override
+    {
+        a->backward_seeds(seed_grad);
+        b->backward_seeds(seed_grad);
+    }
+    void jvp() override
+    {
+        tangent = ew_add(a->tangent, b->tangent);
     }
-    void backward(const Tensor &g) override
+    void backward_dual() override
     {
-        a->backward(reduce_to_shape(g, a->value.shape));
-        b->backward(reduce_to_shape(g, b->value.shape));
+        a->accumulate_dual(grad, grad_tangent);
+        b->accumulate_dual(grad, grad_tangent);
     }
 };
 
@@ -82,20 +299,35 @@ class sub : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_sub(a->forward(), b->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
+    }
+    void compute() override
+    {
+        ew_sub_into(a->value, b->value, value);
     }
-    void backward(const Tensor &g) override
+    void vjp() override
     {
-        a->backward(reduce_to_shape(g, a->value.shape));
+        a->backward(grad);
         // -g for b
-        Tensor gm = reduce_to_shape(g, b->value.shape);
-        for (auto &v : gm.data)
-            v = -v;
-        b->backward(gm);
+        ew_affine_into(grad, -1.0, 0.0, tmp_b);
+        b->backward(tmp_b);
+    }
+    void vjp_seeds() override
+    {
+        a->backward_seeds(seed_grad);
+        ew_affine_into(seed_grad, -1.0, 0.0, tmp_b);
+        b->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        tangent = ew_sub(a->tangent, b->tangent);
+    }
+    void backward_dual() override
+    {
+        a->accumulate_dual(grad, grad_tangent);
+        b->accumulate_dual(ew_neg(grad), ew_neg(grad_tangent));
     }
 };
 
@@ -104,20 +336,41 @@ class mul : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        const Tensor Av = a->forward(), Bv = b->forward();
-        value = ew_mul(Av, Bv);
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
+    }
+    void compute() override
+    {
+        ew_mul_into(a->value, b->value, value);
+    }
+    void vjp() override
+    {
+        // dA = g ⊙ B ; dB = g ⊙ A (inputs reduce over broadcast axes)
+        ew_mul_into(grad, b->value, tmp_a);
+        a->backward(tmp_a);
+        ew_mul_into(grad, a->value, tmp_b);
+        b->backward(tmp_b);
     }
-    void backward(const Tensor &g) override
+    void vjp_seeds() override
     {
-        // dA = g ⊙ B ; dB = g ⊙ A, then reduce to input shapes
-        Tensor dA = ew_mul(g, b->value);
-        Tensor dB = ew_mul(g, a->value);
-        a->backward(reduce_to_shape(dA, a->value.shape));
-        b->backward(reduce_to_shape(dB, b->value.shape));
+        // inputs broadcast against the (S, *shape) seed grads from the right
+        ew_mul_into(seed_grad, b->value, tmp_a);
+        a->backward_seeds(tmp_a);
+        ew_mul_into(seed_grad, a->value, tmp_b);
+        b->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        tangent = ew_add(ew_mul(a->tangent, b->value), ew_mul(a->value, b->tangent));
+    }
+    void backward_dual() override
+    {
+        // d(g ⊙ B)/dt = ġ ⊙ B + g ⊙ Ḃ ; d(g ⊙ A)/dt = ġ ⊙ A + g ⊙ Ȧ
+        a->accumulate_dual(ew_mul(grad, b->value),
+                           ew_add(ew_mul(grad_tangent, b->value), ew_mul(grad, b->tangent)));
+        b->accumulate_dual(ew_mul(grad, a->value),
+                           ew_add(ew_mul(grad_tangent, a->value), ew_mul(grad, a->tangent)));
     }
 };
 
@@ -126,22 +379,47 @@ class divide : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        const Tensor Av = a->forward(), Bv = b->forward();
-        value = ew_div(Av, Bv);
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
+    }
+    void compute() override
+    {
+        ew_div_into(a->value, b->value, value);
     }
-    void backward(const Tensor &g) override
+    void vjp() override
     {
-        // dA = g / B ; dB = - g ⊙ A / B^2
-        Tensor dA = ew_div(g, b->value);
-        Tensor dB = ew_div(ew_mul(g, a->value), ew_mul(b->value, b->value));
-        for (auto &v : dB.data)
-            v = -v;
-        a->backward(reduce_to_shape(dA, a->value.shape));
-        b->backward(reduce_to_shape(dB, b->value.shape));
+        // dA = g / B ; dB = - g ⊙ A / B^2 = -dA ⊙ y
+        ew_div_into(grad, b->value, tmp_a);
+        ew_mul_into(tmp_a, value, tmp_b);
+        ew_affine_into(tmp_b, -1.0, 0.0, tmp_b);
+        a->backward(tmp_a);
+        b->backward(tmp_b);
+    }
+    void vjp_seeds() override
+    {
+        ew_div_into(seed_grad, b->value, tmp_a);
+        ew_mul_into(tmp_a, value, tmp_b);
+        ew_affine_into(tmp_b, -1.0, 0.0, tmp_b);
+        a->backward_seeds(tmp_a);
+        b->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        // ẏ = (Ȧ - y ⊙ Ḃ) / B
+        tangent = ew_div(ew_sub(a->tangent, ew_mul(value, b->tangent)), b->value);
+    }
+    void backward_dual() override
+    {
+        // dA = g / B           -> (ġ - dA ⊙ Ḃ) / B
+        // dB = -dA ⊙ y         -> -(ḋA ⊙ y + dA ⊙ ẏ)
+        const Tensor &B = b->value;
+        Tensor dA = ew_div(grad, B);
+        Tensor dA_dot = ew_div(ew_sub(grad_tangent, ew_mul(dA, b->tangent)), B);
+        Tensor dB = ew_neg(ew_mul(dA, value));
+        Tensor dB_dot = ew_neg(ew_add(ew_mul(dA_dot, value), ew_mul(dA, tangent)));
+        a->accumulate_dual(dA, dA_dot);
+        b->accumulate_dual(dB, dB_dot);
     }
 };
 
@@ -150,23 +428,70 @@ class power : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        const Tensor Av = a->forward(), Bv = b->forward();
-        value = ew_pow(Av, Bv);
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
+    }
+    void compute() override
+    {
+        ew_pow_into(a->value, b->value, value);
     }
-    void backward(const Tensor &g) override
+    void vjp() override
     {
         // dy/da = b * a^(b-1) ; dy/db = ln(a) * a^b
-        Tensor one(a->value.shape.empty() ? std::vector<int64_t>{} : a->value.shape, 1.0);
-        Tensor b_minus_1 = ew_sub(b->value, one);
-        Tensor a_bm1 = ew_pow(a->value, b_minus_1);
-        Tensor dA = ew_mul(g, ew_mul(b->value, a_bm1));
-        Tensor dB = ew_mul(g, ew_mul(ew_ln(a->value), value));
-        a->backward(reduce_to_shape(dA, a->value.shape));
-        b->backward(reduce_to_shape(dB, b->value.shape));
+        ew_affine_into(b->value, 1.0, -1.0, tmp_b);
+        ew_pow_into(a->value, tmp_b, tmp_a);
+        ew_mul_into(tmp_a, b->value, tmp_a);
+        ew_mul_into(tmp_a, grad, tmp_a);
+        a->backward(tmp_a);
+        if (dynamic_cast<Constant *>(b.get()))
+            return; // skip ln(a) for the common constant-exponent case
+        ew_mul_into(grad, value, tmp_b);
+        ew_xlogy_into(tmp_b, a->value, tmp_b);
+        b->backward(tmp_b);
+    }
+    void vjp_seeds() override
+    {
+        ew_affine_into(b->value, 1.0, -1.0, tmp_b);
+        ew_pow_into(a->value, tmp_b, tmp_a);
+        ew_mul_into(tmp_a, b->value, tmp_a);
+        ew_mul_into(seed_grad, tmp_a, tmp_b);
+        a->backward_seeds(tmp_b);
+        if (dynamic_cast<Constant *>(b.get()))
+            return;
+        ew_mul_into(seed_grad, value, tmp_a);
+        ew_xlogy_into(tmp_a, a->value, tmp_a);
+        b->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        // ẏ = b a^(b-1) Ȧ + y ln(a) Ḃ   (second term vanishes when Ḃ = 0, even for a <= 0)
+        const Tensor &A = a->value, &B = b->value;
+        Tensor a_bm1 = ew_pow(A, ew_sub(B, Tensor::scalar(1.0)));
+        tangent = ew_add(ew_mul(ew_mul(B, a_bm1), a->tangent),
+                         ew_mul(value, ew_xlogy(b->tangent, A)));
+    }
+    void backward_dual() override
+    {
+        // dA = g b p, p = a^(b-1), ṗ = (b-1) a^(b-2) Ȧ + p ln(a) Ḃ
+        // dB = g ln(a) y          -> ln(a) (ġ y + g ẏ) + g p Ȧ
+        const Tensor &A = a->value, &B = b->value;
+        const Tensor one = Tensor::scalar(1.0);
+        Tensor b_minus_1 = ew_sub(B, one);
+        Tensor p = ew_pow(A, b_minus_1);
+        Tensor p_dot = ew_add(ew_mul(ew_mul(b_minus_1, ew_pow(A, ew_sub(b_minus_1, one))), a->tangent),
+                              ew_mul(p, ew_xlogy(b->tangent, A)));
+        Tensor dA = ew_mul(grad, ew_mul(B, p));
+        Tensor dA_dot = ew_add(ew_mul(grad_tangent, ew_mul(B, p)),
+                               ew_mul(grad, ew_add(ew_mul(b->tangent, p), ew_mul(B, p_dot))));
+        a->accumulate_dual(dA, dA_dot);
+        if (std::dynamic_pointer_cast<Constant>(b))
+            return; // ln(a) may be NaN for a <= 0; nothing to propagate anyway
+        Tensor ln_a = ew_ln(A);
+        Tensor dB = ew_mul(grad, ew_mul(ln_a, value));
+        Tensor dB_dot = ew_add(ew_mul(ln_a, ew_add(ew_mul(grad_tangent, value), ew_mul(grad, tangent))),
+                               ew_mul(grad, ew_mul(p, a->tangent)));
+        b->accumulate_dual(dB, dB_dot);
     }
 };
 
@@ -182,16 +507,34 @@ class ln_op : public UnaryOperator
 {
 public:
     using UnaryOperator::UnaryOperator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_ln(a->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return a->value.shape;
     }
-    void backward(const Tensor &g) override
+    void compute() override
     {
-        Tensor dA = ew_div(g, a->value);
-        a->backward(reduce_to_shape(dA, a->value.shape));
+        ew_ln_into(a->value, value);
+    }
+    void vjp() override
+    {
+        ew_div_into(grad, a->value, tmp_a);
+        a->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        ew_div_into(seed_grad, a->value, tmp_a);
+        a->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        tangent = ew_div(a->tangent, a->value);
+    }
+    void backward_dual() override
+    {
+        // dA = g / x -> (ġ - dA ⊙ ẋ) / x
+        Tensor dA = ew_div(grad, a->value);
+        Tensor dA_dot = ew_div(ew_sub(grad_tangent, ew_mul(dA, a->tangent)), a->value);
+        a->accumulate_dual(dA, dA_dot);
     }
 };
 
@@ -200,16 +543,32 @@ class exp_op : public UnaryOperator
 {
 public:
     using UnaryOperator::UnaryOperator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_exp(a->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return a->value.shape;
+    }
+    void compute() override
+    {
+        ew_exp_into(a->value, value);
+    }
+    void vjp() override
+    {
+        ew_mul_into(grad, value, tmp_a);
+        a->backward(tmp_a);
     }
-    void backward(const Tensor &g) override
+    void vjp_seeds() override
     {
-        Tensor dA = ew_mul(g, value);
-        a->backward(reduce_to_shape(dA, a->value.shape));
+        ew_mul_into(seed_grad, value, tmp_a);
+        a->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        tangent = ew_mul(value, a->tangent);
+    }
+    void backward_dual() override
+    {
+        a->accumulate_dual(ew_mul(grad, value),
+                           ew_add(ew_mul(grad_tangent, value), ew_mul(grad, tangent)));
     }
 };
 
@@ -218,19 +577,345 @@ class sqrt_op : public UnaryOperator
 {
 public:
     using UnaryOperator::UnaryOperator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_sqrt(a->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return a->value.shape;
+    }
+    void compute() override
+    {
+        ew_sqrt_into(a->value, value);
     }
-    void backward(const Tensor &g) override
+    void vjp() override
     {
         // 0.5 / sqrt(x) = 0.5 / value
-        Tensor half = Tensor::like(value, 0.0);
-        half.data.assign(half.size(), 0.5);
-        Tensor dA = ew_div(g, ew_mul(value, half));
-        a->backward(reduce_to_shape(dA, a->value.shape));
+        ew_div_into(grad, value, tmp_a);
+        ew_affine_into(tmp_a, 0.5, 0.0, tmp_a);
+        a->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        ew_div_into(seed_grad, value, tmp_a);
+        ew_affine_into(tmp_a, 0.5, 0.0, tmp_a);
+        a->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        tangent = ew_div(a->tangent, ew_mul(value, Tensor::scalar(2.0)));
+    }
+    void backward_dual() override
+    {
+        // dA = g / (2y) -> (ġ - 2 dA ⊙ ẏ) / (2y)
+        Tensor two_y = ew_mul(value, Tensor::scalar(2.0));
+        Tensor dA = ew_div(grad, two_y);
+        Tensor dA_dot = ew_div(ew_sub(grad_tangent, ew_mul(ew_mul(dA, tangent), Tensor::scalar(2.0))), two_y);
+        a->accumulate_dual(dA, dA_dot);
+    }
+};
+
+// Inverted dropout: while training, zeroes each element with probability p and scales the rest
+// by 1/(1-p); otherwise the identity. The mask is never stored: each forward reserves a counter
+// range from the generator and the backward regenerates the same mask from it.
+class dropout : public UnaryOperator
+{
+public:
+    double p;
+    bool training = true;
+    dropout(NodePtr x, double prob, const std::string &n = "", std::shared_ptr<Generator> g = nullptr)
+        : UnaryOperator(std::move(x), n), p(prob), gen(g ? std::move(g) : Generator::global())
+    {
+        if (!(p >= 0.0 && p <= 1.0))
+            throw std::runtime_error("dropout: p must be in [0, 1]");
+    }
+    Shape infer_shape() const override
+    {
+        return a->value.shape;
+    }
+    std::vector<int64_t> attributes() const override
+    {
+        int64_t bits;
+        std::memcpy(&bits, &p, sizeof bits);
+        return {bits};
+    }
+    bool randomized() const override { return p > 0.0; }
+    // (a masked value must also be recomputed once after training is switched off)
+    bool stochastic() const override { return (training && p > 0.0) || masked; }
+    void compute() override
+    {
+        masked = training && p > 0.0;
+        if (!masked)
+        {
+            value = a->value;
+            return;
+        }
+        draw(a->value.size(), seed, offset);
+        ::dropout_into(a->value, p, seed, offset, value);
+    }
+    // Seed and first counter of a fresh mask over n elements from this node's generator (also
+    // used by Tape, so a compiled graph draws the same stream).
+    void draw(int64_t n, uint64_t &s, uint64_t &o) const
+    {
+        s = gen->seed;
+        o = gen->reserve(static_cast<uint64_t>(n + 3) / 4);
+    }
+    void vjp() override
+    {
+        if (!masked)
+        {
+            a->backward(grad);
+            return;
+        }
+        ::dropout_into(grad, p, seed, offset, tmp_a);
+        a->backward(tmp_a);
+    }
+    void jvp() override
+    {
+        if (masked)
+            ::dropout_into(a->tangent, p, seed, offset, tangent);
+        else
+            tangent = a->tangent;
+    }
+    void backward_dual() override
+    {
+        if (!masked)
+        {
+            a->accumulate_dual(grad, grad_tangent);
+            return;
+        }
+        Tensor g, g_dot;
+        ::dropout_into(grad, p, seed, offset, g);
+        ::dropout_into(grad_tangent, p, seed, offset, g_dot);
+        a->accumulate_dual(g, g_dot);
+    }
+
+private:
+    std::shared_ptr<Generator> gen;
+    uint64_t seed = 0, offset = 0; // counters of the last forward's mask
+    bool masked = false;           // the last forward applied a mask
+};
+
+// ---------- softmax family: fused along 'axis' (max-shifted, no overflow) ----------
+// softmax(x)
+class softmax_op : public UnaryOperator
+{
+public:
+    int64_t axis;
+    explicit softmax_op(NodePtr x, const std::string &n = "", int64_t ax = -1)
+        : UnaryOperator(std::move(x), n), axis(ax) {}
+    Shape infer_shape() const override
+    {
+        normalize_axis(axis, a->value.shape.size(), "softmax");
+        return a->value.shape;
+    }
+    std::vector<int64_t> attributes() const override { return {axis}; }
+    void compute() override
+    {
+        ::softmax_into(a->value, axis, value);
+    }
+    void vjp() override
+    {
+        ::softmax_backward_into(value, grad, axis, tmp_a);
+        a->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        // y ⊙ (g - Σ g⊙y) with the reduction axis shifted past the seed axis
+        const int64_t ax = normalize_axis(axis, value.shape.size(), "softmax") + 1;
+        ew_mul_into(seed_grad, value, tmp_a);
+        ew_sub_into(seed_grad, ::sum_axis(tmp_a, ax), tmp_a);
+        ew_mul_into(tmp_a, value, tmp_a);
+        a->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        ::softmax_backward_into(value, a->tangent, axis, tangent); // ẏ = y ⊙ (ẋ - Σ y⊙ẋ)
+    }
+    void backward_dual() override
+    {
+        // dA = y ⊙ (g - Σ g⊙y) -> ẏ ⊙ (g - Σ g⊙y) + y ⊙ (ġ - Σ ġ⊙y - Σ g⊙ẏ)
+        Tensor dA, dA_dot;
+        ::softmax_backward_into(value, grad, axis, dA);
+        ::softmax_backward_into(value, grad_tangent, axis, dA_dot);
+        Tensor centered = ew_sub(grad, ::sum_axis(ew_mul(grad, value), axis));
+        dA_dot = ew_sub(ew_add(dA_dot, ew_mul(tangent, centered)),
+                        ew_mul(value, ::sum_axis(ew_mul(grad, tangent), axis)));
+        a->accumulate_dual(dA, dA_dot);
+    }
+};
+
+// log_softmax(x) = x - logsumexp(x)
+class log_softmax_op : public UnaryOperator
+{
+public:
+    int64_t axis;
+    explicit log_softmax_op(NodePtr x, const std::string &n = "", int64_t ax = -1)
+        : UnaryOperator(std::move(x), n), axis(ax) {}
+    Shape infer_shape() const override
+    {
+        normalize_axis(axis, a->value.shape.size(), "log_softmax");
+        return a->value.shape;
+    }
+    std::vector<int64_t> attributes() const override { return {axis}; }
+    void compute() override
+    {
+        ::log_softmax_into(a->value, axis, value);
+    }
+    void vjp() override
+    {
+        ::log_softmax_backward_into(value, grad, axis, tmp_a);
+        a->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        // g - exp(y) Σ g
+        const int64_t ax = normalize_axis(axis, value.shape.size(), "log_softmax") + 1;
+        ew_exp_into(value, tmp_a);
+        ew_mul_into(tmp_a, ::sum_axis(seed_grad, ax), tmp_b);
+        ew_sub_into(seed_grad, tmp_b, tmp_b);
+        a->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        Tensor p = ew_exp(value);
+        tangent = ew_sub(a->tangent, ::sum_axis(ew_mul(p, a->tangent), axis));
+    }
+    void backward_dual() override
+    {
+        // dA = g - p Σ g (p = exp(y)) -> ġ - p Σ ġ - (p ⊙ ẏ) Σ g
+        Tensor dA, dA_dot;
+        ::log_softmax_backward_into(value, grad, axis, dA);
+        ::log_softmax_backward_into(value, grad_tangent, axis, dA_dot);
+        dA_dot = ew_sub(dA_dot, ew_mul(ew_mul(ew_exp(value), tangent), ::sum_axis(grad, axis)));
+        a->accumulate_dual(dA, dA_dot);
+    }
+};
+
+// logsumexp(x) along 'axis' (kept with size 1, so the result broadcasts against x)
+class logsumexp_op : public UnaryOperator
+{
+public:
+    int64_t axis;
+    explicit logsumexp_op(NodePtr x, const std::string &n = "", int64_t ax = -1)
+        : UnaryOperator(std::move(x), n), axis(ax) {}
+    Shape infer_shape() const override
+    {
+        auto s = a->value.shape;
+        s[static_cast<size_t>(normalize_axis(axis, s.size(), "logsumexp"))] = 1;
+        return s;
+    }
+    std::vector<int64_t> attributes() const override { return {axis}; }
+    void compute() override
+    {
+        ::logsumexp_into(a->value, axis, value);
+    }
+    void vjp() override
+    {
+        ::logsumexp_backward_into(a->value, value, grad, axis, tmp_a);
+        a->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        // g ⊙ exp(x - y)
+        ew_sub_into(a->value, value, tmp_a);
+        ew_exp_into(tmp_a, tmp_a);
+        ew_mul_into(seed_grad, tmp_a, tmp_b);
+        a->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        Tensor p = ew_exp(ew_sub(a->value, value));
+        tangent = ::sum_axis(ew_mul(p, a->tangent), axis);
+    }
+    void backward_dual() override
+    {
+        // dA = g ⊙ p (p = softmax(x)) -> ġ ⊙ p + g ⊙ p ⊙ (ẋ - ẏ)
+        Tensor p = ew_exp(ew_sub(a->value, value));
+        Tensor dA = ew_mul(grad, p);
+        Tensor dA_dot = ew_add(ew_mul(grad_tangent, p), ew_mul(dA, ew_sub(a->tangent, tangent)));
+        a->accumulate_dual(dA, dA_dot);
+    }
+};
+
+// softmax_cross_entropy(logits, target): mean over rows of -Σ target ⊙ log_softmax(logits),
+// rows being every index of the non-'axis' dimensions. Targets are probabilities (e.g. one-hot).
+class softmax_cross_entropy : public Operator
+{
+public:
+    int64_t axis;
+    softmax_cross_entropy(NodePtr logits, NodePtr target, const std::string &n = "", int64_t ax = -1)
+        : Operator(std::move(logits), std::move(target), n), axis(ax) {}
+    Shape infer_shape() const override
+    {
+        if (a->value.shape != b->value.shape)
+            throw std::runtime_error("softmax_cross_entropy: logits and target must have the same shape");
+        normalize_axis(axis, a->value.shape.size(), "softmax_cross_entropy");
+        return {};
+    }
+    std::vector<int64_t> attributes() const override { return {axis}; }
+    void compute() override
+    {
+        ::softmax_cross_entropy_into(a->value, b->value, axis, logp, value);
+    }
+    void vjp() override
+    {
+        // dX = g/R (softmax(x) Σt - t) ; dT = -g/R log_softmax(x)
+        const double scale = grad.data[0] / rows();
+        ::softmax_cross_entropy_backward_into(logp, b->value, axis, scale, tmp_a);
+        a->backward(tmp_a);
+        if (!std::dynamic_pointer_cast<Constant>(b))
+        {
+            ew_affine_into(logp, -scale, 0.0, tmp_b);
+            b->backward(tmp_b);
+        }
+    }
+    void vjp_seeds() override
+    {
+        // per-seed scalar g times the g = 1 gradients
+        const Tensor g = seed_column(logp.shape.size());
+        ::softmax_cross_entropy_backward_into(logp, b->value, axis, 1.0 / rows(), tmp_a);
+        ew_mul_into(g, tmp_a, tmp_b);
+        a->backward_seeds(tmp_b);
+        if (!std::dynamic_pointer_cast<Constant>(b))
+        {
+            ew_affine_into(logp, -1.0 / rows(), 0.0, tmp_a);
+            ew_mul_into(g, tmp_a, tmp_b);
+            b->backward_seeds(tmp_b);
+        }
+    }
+    void jvp() override
+    {
+        // L̇ = -(1/R) Σ [ṫ ⊙ logp + t ⊙ (ẋ - Σ p⊙ẋ)]
+        Tensor logp_dot = ew_sub(a->tangent, ::sum_axis(ew_mul(ew_exp(logp), a->tangent), axis));
+        double acc = 0.0;
+        for (int64_t i = 0; i < logp.size(); ++i)
+            acc += b->tangent.data[i] * logp.data[i] + b->value.data[i] * logp_dot.data[i];
+        tangent = Tensor::scalar(-acc / rows());
+    }
+    void backward_dual() override
+    {
+        const double R = rows(), g = grad.data[0], g_dot = grad_tangent.data[0];
+        const Tensor &t = b->value, &t_dot = b->tangent;
+        Tensor p = ew_exp(logp);
+        Tensor logp_dot = ew_sub(a->tangent, ::sum_axis(ew_mul(p, a->tangent), axis));
+        Tensor T = ::sum_axis(t, axis), T_dot = ::sum_axis(t_dot, axis);
+        // dX = g/R (p T - t) -> ġ/R (p T - t) + g/R (p ⊙ logp_dot T + p Ṫ - ṫ)
+        Tensor pT_minus_t = ew_sub(ew_mul(p, T), t);
+        Tensor dX = ew_mul(pT_minus_t, Tensor::scalar(g / R));
+        Tensor dX_dot = ew_add(ew_mul(pT_minus_t, Tensor::scalar(g_dot / R)),
+                               ew_mul(ew_sub(ew_mul(p, ew_add(ew_mul(logp_dot, T), T_dot)), t_dot),
+                                      Tensor::scalar(g / R)));
+        a->accumulate_dual(dX, dX_dot);
+        b->accumulate_dual(ew_mul(logp, Tensor::scalar(-g / R)),
+                           ew_add(ew_mul(logp, Tensor::scalar(-g_dot / R)), ew_mul(logp_dot, Tensor::scalar(-g / R))));
+    }
+
+    int64_t scratch_bytes() const override { return Operator::scratch_bytes() + logp.nbytes(); }
+
+private:
+    Tensor logp; // log_softmax(logits) from compute(), reused by the backward pass
+    double rows() const
+    {
+        const auto &s = a->value.shape;
+        return static_cast<double>(a->value.size() / s[static_cast<size_t>(normalize_axis(axis, s.size(), "softmax_cross_entropy"))]);
     }
 };
 
@@ -239,26 +924,67 @@ class log_base : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ew_div(ew_ln(a->forward()), ew_ln(b->forward()));
-        grad = Tensor::like(value, 0.0);
-        return value;
+        return broadcast_shape(a->value.shape, b->value.shape);
     }
-    void backward(const Tensor &g) override
+    void compute() override
     {
-        // d/dx: 1/(x ln b) ; d/db: -ln(x)/(b (ln b)^2)
-        Tensor ln_b = ew_ln(b->value);
-        Tensor dxa = ew_div(g, ew_mul(a->value, ln_b));
+        ew_ln_into(a->value, tmp_a);
+        ew_ln_into(b->value, tmp_b);
+        ew_div_into(tmp_a, tmp_b, value);
+    }
+    void vjp() override
+    {
+        // d/dx: 1/(x ln b) ; d/db: -ln(x)/(b (ln b)^2) = -y/(b ln b)
+        ew_ln_into(b->value, tmp_b);
+        ew_mul_into(a->value, tmp_b, tmp_a);
+        ew_div_into(grad, tmp_a, tmp_a);
+        a->backward(tmp_a);
 
-        Tensor ln_b_sq = ew_mul(ln_b, ln_b);
-        Tensor denom = ew_mul(b->value, ln_b_sq);
-        Tensor db = ew_div(ew_mul(g, ew_ln(a->value)), denom);
-        for (auto &v : db.data)
-            v = -v;
+        ew_mul_into(b->value, tmp_b, tmp_b);
+        ew_mul_into(grad, value, tmp_a);
+        ew_div_into(tmp_a, tmp_b, tmp_a);
+        ew_affine_into(tmp_a, -1.0, 0.0, tmp_a);
+        b->backward(tmp_a);
+    }
+    void vjp_seeds() override
+    {
+        const Tensor ln_b = ew_ln(b->value);
+        ew_div_into(seed_grad, ew_mul(a->value, ln_b), tmp_a);
+        a->backward_seeds(tmp_a);
+        ew_mul_into(seed_grad, value, tmp_a);
+        ew_div_into(tmp_a, ew_mul(b->value, ln_b), tmp_a);
+        ew_affine_into(tmp_a, -1.0, 0.0, tmp_a);
+        b->backward_seeds(tmp_a);
+    }
+    void jvp() override
+    {
+        // ẏ = ẋ/(x ln b) - y ḃ/(b ln b)
+        Tensor ln_b = ew_ln(b->value);
+        tangent = ew_sub(ew_div(a->tangent, ew_mul(a->value, ln_b)),
+                         ew_div(ew_mul(value, b->tangent), ew_mul(b->value, ln_b)));
+    }
+    void backward_dual() override
+    {
+        // u = x ln b, w = b ln b
+        // dx = g / u  -> (ġ - dx ⊙ u̇) / u,   u̇ = ẋ ln b + x ḃ / b
+        // db = -r, r = g y / w -> ṙ = (ġ y + g ẏ - r ẇ) / w,  ẇ = ḃ (ln b + 1)
+        const Tensor &X = a->value, &B = b->value;
+        Tensor ln_b = ew_ln(B);
+        Tensor u = ew_mul(X, ln_b);
+        Tensor u_dot = ew_add(ew_mul(a->tangent, ln_b), ew_div(ew_mul(X, b->tangent), B));
+        Tensor dx = ew_div(grad, u);
+        Tensor dx_dot = ew_div(ew_sub(grad_tangent, ew_mul(dx, u_dot)), u);
 
-        a->backward(reduce_to_shape(dxa, a->value.shape));
-        b->backward(reduce_to_shape(db, b->value.shape));
+        Tensor w = ew_mul(B, ln_b);
+        Tensor w_dot = ew_mul(b->tangent, ew_add(ln_b, Tensor::scalar(1.0)));
+        Tensor r = ew_div(ew_mul(grad, value), w);
+        Tensor r_dot = ew_div(ew_sub(ew_add(ew_mul(grad_tangent, value), ew_mul(grad, tangent)),
+                                     ew_mul(r, w_dot)),
+                              w);
+        a->accumulate_dual(dx, dx_dot);
+        b->accumulate_dual(ew_neg(r), ew_neg(r_dot));
     }
 };
 
@@ -267,54 +993,307 @@ class matmul : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ::matmul2d(a->forward(), b->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        require_matmul_shapes_2d(a->value, b->value, "matmul");
+        return {a->value.shape[0], b->value.shape[1]};
     }
-    void backward(const Tensor &g) override
+    void compute() override
+    {
+        if (int8.enabled)
+            int8.run(a->value, nullptr, Activation::None, value);
+        else
+            ::matmul2d_into(a->value, b->value, value);
+    }
+    void vjp() override
     {
         // dA = g @ B^T ; dB = A^T @ g
-        const Tensor &A = a->value;
-        const Tensor &B = b->value;
+        ::matmul2d_into(grad, b->value, tmp_a, false, true);
+        a->backward(tmp_a);
+        ::matmul2d_into(a->value, grad, tmp_b, true, false);
+        b->backward(tmp_b);
+    }
+    void vjp_seeds() override
+    {
+        if (!std::dynamic_pointer_cast<Constant>(a))
+        {
+            seeds_grad_a(seed_grad, b->value, tmp_a);
+            a->backward_seeds(tmp_a);
+        }
+        if (!std::dynamic_pointer_cast<Constant>(b))
+        {
+            seeds_grad_b(a->value, seed_grad, tmp_b, tmp_a);
+            b->backward_seeds(tmp_b);
+        }
+    }
 
-        // Build B^T and A^T views (materialize for simplicity)
-        Tensor Bt({B.shape[1], B.shape[0]});
-        for (int64_t i = 0; i < B.shape[0]; ++i)
-            for (int64_t j = 0; j < B.shape[1]; ++j)
-                Bt.data[j * Bt.strides[0] + i * Bt.strides[1]] = B.data[i * B.strides[0] + j * B.strides[1]];
+    // Seed-batched matmul VJPs for G (S,m,n), each one GEMM over all seeds:
+    // dA_s = G_s @ B^T -> (S,m,k) ; dB_s = A^T @ G_s -> (S,k,n) ('work' is scratch)
+    static void seeds_grad_a(Tensor &G, const Tensor &B, Tensor &dA)
+    {
+        const Shape gs = G.shape;
+        G.reshape({gs[0] * gs[1], gs[2]});
+        ::matmul2d_into(G, B, dA, false, true);
+        G.reshape(gs);
+        dA.reshape({gs[0], gs[1], dA.shape[1]});
+    }
+    static void seeds_grad_b(const Tensor &A, const Tensor &G, Tensor &dB, Tensor &work)
+    {
+        const int64_t S = G.shape[0], n = G.shape[2], k = A.shape[1];
+        ::swap_leading_axes_into(G, work); // (m,S,n)
+        work.reshape({work.shape[0], S * n});
+        ::matmul2d_into(A, work, dB, true, false); // (k, S*n)
+        dB.reshape({k, S, n});
+        ::swap_leading_axes_into(dB, work);
+        std::swap(dB, work);
+    }
+    void jvp() override
+    {
+        tangent = ew_add(::matmul2d(a->tangent, b->value), ::matmul2d(a->value, b->tangent));
+    }
+    void backward_dual() override
+    {
+        // d(g B^T)/dt = ġ B^T + g Ḃ^T ; d(A^T g)/dt = Ȧ^T g + A^T ġ
+        Tensor Bt = ::transpose2d(b->value), At = ::transpose2d(a->value);
+        a->accumulate_dual(::matmul2d(grad, Bt),
+                           ew_add(::matmul2d(grad_tangent, Bt), ::matmul2d(grad, ::transpose2d(b->tangent))));
+        b->accumulate_dual(::matmul2d(At, grad),
+                           ew_add(::matmul2d(::transpose2d(a->tangent), grad), ::matmul2d(At, grad_tangent)));
+    }
+    int64_t scratch_bytes() const override { return Operator::scratch_bytes() + int8.bytes(); }
+    QuantizedGemm *quantized_gemm() override { return &int8; }
 
-        Tensor At({A.shape[1], A.shape[0]});
-        for (int64_t i = 0; i < A.shape[0]; ++i)
-            for (int64_t j = 0; j < A.shape[1]; ++j)
-                At.data[j * At.strides[0] + i * At.strides[1]] = A.data[i * A.strides[0] + j * A.strides[1]];
+private:
+    QuantizedGemm int8;
+};
 
-        a->backward(::matmul2d(g, Bt));
-        b->backward(::matmul2d(At, g));
+// linear(X,W,bias) = act(X @ W + bias): (m,k) @ (k,n) + (n,) -> (m,n). bias may be null.
+// One GEMM with the bias and activation fused into its epilogue; the backward fuses act' and
+// the bias reduction into a single pass before the two GEMMs for dX and dW.
+class linear : public Operator
+{
+public:
+    Activation act;
+    linear(NodePtr x, NodePtr w, NodePtr bias, const std::string &n = "", Activation activation = Activation::None)
+        : Operator(std::move(x), std::move(w), n), act(activation)
+    {
+        c = std::move(bias);
+    }
+    Shape infer_shape() const override
+    {
+        require_matmul_shapes_2d(a->value, b->value, "linear");
+        const int64_t n = b->value.shape[1];
+        if (c && !(c->value.size() == n && (c->value.shape.size() == 1 ||
+                                            (c->value.shape.size() == 2 && c->value.shape[0] == 1))))
+            throw std::runtime_error("linear: bias must have shape (n,) or (1, n) with n = " + std::to_string(n));
+        return {a->value.shape[0], n};
+    }
+    std::vector<int64_t> attributes() const override { return {static_cast<int64_t>(act)}; }
+    void compute() override
+    {
+        if (int8.enabled)
+            int8.run(a->value, c ? &c->value : nullptr, act, value);
+        else
+            ::linear_into(a->value, b->value, c ? &c->value : nullptr, act, value, pre);
+    }
+    void vjp() override
+    {
+        // dZ = g ⊙ act'(z) ; dX = dZ @ W^T ; dW = X^T @ dZ ; db = Σ_rows dZ
+        if (c)
+            db.ensure_shape(c->value.shape);
+        ::linear_backward_into(grad, value, pre, act, dZ, c ? &db : nullptr);
+        if (!std::dynamic_pointer_cast<Constant>(a))
+        {
+            ::matmul2d_into(dZ, b->value, tmp_a, false, true);
+            a->backward(tmp_a);
+        }
+        if (!std::dynamic_pointer_cast<Constant>(b))
+        {
+            ::matmul2d_into(a->value, dZ, tmp_b, true, false);
+            b->backward(tmp_b);
+        }
+        if (c)
+            c->backward(db);
+    }
+    void vjp_seeds() override
+    {
+        // dZ = G ⊙ act'(z) for every seed (act' from the cached output, as in vjp), then the
+        // seed-batched matmul rules; without an activation dZ is the seed block itself
+        if (act != Activation::None)
+            ::linear_backward_into(seed_grad, value, pre, act, dZ, nullptr);
+        Tensor &g = act != Activation::None ? dZ : seed_grad;
+        if (!std::dynamic_pointer_cast<Constant>(a))
+        {
+            matmul::seeds_grad_a(g, b->value, tmp_a);
+            a->backward_seeds(tmp_a);
+        }
+        if (!std::dynamic_pointer_cast<Constant>(b))
+        {
+            matmul::seeds_grad_b(a->value, g, tmp_b, tmp_a);
+            b->backward_seeds(tmp_b);
+        }
+        if (c)
+            c->backward_seeds(g);
+    }
+    void jvp() override
+    {
+        const Tensor z = preactivation();
+        tangent = ew_mul(::activation_eval(z, act, 1), preactivation_tangent());
+    }
+    void backward_dual() override
+    {
+        // dZ = g ⊙ act'(z) -> ġ ⊙ act'(z) + g ⊙ act''(z) ⊙ ż ; then the bilinear matmul rules
+        const Tensor z = preactivation(), z_dot = preactivation_tangent();
+        const Tensor slope = ::activation_eval(z, act, 1);
+        Tensor g_z = ew_mul(grad, slope);
+        Tensor g_z_dot = ew_add(ew_mul(grad_tangent, slope),
+                                ew_mul(grad, ew_mul(::activation_eval(z, act, 2), z_dot)));
+        Tensor t1, t2;
+        ::matmul2d_into(g_z, b->value, t1, false, true);
+        ::matmul2d_into(g_z_dot, b->value, t2, false, true);
+        Tensor t3;
+        ::matmul2d_into(g_z, b->tangent, t3, false, true);
+        a->accumulate_dual(t1, ew_add(t2, t3));
+        ::matmul2d_into(a->value, g_z, t1, true, false);
+        ::matmul2d_into(a->tangent, g_z, t2, true, false);
+        ::matmul2d_into(a->value, g_z_dot, t3, true, false);
+        b->accumulate_dual(t1, ew_add(t2, t3));
+        if (c)
+            c->accumulate_dual(g_z, g_z_dot);
+    }
+
+    void release_seed_scratch() override
+    {
+        Operator::release_seed_scratch();
+        dZ = Tensor();
+    }
+
+    int64_t scratch_bytes() const override
+    {
+        return Operator::scratch_bytes() + pre.nbytes() + dZ.nbytes() + db.nbytes() + int8.bytes();
+    }
+    QuantizedGemm *quantized_gemm() override { return &int8; }
+
+private:
+    Tensor pre, dZ, db; // pre-activation (GELU only), fused backward buffers
+    QuantizedGemm int8;
+
+    Tensor preactivation() const
+    {
+        Tensor z = ::matmul2d(a->value, b->value);
+        return c ? ew_add(z, c->value) : z;
+    }
+    Tensor preactivation_tangent() const
+    {
+        Tensor z_dot = ew_add(::matmul2d(a->tangent, b->value), ::matmul2d(a->value, b->tangent));
+        return c ? ew_add(z_dot, c->tangent) : z_dot;
     }
 };
 
+// conv2d(x,w): (N,C,H,W) * (F,C/groups,KH,KW) -> (N,F,OH,OW)
+class conv2d : public Operator
+{
+public:
+    Conv2dParams params;
+    conv2d(NodePtr x, NodePtr w, const std::string &n = "", const Conv2dParams &p = {})
+        : Operator(std::move(x), std::move(w), n), params(p) {}
+    Shape infer_shape() const override
+    {
+        return ::conv2d_shape(a->value.shape, b->value.shape, params);
+    }
+    std::vector<int64_t> attributes() const override
+    {
+        return {params.stride[0], params.stride[1], params.padding[0], params.padding[1],
+                params.dilation[0], params.dilation[1], params.groups};
+    }
+    void compute() override
+    {
+        ::conv2d_into(a->value, b->value, params, value, cols);
+    }
+    void vjp() override
+    {
+        // dX = col2im(W^T @ g) ; dW = sum_n g @ im2col(X)^T (skipped for Constant inputs)
+        if (!dynamic_cast<Constant *>(a.get()))
+        {
+            ::conv2d_grad_input_into(grad, b->value, a->value.shape, params, tmp_a, cols);
+            a->backward(tmp_a);
+        }
+        if (!dynamic_cast<Constant *>(b.get()))
+        {
+            ::conv2d_grad_weight_into(grad, a->value, b->value.shape, params, tmp_b, cols);
+            b->backward(tmp_b);
+        }
+    }
+    void jvp() override
+    {
+        tangent = ew_add(::conv2d_nchw(a->tangent, b->value, params), ::conv2d_nchw(a->value, b->tangent, params));
+    }
+    void backward_dual() override
+    {
+        // bilinear: d(dX)/dt = dX(ġ, W) + dX(g, Ẇ) ; d(dW)/dt = dW(ġ, X) + dW(g, Ẋ)
+        Tensor g1, g2, g3, g4;
+        ::conv2d_grad_input_into(grad, b->value, a->value.shape, params, g1, cols);
+        ::conv2d_grad_input_into(grad_tangent, b->value, a->value.shape, params, g2, cols);
+        ::conv2d_grad_input_into(grad, b->tangent, a->value.shape, params, g3, cols);
+        a->accumulate_dual(g1, ew_add(g2, g3));
+        ::conv2d_grad_weight_into(grad, a->value, b->value.shape, params, g1, cols);
+        ::conv2d_grad_weight_into(grad_tangent, a->value, b->value.shape, params, g2, cols);
+        ::conv2d_grad_weight_into(grad, a->tangent, b->value.shape, params, g4, cols);
+        b->accumulate_dual(g1, ew_add(g2, g4));
+    }
+
+    int64_t scratch_bytes() const override
+    {
+        return Operator::scratch_bytes() + cols.bytes();
+    }
+
+private:
+    TensorStorage cols; // im2col workspace, reused across steps
+};
+
 // dot(a,b) for 1D → scalar
 class dot : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ::dotvec(a->forward(), b->forward()); // scalar {}
-        grad = Tensor::like(value, 0.0);
-        return value;
+        const auto &sa = a->value.shape, &sb = b->value.shape;
+        if (!(sa.size() == 1 && sb.size() == 1 && sa[0] == sb[0]))
+            throw std::runtime_error("dotvec: need same-length 1D vectors");
+        return {};
     }
-    void backward(const Tensor &g) override
+    void compute() override
     {
-        // dA = g * b ; dB = g * a (expand scalar g)
-        Tensor gA(b->value.shape, 0.0);
-        gA.data.assign(gA.size(), g.data[0]);
-        Tensor gB(a->value.shape, 0.0);
-        gB.data.assign(gB.size(), g.data[0]);
-        a->backward(ew_mul(gA, b->value));
-        b->backward(ew_mul(gB, a->value));
+        ::dotvec_into(a->value, b->value, value); // scalar {}
+    }
+    void vjp() override
+    {
+        // dA = g * b ; dB = g * a (scalar g broadcasts)
+        ew_mul_into(grad, b->value, tmp_a);
+        a->backward(tmp_a);
+        ew_mul_into(grad, a->value, tmp_b);
+        b->backward(tmp_b);
+    }
+    void vjp_seeds() override
+    {
+        const Tensor g = seed_column(1);
+        ew_mul_into(g, b->value, tmp_a);
+        a->backward_seeds(tmp_a);
+        ew_mul_into(g, a->value, tmp_b);
+        b->backward_seeds(tmp_b);
+    }
+    void jvp() override
+    {
+        tangent = ew_add(::dotvec(a->tangent, b->value), ::dotvec(a->value, b->tangent));
+    }
+    void backward_dual() override
+    {
+        // scalar g, ġ broadcast against the 1D operands
+        a->accumulate_dual(ew_mul(grad, b->value),
+                           ew_add(ew_mul(grad_tangent, b->value), ew_mul(grad, b->tangent)));
+        b->accumulate_dual(ew_mul(grad, a->value),
+                           ew_add(ew_mul(grad_tangent, a->value), ew_mul(grad, a->tangent)));
     }
 };
 
@@ -323,16 +1302,102 @@ class cross : public Operator
 {
 public:
     using Operator::Operator;
-    Tensor forward() override
+    Shape infer_shape() const override
     {
-        value = ::cross3(a->forward(), b->forward());
-        grad = Tensor::like(value, 0.0);
-        return value;
+        require_vec3(a->value, "cross3");
+        require_vec3(b->value, "cross3");
+        return {3};
+    }
+    void compute() override
+    {
+        ::cross3_into(a->value, b->value, value);
     }
-    void backward(const Tensor &g) override
+    void vjp() override
     {
         // dA = b × g ; dB = g × a
-        a->backward(::cross3(b->value, g));
-        b->backward(::cross3(g, a->value));
+        ::cross3_into(b->value, grad, tmp_a);
+        a->backward(tmp_a);
+        ::cross3_into(grad, a->value, tmp_b);
+        b->backward(tmp_b);
+    }
+    void jvp() override
+    {
+        tangent = ew_add(::cross3(a->tangent, b->value), ::cross3(a->value, b->tangent));
+    }
+    void backward_dual() override
+    {
+        a->accumulate_dual(::cross3(b->value, grad),
+                           ew_add(::cross3(b->tangent, grad), ::cross3(b->value, grad_tangent)));
+        b->accumulate_dual(::cross3(grad, a->value),
+                           ew_add(::cross3(grad_tangent, a->value), ::cross3(grad, a->tangent)));
+    }
+};
+
+// ---------- sparse leaf: CSR matrix (value/grad Tensors stay empty) ----------
+class SparseVariable : public Node
+{
+public:
+    CsrTensor csr;                   // (m,k)
+    std::vector<double> grad_values; // gradient at csr's nonzeros (sparsity preserving)
+    bool requires_grad;
+
+    SparseVariable(const CsrTensor &m, const std::string &n, bool trainable = true)
+        : Node(n), csr(m), requires_grad(trainable)
+    {
+        zero_grad();
+    }
+    Tensor forward() override { return value; }
+    void backward(const Tensor &) override { /* dense grads do not apply */ }
+    void backward_seeds(const Tensor &) override { /* treated as constant */ }
+    void accumulate_dual(const Tensor &, const Tensor &) override { /* treated as constant */ }
+    void zero_grad() override
+    {
+        if (requires_grad)
+            grad_values.assign(static_cast<size_t>(csr.nnz), 0.0);
+    }
+    CsrTensor grad_csr() const { return csr.with_values(grad_values); }
+};
+
+// sparse_matmul(S,D): (m,k)csr @ (k,n) -> (m,n)
+class sparse_matmul : public Operator
+{
+public:
+    using Operator::Operator;
+    SparseVariable &sparse() const
+    {
+        auto *s = dynamic_cast<SparseVariable *>(a.get());
+        if (!s)
+            throw std::runtime_error("sparse_matmul: first input must be a SparseVariable");
+        return *s;
+    }
+    Shape infer_shape() const override
+    {
+        const CsrTensor &S = sparse().csr;
+        const auto &sd = b->value.shape;
+        if (sd.size() != 2 || sd[0] != S.cols)
+            throw std::runtime_error("sparse_matmul: dense operand must be (" + std::to_string(S.cols) + ", n)");
+        return {S.rows, sd[1]};
+    }
+    void compute() override
+    {
+        ::spmm_into(sparse().csr, b->value, value);
+    }
+    void vjp() override
+    {
+        // dD = S^T @ g (dense) ; dS = (g @ D^T) restricted to S's nonzeros
+        SparseVariable &S = sparse();
+        ::spmm_t_into(S.csr, grad, tmp_b);
+        b->backward(tmp_b);
+        if (S.requires_grad)
+            ::sddmm_add_into(S.csr, grad, b->value, S.grad_values);
+    }
+    void jvp() override
+    {
+        tangent = ::spmm(sparse().csr, b->tangent);
+    }
+    void backward_dual() override
+    {
+        const CsrTensor &S = sparse().csr;
+        b->accumulate_dual(::spmm_t(S, grad), ::spmm_t(S, grad_tangent));
     }
 };
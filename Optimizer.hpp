@@ -0,0 +1,117 @@
+#pragma once
+#include <unordered_map>
+#include <vector>
+#include "Node.hpp"
+#include "Kernels.hpp"
+
+// Parameter update rule driven by Graph::train (or called directly after Graph::backward).
+// Each step updates every parameter in place with a single fused kernel launch.
+class Optimizer
+{
+public:
+    virtual ~Optimizer() = default;
+    // Update every parameter's value in place from its current grad.
+    virtual void step(const std::vector<NodePtr> &params) = 0;
+
+protected:
+    // Per-parameter state buffer (zero-initialized, resized if the parameter changes size).
+    static double *state_for(std::unordered_map<const Node *, TensorStorage> &state, const Node &p)
+    {
+        auto &buf = state[&p];
+        if (buf.size() != p.value.data.size())
+            buf.assign(p.value.data.size(), 0.0);
+        return buf.data();
+    }
+    static ParamSlice slice_of(Node &p)
+    {
+        if (p.grad.data.size() != p.value.data.size())
+            throw std::runtime_error("Optimizer: grad/value size mismatch for '" + p.name + "'");
+        p.mark_dirty(); // the slice is written in place
+        return ParamSlice{p.value.data.data(), p.grad.data.data(), nullptr, nullptr,
+                          static_cast<int64_t>(p.value.data.size())};
+    }
+};
+
+// ---------- SGD: w -= lr * (g + wd * w) ----------
+class SGD : public Optimizer
+{
+public:
+    double lr, weight_decay;
+    explicit SGD(double learning_rate, double wd = 0.0) : lr(learning_rate), weight_decay(wd) {}
+    void step(const std::vector<NodePtr> &params) override
+    {
+        std::vector<ParamSlice> ps;
+        ps.reserve(params.size());
+        for (auto &p : params)
+            ps.push_back(slice_of(*p));
+        sgd_update(ps, lr, weight_decay);
+    }
+};
+
+// ---------- SGD with (optionally Nesterov) momentum ----------
+class Momentum : public Optimizer
+{
+public:
+    double lr, mu, weight_decay;
+    bool nesterov;
+    Momentum(double learning_rate, double momentum = 0.9, double wd = 0.0, bool use_nesterov = false)
+        : lr(learning_rate), mu(momentum), weight_decay(wd), nesterov(use_nesterov) {}
+    void step(const std::vector<NodePtr> &params) override
+    {
+        std::vector<ParamSlice> ps;
+        ps.reserve(params.size());
+        for (auto &p : params)
+        {
+            ParamSlice s = slice_of(*p);
+            s.m = state_for(velocity, *p);
+            ps.push_back(s);
+        }
+        momentum_update(ps, lr, mu, weight_decay, nesterov);
+    }
+
+private:
+    std::unordered_map<const Node *, TensorStorage> velocity;
+};
+
+// ---------- Adam (L2 weight decay folded into the gradient) ----------
+class Adam : public Optimizer
+{
+public:
+    double lr, beta1, beta2, eps, weight_decay;
+    int64_t t = 0; // steps taken (bias correction)
+    Adam(double learning_rate = 1e-3, double b1 = 0.9, double b2 = 0.999, double epsilon = 1e-8,
+         double wd = 0.0)
+        : lr(learning_rate), beta1(b1), beta2(b2), eps(epsilon), weight_decay(wd) {}
+    void step(const std::vector<NodePtr> &params) override
+    {
+        std::vector<ParamSlice> ps;
+        ps.reserve(params.size());
+        for (auto &p : params)
+        {
+            ParamSlice s = slice_of(*p);
+            s.m = state_for(m1, *p);
+            s.v = state_for(m2, *p);
+            ps.push_back(s);
+        }
+        ++t;
+        adam_update(ps, lr, beta1, beta2, eps, weight_decay, decoupled(), t);
+    }
+
+protected:
+    virtual bool decoupled() const { return false; }
+
+private:
+    std::unordered_map<const Node *, TensorStorage> m1, m2;
+};
+
+// ---------- AdamW (decoupled weight decay) ----------
+class AdamW : public Adam
+{
+public:
+    AdamW(double learning_rate = 1e-3, double b1 = 0.9, double b2 = 0.999, double epsilon = 1e-8,
+          double wd = 1e-2)
+        : Adam(learning_rate, b1, b2, epsilon, wd) {}
+
+protected:
+    bool decoupled() const override { return true; }
+};
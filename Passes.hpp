@@ -0,0 +1,166 @@
+#pragma once
+#include <map>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "Node.hpp"
+
+// Nodes removed by each pass of the construction-time pipeline.
+struct PassReport
+{
+    int64_t folded = 0;     // constant folding
+    int64_t simplified = 0; // algebraic simplification
+    int64_t cse = 0;        // common-subexpression elimination
+};
+
+// ---------- helpers ----------
+inline int64_t count_nodes(const NodePtr &n, std::unordered_set<Node *> &seen)
+{
+    if (!n || !seen.insert(n.get()).second)
+        return 0;
+    int64_t c = 1;
+    if (auto op = dynamic_cast<Operator *>(n.get()))
+        c += count_nodes(op->a, seen) + count_nodes(op->b, seen) + count_nodes(op->c, seen);
+    return c;
+}
+
+inline int64_t count_nodes(const NodePtr &n)
+{
+    std::unordered_set<Node *> seen;
+    return count_nodes(n, seen);
+}
+
+// Bottom-up rewrite: inputs are rewritten (and re-wired) first, then 'fn' may return a
+// replacement for the node itself. Shared subgraphs are visited once.
+template <class Fn>
+NodePtr rewrite_nodes(const NodePtr &n, std::unordered_map<Node *, NodePtr> &memo, Fn &fn)
+{
+    if (!n)
+        return n;
+    auto it = memo.find(n.get());
+    if (it != memo.end())
+        return it->second;
+    if (auto op = dynamic_cast<Operator *>(n.get()))
+    {
+        op->a = rewrite_nodes(op->a, memo, fn);
+        op->b = rewrite_nodes(op->b, memo, fn);
+        op->c = rewrite_nodes(op->c, memo, fn);
+    }
+    NodePtr out = fn(n);
+    memo[n.get()] = out;
+    return out;
+}
+
+template <class Fn>
+int64_t run_pass(NodePtr &root, Fn fn)
+{
+    const int64_t before = count_nodes(root);
+    std::unordered_map<Node *, NodePtr> memo;
+    root = rewrite_nodes(root, memo, fn);
+    return before - count_nodes(root);
+}
+
+// A Constant that cannot be fed: its construction-time value may be baked into the graph.
+inline bool is_literal(const NodePtr &n)
+{
+    auto c = dynamic_cast<Constant *>(n.get());
+    return c && (c->literal || c->name.empty());
+}
+
+// Literal whose every element equals v.
+inline bool is_constant_fill(const NodePtr &n, double v)
+{
+    if (!is_literal(n))
+        return false;
+    for (double x : n->value.data)
+        if (x != v)
+            return false;
+    return true;
+}
+
+// True when broadcasting constant c against x cannot change x's shape. Operator shapes are
+// only known after a forward pass, so for them only scalar constants qualify.
+inline bool keeps_shape(const NodePtr &x, const NodePtr &c)
+{
+    if (c->value.is_scalar())
+        return true;
+    if (dynamic_cast<Operator *>(x.get()))
+        return false;
+    return broadcast_shape(x->value.shape, c->value.shape) == x->value.shape;
+}
+
+// ---------- passes ----------
+// Operators whose inputs are all literals become a literal holding the folded value.
+inline int64_t fold_constants(NodePtr &root)
+{
+    return run_pass(root, [](const NodePtr &n) -> NodePtr
+                    {
+        auto op = std::dynamic_pointer_cast<Operator>(n);
+        if (!op || op->randomized() || !is_literal(op->a) || (op->b && !is_literal(op->b)) ||
+            (op->c && !is_literal(op->c)))
+            return n;
+        op->compute();
+        return std::make_shared<Constant>(op->value, op->name, true); });
+}
+
+// x+0, 0+x, x-0, x*1, 1*x, x/1, x^1 -> x ; x^2 -> x*x
+inline int64_t simplify_algebra(NodePtr &root)
+{
+    return run_pass(root, [](const NodePtr &n) -> NodePtr
+                    {
+        auto op = std::dynamic_pointer_cast<Operator>(n);
+        if (!op || !op->b)
+            return n;
+        const NodePtr &x = op->a, &y = op->b;
+        const bool is_add = dynamic_cast<add *>(op.get()) != nullptr;
+        const bool is_mul = dynamic_cast<mul *>(op.get()) != nullptr;
+        if (is_add || dynamic_cast<sub *>(op.get()))
+        {
+            if (is_constant_fill(y, 0.0) && keeps_shape(x, y))
+                return x;
+            if (is_add && is_constant_fill(x, 0.0) && keeps_shape(y, x))
+                return y;
+        }
+        if (is_mul || dynamic_cast<divide *>(op.get()) || dynamic_cast<power *>(op.get()))
+        {
+            if (is_constant_fill(y, 1.0) && keeps_shape(x, y))
+                return x;
+            if (is_mul && is_constant_fill(x, 1.0) && keeps_shape(y, x))
+                return y;
+        }
+        if (dynamic_cast<power *>(op.get()) && is_constant_fill(y, 2.0) && keeps_shape(x, y))
+            return std::make_shared<mul>(x, x, op->name);
+        return n; });
+}
+
+// Hash-consing: operators keyed on (type, inputs, attributes). Leaves keep their identity (two
+// Constants holding equal values may be fed different data). add/mul are commutative, so their
+// inputs are keyed in pointer order.
+inline int64_t eliminate_common_subexpressions(NodePtr &root)
+{
+    std::map<std::tuple<std::type_index, Node *, Node *, Node *, std::vector<int64_t>>, NodePtr> ops;
+    return run_pass(root, [&](const NodePtr &n) -> NodePtr
+                    {
+        auto op = std::dynamic_pointer_cast<Operator>(n);
+        if (!op || op->randomized())
+            return n;
+        Node *x = op->a.get(), *y = op->b.get();
+        if ((dynamic_cast<add *>(op.get()) || dynamic_cast<mul *>(op.get())) && y < x)
+            std::swap(x, y);
+        return ops.emplace(std::make_tuple(std::type_index(typeid(*op)), x, y, op->c.get(), op->attributes()), n).first->second; });
+}
+
+// Full pipeline run at Graph construction. Rewires Operator inputs in place and may replace
+// the root; nodes that were merged away are no longer evaluated by the Graph.
+inline PassReport optimize_graph(NodePtr &root)
+{
+    PassReport r;
+    r.folded = fold_constants(root);
+    r.simplified = simplify_algebra(root);
+    r.cse = eliminate_common_subexpressions(root);
+    return r;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include "Kernels.hpp"
+
+// Source of counter-based random numbers (Philox4x32-10, see fill_uniform). It holds only a seed
+// and the next unused counter: every draw reserves a range of counters, and each element is a
+// pure function of (seed, counter), so results do not depend on the thread count. Restoring
+// (seed, offset) replays every later draw.
+class Generator
+{
+public:
+    uint64_t seed;
+
+    explicit Generator(uint64_t s = 0) : seed(s) {}
+
+    uint64_t offset() const { return next.load(); }
+    void set_offset(uint64_t o) { next = o; }
+    void manual_seed(uint64_t s)
+    {
+        seed = s;
+        next = 0;
+    }
+    // First of 'n' fresh counters (thread-safe).
+    uint64_t reserve(uint64_t n) { return next.fetch_add(n); }
+
+    // Shared by the factories and dropout nodes that are not given their own generator.
+    static const std::shared_ptr<Generator> &global()
+    {
+        static const std::shared_ptr<Generator> g = std::make_shared<Generator>();
+        return g;
+    }
+
+private:
+    std::atomic<uint64_t> next{0};
+};
+
+// Tensors of independent draws from 'gen'.
+inline Tensor random_uniform(const Shape &shape, double lo = 0.0, double hi = 1.0,
+                             Generator &gen = *Generator::global())
+{
+    Tensor t(shape, 0.0);
+    ::fill_uniform(t, gen.seed, gen.reserve(static_cast<uint64_t>(t.size() + 1) / 2), lo, hi);
+    return t;
+}
+
+inline Tensor random_normal(const Shape &shape, double mean = 0.0, double std = 1.0,
+                            Generator &gen = *Generator::global())
+{
+    Tensor t(shape, 0.0);
+    ::fill_normal(t, gen.seed, gen.reserve(static_cast<uint64_t>(t.size() + 1) / 2), mean, std);
+    return t;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "Tensor.hpp"
+
+// 2D sparse matrix in CSR form. Arrays are views: they point into buffers owned by 'owner',
+// which is either a C++ holder or an external object (e.g. SciPy arrays, borrowed without copies).
+// Indices are int64 or int32 (SciPy's default); exactly one of the two pointer pairs is set.
+struct CsrTensor
+{
+    int64_t rows = 0, cols = 0, nnz = 0;
+    const double *values = nullptr;
+    const int64_t *indptr64 = nullptr, *indices64 = nullptr;
+    const int32_t *indptr32 = nullptr, *indices32 = nullptr;
+    std::shared_ptr<const void> owner;
+
+    CsrTensor() = default;
+
+    // Owning constructor (indices are validated).
+    CsrTensor(int64_t r, int64_t c, std::vector<int64_t> indptr, std::vector<int64_t> indices,
+              std::vector<double> vals)
+    {
+        if (r <= 0 || c <= 0)
+            throw std::runtime_error("CsrTensor: bad shape");
+        if (static_cast<int64_t>(indptr.size()) != r + 1 || indptr.front() != 0 ||
+            indptr.back() != static_cast<int64_t>(indices.size()) || indices.size() != vals.size())
+            throw std::runtime_error("CsrTensor: inconsistent indptr/indices/values");
+        for (int64_t i = 0; i < r; ++i)
+            if (indptr[i] > indptr[i + 1])
+                throw std::runtime_error("CsrTensor: indptr must be non-decreasing");
+        for (auto j : indices)
+            if (j < 0 || j >= c)
+                throw std::runtime_error("CsrTensor: column index out of range");
+        auto h = std::make_shared<Holder>();
+        h->indptr = std::move(indptr);
+        h->indices = std::move(indices);
+        h->values = std::move(vals);
+        rows = r;
+        cols = c;
+        nnz = static_cast<int64_t>(h->values.size());
+        values = h->values.data();
+        indptr64 = h->indptr.data();
+        indices64 = h->indices.data();
+        owner = std::move(h);
+    }
+
+    static CsrTensor from_dense(const Tensor &D)
+    {
+        if (D.shape.size() != 2)
+            throw std::runtime_error("CsrTensor::from_dense: need 2D tensor");
+        std::vector<int64_t> indptr{0}, indices;
+        std::vector<double> vals;
+        for (int64_t i = 0; i < D.shape[0]; ++i)
+        {
+            for (int64_t j = 0; j < D.shape[1]; ++j)
+            {
+                const double v = D.data[i * D.strides[0] + j * D.strides[1]];
+                if (v != 0.0)
+                {
+                    indices.push_back(j);
+                    vals.push_back(v);
+                }
+            }
+            indptr.push_back(static_cast<int64_t>(indices.size()));
+        }
+        return CsrTensor(D.shape[0], D.shape[1], std::move(indptr), std::move(indices), std::move(vals));
+    }
+
+    // Same sparsity pattern (structure shared, not copied) with new values.
+    CsrTensor with_values(std::vector<double> vals) const
+    {
+        if (static_cast<int64_t>(vals.size()) != nnz)
+            throw std::runtime_error("CsrTensor::with_values: size mismatch");
+        auto h = std::make_shared<Holder>();
+        h->values = std::move(vals);
+        h->structure = owner;
+        CsrTensor out = *this;
+        out.values = h->values.data();
+        out.owner = std::move(h);
+        return out;
+    }
+
+    int64_t row_begin(int64_t i) const { return indptr64 ? indptr64[i] : indptr32[i]; }
+    int64_t col(int64_t p) const { return indices64 ? indices64[p] : indices32[p]; }
+
+    Tensor to_dense() const
+    {
+        Tensor D({rows, cols}, 0.0);
+        for (int64_t i = 0; i < rows; ++i)
+            for (int64_t p = row_begin(i); p < row_begin(i + 1); ++p)
+                D.data[i * cols + col(p)] += values[p];
+        return D;
+    }
+
+    std::string desc() const
+    {
+        return "CsrTensor([" + std::to_string(rows) + "," + std::to_string(cols) +
+               "], nnz=" + std::to_string(nnz) + ")";
+    }
+
+private:
+    struct Holder
+    {
+        std::vector<int64_t> indptr, indices;
+        std::vector<double> values;
+        std::shared_ptr<const void> structure; // keeps a shared pattern alive (with_values)
+    };
+};
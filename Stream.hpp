@@ -0,0 +1,88 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// In-order execution stream: one worker thread runs submitted tasks first-in first-out, so
+// everything submitted from one thread executes in submission order. Each task's result (or
+// exception) comes back through a future. The destructor finishes the queued tasks first.
+class ExecutionStream
+{
+public:
+    ExecutionStream() : worker([this]
+                               { run(); }) {}
+
+    ~ExecutionStream()
+    {
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            stopping = true;
+        }
+        cv.notify_all();
+        worker.join();
+    }
+
+    ExecutionStream(const ExecutionStream &) = delete;
+    ExecutionStream &operator=(const ExecutionStream &) = delete;
+
+    template <class F>
+    auto submit(F &&f) -> std::shared_future<decltype(f())>
+    {
+        using R = decltype(f());
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::shared_future<R> result = task->get_future().share();
+        {
+            std::lock_guard<std::mutex> lk(mu);
+            queue.emplace_back([task]
+                               { (*task)(); });
+        }
+        cv.notify_all();
+        return result;
+    }
+
+    // Block until every task submitted so far has run.
+    void synchronize()
+    {
+        std::unique_lock<std::mutex> lk(mu);
+        idle.wait(lk, [this]
+                  { return queue.empty() && !busy; });
+    }
+
+    bool on_stream() const { return std::this_thread::get_id() == worker.get_id(); }
+
+private:
+    void run()
+    {
+        for (;;)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lk(mu);
+                cv.wait(lk, [this]
+                        { return stopping || !queue.empty(); });
+                if (queue.empty())
+                    return;
+                task = std::move(queue.front());
+                queue.pop_front();
+                busy = true;
+            }
+            task(); // packaged_task: exceptions land in the future
+            {
+                std::lock_guard<std::mutex> lk(mu);
+                busy = false;
+            }
+            idle.notify_all();
+        }
+    }
+
+    std::mutex mu;
+    std::condition_variable cv, idle;
+    std::deque<std::function<void()>> queue;
+    bool busy = false, stopping = false;
+    std::thread worker; // last: started once the members above exist
+};
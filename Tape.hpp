@@ -0,0 +1,559 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Graph.hpp"
+
+enum class TapeOp : uint8_t
+{
+    Leaf,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Pow,
+    Ln,
+    Exp,
+    Sqrt,
+    Softmax,
+    LogSoftmax,
+    LogSumExp,
+    SoftmaxCrossEntropy,
+    LogBase,
+    MatMul,
+    Linear,
+    Conv2d,
+    Dot,
+    Cross,
+    SparseMatMul,
+    Dropout
+};
+
+// Flat compiled form of a Graph: a Wengert list in structure-of-arrays layout. Instruction i
+// (in topological order) has an opcode, up to three input slots (earlier instructions, -1 if
+// absent) and its own value/grad slot. forward() and backward() are single switch-dispatched
+// loops over these arrays: no virtual calls, shared_ptr traffic or name lookups per edge.
+// Leaves stay in the Graph's leaf nodes (values are read from them, grads written to them, so
+// optimizers step them as usual); operator values and scratch belong to the tape. Every
+// instruction runs the same kernels as its Operator, so results match Graph::forward/backward.
+class Tape
+{
+public:
+    explicit Tape(Graph &g)
+    {
+        g.synchronize();
+        const size_t n = g.order.size();
+        op.resize(n);
+        in.assign(n, {-1, -1, -1});
+        attr.assign(n, 0);
+        aux.assign(n, -1);
+        need.assign(n, 0);
+        leaf.assign(n, nullptr);
+        val.resize(n);
+        grd.resize(n);
+        values.resize(n); // sized once: val/grd point into these
+        grads.resize(n);
+        tmp_a.resize(n);
+        tmp_b.resize(n);
+
+        std::unordered_map<const Node *, int32_t> pos;
+        auto at = [&](const NodePtr &x)
+        { return x ? pos.at(x.get()) : -1; };
+        for (size_t i = 0; i < n; ++i)
+        {
+            Node *node = g.order[i].get();
+            pos[node] = static_cast<int32_t>(i);
+            slots.emplace(node->name, static_cast<int32_t>(i)); // first node of a repeated name
+            auto *o = dynamic_cast<Operator *>(node);
+            if (!o)
+            {
+                op[i] = TapeOp::Leaf;
+                leaf[i] = node;
+                leaves.push_back(g.order[i]);
+                val[i] = &node->value;
+                grd[i] = &node->grad;
+                auto *s = dynamic_cast<SparseVariable *>(node);
+                need[i] = dynamic_cast<Variable *>(node) || (s && s->requires_grad);
+                continue;
+            }
+            in[i] = {at(o->a), at(o->b), at(o->c)};
+            op[i] = classify(g.order[i], *o, i);
+            val[i] = &values[i];
+            grd[i] = &grads[i];
+            for (int32_t x : in[i])
+                need[i] = need[i] || (x >= 0 && need[x]);
+        }
+        root = pos.at(g.root.get());
+    }
+
+    size_t size() const { return op.size(); }
+    TapeOp opcode(size_t i) const { return op.at(i); }
+
+    // Instruction index of the node called 'name'.
+    int32_t slot(const std::string &name) const
+    {
+        auto it = slots.find(name);
+        if (it == slots.end())
+            throw std::runtime_error("Tape: no node named '" + name + "'");
+        return it->second;
+    }
+    const Tensor &value(int32_t i) const { return *val.at(static_cast<size_t>(i)); }
+    const Tensor &grad(int32_t i) const { return *grd.at(static_cast<size_t>(i)); }
+    const Tensor &value(const std::string &name) const { return value(slot(name)); }
+    const Tensor &grad(const std::string &name) const { return grad(slot(name)); }
+
+    // Recompute every operator from the leaves' current values; returns the root value.
+    const Tensor &forward()
+    {
+        const size_t n = op.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            const std::array<int32_t, 3> &x = in[i];
+            auto V = [&](int k) -> const Tensor &
+            { return *val[static_cast<size_t>(x[k])]; };
+            Tensor &y = values[i];
+            switch (op[i])
+            {
+            case TapeOp::Leaf:
+                break;
+            case TapeOp::Add:
+                ew_add_into(V(0), V(1), y);
+                break;
+            case TapeOp::Sub:
+                ew_sub_into(V(0), V(1), y);
+                break;
+            case TapeOp::Mul:
+                ew_mul_into(V(0), V(1), y);
+                break;
+            case TapeOp::Div:
+                ew_div_into(V(0), V(1), y);
+                break;
+            case TapeOp::Pow:
+                ew_pow_into(V(0), V(1), y);
+                break;
+            case TapeOp::Ln:
+                ew_ln_into(V(0), y);
+                break;
+            case TapeOp::Exp:
+                ew_exp_into(V(0), y);
+                break;
+            case TapeOp::Sqrt:
+                ew_sqrt_into(V(0), y);
+                break;
+            case TapeOp::Softmax:
+                ::softmax_into(V(0), attr[i], y);
+                break;
+            case TapeOp::LogSoftmax:
+                ::log_softmax_into(V(0), attr[i], y);
+                break;
+            case TapeOp::LogSumExp:
+                ::logsumexp_into(V(0), attr[i], y);
+                break;
+            case TapeOp::SoftmaxCrossEntropy:
+                ::softmax_cross_entropy_into(V(0), V(1), attr[i], extra[static_cast<size_t>(aux[i])], y);
+                break;
+            case TapeOp::LogBase:
+                ew_ln_into(V(0), tmp_a[i]);
+                ew_ln_into(V(1), tmp_b[i]);
+                ew_div_into(tmp_a[i], tmp_b[i], y);
+                break;
+            case TapeOp::MatMul:
+                ::matmul2d_into(V(0), V(1), y, false, false);
+                break;
+            case TapeOp::Linear:
+                ::linear_into(V(0), V(1), x[2] >= 0 ? &V(2) : nullptr, static_cast<Activation>(attr[i]), y,
+                              extra[static_cast<size_t>(aux[i])]);
+                break;
+            case TapeOp::Conv2d:
+            {
+                ConvSlot &cs = convs[static_cast<size_t>(aux[i])];
+                ::conv2d_into(V(0), V(1), cs.params, y, cs.cols);
+                break;
+            }
+            case TapeOp::Dot:
+                ::dotvec_into(V(0), V(1), y);
+                break;
+            case TapeOp::Cross:
+                ::cross3_into(V(0), V(1), y);
+                break;
+            case TapeOp::SparseMatMul:
+                ::spmm_into(sparse[static_cast<size_t>(aux[i])]->csr, V(1), y);
+                break;
+            case TapeOp::Dropout:
+            {
+                DropoutSlot &d = drops[static_cast<size_t>(aux[i])];
+                d.masked = d.node->training && d.node->p > 0.0;
+                if (!d.masked)
+                {
+                    y.ensure_shape(V(0).shape);
+                    std::copy(V(0).data.begin(), V(0).data.end(), y.data.begin());
+                    break;
+                }
+                d.node->draw(V(0).size(), d.seed, d.offset);
+                ::dropout_into(V(0), d.node->p, d.seed, d.offset, y);
+                break;
+            }
+            }
+        }
+        return *val[static_cast<size_t>(root)];
+    }
+
+    // Reverse sweep seeded with ones at the root (values must be current). Only instructions
+    // on a path to a trainable leaf run; leaf grads land in the Graph's nodes.
+    void backward()
+    {
+        const size_t n = op.size();
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (leaf[i])
+            {
+                if (need[i])
+                    leaf[i]->zero_grad();
+            }
+            else if (need[i] || i == static_cast<size_t>(root))
+            {
+                grads[i].ensure_shape(values[i].shape);
+                std::fill(grads[i].data.begin(), grads[i].data.end(), 0.0);
+            }
+        }
+        Tensor &seed = *grd[static_cast<size_t>(root)];
+        seed.ensure_shape(val[static_cast<size_t>(root)]->shape);
+        std::fill(seed.data.begin(), seed.data.end(), 1.0);
+
+        for (size_t i = n; i-- > 0;)
+        {
+            if (!need[i] || leaf[i])
+                continue;
+            const std::array<int32_t, 3> &x = in[i];
+            auto V = [&](int k) -> const Tensor &
+            { return *val[static_cast<size_t>(x[k])]; };
+            auto wants = [&](int k)
+            { return x[k] >= 0 && need[static_cast<size_t>(x[k])]; };
+            auto push = [&](int k, const Tensor &g)
+            {
+                if (wants(k))
+                    reduce_add_into(g, *grd[static_cast<size_t>(x[k])]);
+            };
+            const Tensor &g = grads[i], &y = values[i];
+            Tensor &ta = tmp_a[i], &tb = tmp_b[i];
+            switch (op[i])
+            {
+            case TapeOp::Leaf:
+                break;
+            case TapeOp::Add:
+                push(0, g);
+                push(1, g);
+                break;
+            case TapeOp::Sub:
+                push(0, g);
+                if (wants(1))
+                {
+                    ew_affine_into(g, -1.0, 0.0, tb);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::Mul:
+            case TapeOp::Dot:
+                if (wants(0))
+                {
+                    ew_mul_into(g, V(1), ta);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ew_mul_into(g, V(0), tb);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::Div:
+                ew_div_into(g, V(1), ta);
+                push(0, ta);
+                if (wants(1))
+                {
+                    ew_mul_into(ta, y, tb);
+                    ew_affine_into(tb, -1.0, 0.0, tb);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::Pow:
+                if (wants(0))
+                {
+                    ew_affine_into(V(1), 1.0, -1.0, tb);
+                    ew_pow_into(V(0), tb, ta);
+                    ew_mul_into(ta, V(1), ta);
+                    ew_mul_into(ta, g, ta);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ew_mul_into(g, y, tb);
+                    ew_xlogy_into(tb, V(0), tb);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::Ln:
+                ew_div_into(g, V(0), ta);
+                push(0, ta);
+                break;
+            case TapeOp::Exp:
+                ew_mul_into(g, y, ta);
+                push(0, ta);
+                break;
+            case TapeOp::Sqrt:
+                ew_div_into(g, y, ta);
+                ew_affine_into(ta, 0.5, 0.0, ta);
+                push(0, ta);
+                break;
+            case TapeOp::Softmax:
+                ::softmax_backward_into(y, g, attr[i], ta);
+                push(0, ta);
+                break;
+            case TapeOp::LogSoftmax:
+                ::log_softmax_backward_into(y, g, attr[i], ta);
+                push(0, ta);
+                break;
+            case TapeOp::LogSumExp:
+                ::logsumexp_backward_into(V(0), y, g, attr[i], ta);
+                push(0, ta);
+                break;
+            case TapeOp::SoftmaxCrossEntropy:
+            {
+                const Tensor &logits = V(0), &logp = extra[static_cast<size_t>(aux[i])];
+                const int64_t ax = normalize_axis(attr[i], logits.shape.size(), "softmax_cross_entropy");
+                const double scale = g.data[0] / static_cast<double>(logits.size() / logits.shape[ax]);
+                if (wants(0))
+                {
+                    ::softmax_cross_entropy_backward_into(logp, V(1), attr[i], scale, ta);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ew_affine_into(logp, -scale, 0.0, tb);
+                    push(1, tb);
+                }
+                break;
+            }
+            case TapeOp::LogBase:
+                ew_ln_into(V(1), tb);
+                if (wants(0))
+                {
+                    ew_mul_into(V(0), tb, ta);
+                    ew_div_into(g, ta, ta);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ew_mul_into(V(1), tb, tb);
+                    ew_mul_into(g, y, ta);
+                    ew_div_into(ta, tb, ta);
+                    ew_affine_into(ta, -1.0, 0.0, ta);
+                    push(1, ta);
+                }
+                break;
+            case TapeOp::MatMul:
+                if (wants(0))
+                {
+                    ::matmul2d_into(g, V(1), ta, false, true);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ::matmul2d_into(V(0), g, tb, true, false);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::Linear:
+            {
+                const size_t e = static_cast<size_t>(aux[i]);
+                Tensor &pre = extra[e], &dZ = extra[e + 1], &db = extra[e + 2];
+                if (x[2] >= 0)
+                    db.ensure_shape(V(2).shape);
+                ::linear_backward_into(g, y, pre, static_cast<Activation>(attr[i]), dZ, x[2] >= 0 ? &db : nullptr);
+                if (wants(0))
+                {
+                    ::matmul2d_into(dZ, V(1), ta, false, true);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ::matmul2d_into(V(0), dZ, tb, true, false);
+                    push(1, tb);
+                }
+                if (x[2] >= 0)
+                    push(2, db);
+                break;
+            }
+            case TapeOp::Conv2d:
+            {
+                ConvSlot &cs = convs[static_cast<size_t>(aux[i])];
+                if (wants(0))
+                {
+                    ::conv2d_grad_input_into(g, V(1), V(0).shape, cs.params, ta, cs.cols);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ::conv2d_grad_weight_into(g, V(0), V(1).shape, cs.params, tb, cs.cols);
+                    push(1, tb);
+                }
+                break;
+            }
+            case TapeOp::Cross:
+                if (wants(0))
+                {
+                    ::cross3_into(V(1), g, ta);
+                    push(0, ta);
+                }
+                if (wants(1))
+                {
+                    ::cross3_into(g, V(0), tb);
+                    push(1, tb);
+                }
+                break;
+            case TapeOp::SparseMatMul:
+            {
+                SparseVariable &S = *sparse[static_cast<size_t>(aux[i])];
+                if (wants(1))
+                {
+                    ::spmm_t_into(S.csr, g, tb);
+                    push(1, tb);
+                }
+                if (wants(0))
+                    ::sddmm_add_into(S.csr, g, V(1), S.grad_values);
+                break;
+            }
+            case TapeOp::Dropout:
+            {
+                // the mask of the last forward, replayed from its counters
+                const DropoutSlot &d = drops[static_cast<size_t>(aux[i])];
+                if (!d.masked)
+                {
+                    push(0, g);
+                    break;
+                }
+                ::dropout_into(g, d.node->p, d.seed, d.offset, ta);
+                push(0, ta);
+                break;
+            }
+            }
+        }
+    }
+
+private:
+    struct ConvSlot
+    {
+        Conv2dParams params;
+        TensorStorage cols; // im2col workspace
+    };
+    struct DropoutSlot
+    {
+        std::shared_ptr<const dropout> node; // p, training and the generator
+        uint64_t seed = 0, offset = 0; // counters of the last forward's mask
+        bool masked = false;
+    };
+
+    // Opcode of operator o (= *node), recording its attributes and side storage for
+    // instruction i. Slots that keep referring to the operator hold it by NodePtr, since the
+    // Graph may be its only other owner.
+    TapeOp classify(const NodePtr &node, const Operator &o, size_t i)
+    {
+        auto scratch = [&](size_t k)
+        {
+            aux[i] = static_cast<int32_t>(extra.size());
+            extra.resize(extra.size() + k);
+        };
+        if (dynamic_cast<const add *>(&o))
+            return TapeOp::Add;
+        if (dynamic_cast<const sub *>(&o))
+            return TapeOp::Sub;
+        if (dynamic_cast<const mul *>(&o))
+            return TapeOp::Mul;
+        if (dynamic_cast<const divide *>(&o))
+            return TapeOp::Div;
+        if (dynamic_cast<const power *>(&o))
+            return TapeOp::Pow;
+        if (dynamic_cast<const ln_op *>(&o))
+            return TapeOp::Ln;
+        if (dynamic_cast<const exp_op *>(&o))
+            return TapeOp::Exp;
+        if (dynamic_cast<const sqrt_op *>(&o))
+            return TapeOp::Sqrt;
+        if (auto *s = dynamic_cast<const softmax_op *>(&o))
+        {
+            attr[i] = s->axis;
+            return TapeOp::Softmax;
+        }
+        if (auto *s = dynamic_cast<const log_softmax_op *>(&o))
+        {
+            attr[i] = s->axis;
+            return TapeOp::LogSoftmax;
+        }
+        if (auto *s = dynamic_cast<const logsumexp_op *>(&o))
+        {
+            attr[i] = s->axis;
+            return TapeOp::LogSumExp;
+        }
+        if (auto *s = dynamic_cast<const softmax_cross_entropy *>(&o))
+        {
+            attr[i] = s->axis;
+            scratch(1); // logp
+            return TapeOp::SoftmaxCrossEntropy;
+        }
+        if (dynamic_cast<const log_base *>(&o))
+            return TapeOp::LogBase;
+        if (dynamic_cast<const matmul *>(&o))
+            return TapeOp::MatMul;
+        if (auto *l = dynamic_cast<const linear *>(&o))
+        {
+            attr[i] = static_cast<int64_t>(l->act);
+            scratch(3); // pre, dZ, db
+            return TapeOp::Linear;
+        }
+        if (auto *cv = dynamic_cast<const conv2d *>(&o))
+        {
+            aux[i] = static_cast<int32_t>(convs.size());
+            convs.push_back({cv->params, {}});
+            return TapeOp::Conv2d;
+        }
+        if (dynamic_cast<const dot *>(&o))
+            return TapeOp::Dot;
+        if (dynamic_cast<const cross *>(&o))
+            return TapeOp::Cross;
+        if (auto *sm = dynamic_cast<const sparse_matmul *>(&o))
+        {
+            aux[i] = static_cast<int32_t>(sparse.size());
+            sparse.push_back(&sm->sparse());
+            return TapeOp::SparseMatMul;
+        }
+        if (dynamic_cast<const dropout *>(&o))
+        {
+            aux[i] = static_cast<int32_t>(drops.size());
+            drops.push_back({std::static_pointer_cast<const dropout>(node)});
+            return TapeOp::Dropout;
+        }
+        throw std::runtime_error("Tape: unsupported operator '" + o.name + "'");
+    }
+
+    // Instruction arrays (one entry per instruction)
+    std::vector<TapeOp> op;
+    std::vector<std::array<int32_t, 3>> in; // input instructions (-1 if absent)
+    std::vector<int64_t> attr;              // axis, or Activation for Linear
+    std::vector<int32_t> aux;               // index into extra / convs / sparse / drops
+    std::vector<char> need;                 // on a path to a trainable leaf
+    std::vector<Node *> leaf;               // source node of a leaf, null for operators
+    std::vector<Tensor *> val, grd;         // value/grad slot of every instruction
+    // Storage owned by operator instructions
+    std::vector<Tensor> values, grads, tmp_a, tmp_b;
+    std::vector<Tensor> extra; // logp (cross entropy); pre, dZ, db (linear)
+    std::vector<ConvSlot> convs;
+    std::vector<SparseVariable *> sparse;
+    std::vector<DropoutSlot> drops;
+
+    std::vector<NodePtr> leaves; // keeps the leaf nodes alive
+    std::unordered_map<std::string, int32_t> slots;
+    int32_t root = -1;
+};
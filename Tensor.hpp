@@ -1,6 +1,11 @@
 #pragma once
 #include <vector>
+#include <atomic>
 #include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <new>
 #include <stdexcept>
 #include <string>
 #include <numeric>
@@ -13,50 +18,314 @@ enum class Device
     CUDA
 };
 
+// Process-wide accounting of tensor storage: every heap buffer of a TensorStorage. Plain
+// std::vector buffers (CSR arrays, sparse grads, int8 packed weights / activations) are not
+// tracked here; Graph::memory_report counts them per node.
+struct TensorMemory
+{
+    static inline std::atomic<int64_t> current{0};     // bytes alive now
+    static inline std::atomic<int64_t> peak{0};        // high-water mark since the last reset_peak()
+    static inline std::atomic<int64_t> allocations{0}; // buffers allocated so far
+
+    static void on_alloc(int64_t bytes)
+    {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        const int64_t now = current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        int64_t p = peak.load(std::memory_order_relaxed);
+        while (now > p && !peak.compare_exchange_weak(p, now, std::memory_order_relaxed))
+        {
+        }
+    }
+    static void on_free(int64_t bytes) { current.fetch_sub(bytes, std::memory_order_relaxed); }
+    static void reset_peak() { peak.store(current.load(std::memory_order_relaxed), std::memory_order_relaxed); }
+};
+
+// Shape or strides of a tensor: up to kMaxRank dims stored inline (no heap allocation).
+// Vector-like, and converts to/from std::vector<int64_t>.
+class Shape
+{
+public:
+    static constexpr size_t kMaxRank = 8;
+    using value_type = int64_t;
+    using iterator = int64_t *;
+    using const_iterator = const int64_t *;
+
+    Shape() = default;
+    Shape(size_t count, int64_t v) { resize(count, v); }
+    Shape(std::initializer_list<int64_t> l) { assign(l.begin(), l.end()); }
+    Shape(const std::vector<int64_t> &v) { assign(v.begin(), v.end()); }
+    template <class It, class = std::enable_if_t<!std::is_integral<It>::value>>
+    Shape(It first, It last) { assign(first, last); }
+
+    operator std::vector<int64_t>() const { return std::vector<int64_t>(begin(), end()); }
+
+    size_t size() const { return n; }
+    bool empty() const { return n == 0; }
+    int64_t *data() { return d; }
+    const int64_t *data() const { return d; }
+    iterator begin() { return d; }
+    iterator end() { return d + n; }
+    const_iterator begin() const { return d; }
+    const_iterator end() const { return d + n; }
+    int64_t &operator[](size_t i) { return d[i]; }
+    int64_t operator[](size_t i) const { return d[i]; }
+    int64_t &front() { return d[0]; }
+    int64_t front() const { return d[0]; }
+    int64_t &back() { return d[n - 1]; }
+    int64_t back() const { return d[n - 1]; }
+
+    void clear() { n = 0; }
+    void resize(size_t m, int64_t v = 0)
+    {
+        check(m);
+        for (size_t i = n; i < m; ++i)
+            d[i] = v;
+        n = m;
+    }
+    void push_back(int64_t v)
+    {
+        check(n + 1);
+        d[n++] = v;
+    }
+    template <class It>
+    void assign(It first, It last)
+    {
+        check(static_cast<size_t>(std::distance(first, last)));
+        n = 0;
+        for (; first != last; ++first)
+            d[n++] = static_cast<int64_t>(*first);
+    }
+
+    friend bool operator==(const Shape &a, const Shape &b)
+    {
+        return a.n == b.n && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const Shape &a, const Shape &b) { return !(a == b); }
+    friend bool operator<(const Shape &a, const Shape &b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    static void check(size_t m)
+    {
+        if (m > kMaxRank)
+            throw std::runtime_error("Shape: rank " + std::to_string(m) + " exceeds the maximum of " +
+                                     std::to_string(kMaxRank));
+    }
+
+    int64_t d[kMaxRank] = {};
+    size_t n = 0;
+};
+
+// Tensor element storage: a double array that keeps up to kInline elements inside the object
+// (scalars and tiny tensors never touch the heap) and tracks heap buffers in TensorMemory.
+// Vector-like; resize() zero-fills new elements.
+class TensorStorage
+{
+public:
+    static constexpr size_t kInline = 4;
+    using value_type = double;
+    using iterator = double *;
+    using const_iterator = const double *;
+
+    TensorStorage() noexcept {}
+    explicit TensorStorage(size_t count, double v = 0.0) { assign(count, v); }
+    TensorStorage(std::initializer_list<double> l) { assign(l.begin(), l.end()); }
+    template <class It, class = std::enable_if_t<!std::is_integral<It>::value>>
+    TensorStorage(It first, It last) { assign(first, last); }
+    TensorStorage(const TensorStorage &o) { assign(o.begin(), o.end()); }
+    TensorStorage(TensorStorage &&o) noexcept { take(o); }
+    ~TensorStorage() { release(); }
+
+    TensorStorage &operator=(const TensorStorage &o)
+    {
+        if (this != &o)
+            assign(o.begin(), o.end());
+        return *this;
+    }
+    TensorStorage &operator=(TensorStorage &&o) noexcept
+    {
+        if (this != &o)
+        {
+            release();
+            take(o);
+        }
+        return *this;
+    }
+    TensorStorage &operator=(std::initializer_list<double> l)
+    {
+        assign(l.begin(), l.end());
+        return *this;
+    }
+
+    size_t size() const { return n; }
+    size_t capacity() const { return cap; }
+    bool empty() const { return n == 0; }
+    double *data() { return p; }
+    const double *data() const { return p; }
+    iterator begin() { return p; }
+    iterator end() { return p + n; }
+    const_iterator begin() const { return p; }
+    const_iterator end() const { return p + n; }
+    double &operator[](size_t i) { return p[i]; }
+    const double &operator[](size_t i) const { return p[i]; }
+    double &front() { return p[0]; }
+    const double &front() const { return p[0]; }
+    double &back() { return p[n - 1]; }
+    const double &back() const { return p[n - 1]; }
+
+    // Heap bytes held (0 while the elements fit inline).
+    int64_t bytes() const { return on_heap() ? static_cast<int64_t>(cap * sizeof(double)) : 0; }
+
+    void reserve(size_t c)
+    {
+        if (c > cap)
+            grow(c);
+    }
+    void resize(size_t m, double v = 0.0)
+    {
+        reserve(m);
+        if (m > n)
+            std::fill(p + n, p + m, v);
+        n = m;
+    }
+    void assign(size_t m, double v)
+    {
+        make_room(m);
+        std::fill(p, p + m, v);
+        n = m;
+    }
+    template <class It, class = std::enable_if_t<!std::is_integral<It>::value>>
+    void assign(It first, It last)
+    {
+        const size_t m = static_cast<size_t>(std::distance(first, last));
+        make_room(m);
+        std::copy(first, last, p);
+        n = m;
+    }
+    void push_back(double v)
+    {
+        if (n == cap)
+            grow(2 * cap);
+        p[n++] = v;
+    }
+    void clear() { n = 0; }
+    void swap(TensorStorage &o) noexcept
+    {
+        TensorStorage t(std::move(o));
+        o = std::move(*this);
+        *this = std::move(t);
+    }
+
+    friend bool operator==(const TensorStorage &a, const TensorStorage &b)
+    {
+        return a.n == b.n && std::equal(a.begin(), a.end(), b.begin());
+    }
+    friend bool operator!=(const TensorStorage &a, const TensorStorage &b) { return !(a == b); }
+    friend bool operator<(const TensorStorage &a, const TensorStorage &b)
+    {
+        return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end());
+    }
+
+private:
+    bool on_heap() const { return p != buf; }
+
+    static double *allocate(size_t c)
+    {
+        double *q = static_cast<double *>(::operator new(c * sizeof(double)));
+        TensorMemory::on_alloc(static_cast<int64_t>(c * sizeof(double)));
+        return q;
+    }
+    void release() noexcept
+    {
+        if (on_heap())
+        {
+            TensorMemory::on_free(static_cast<int64_t>(cap * sizeof(double)));
+            ::operator delete(p);
+        }
+        p = buf;
+        cap = kInline;
+        n = 0;
+    }
+    // Capacity for m elements, contents not kept.
+    void make_room(size_t m)
+    {
+        if (m <= cap)
+            return;
+        double *q = allocate(m);
+        release();
+        p = q;
+        cap = m;
+    }
+    void grow(size_t c)
+    {
+        double *q = allocate(c);
+        const size_t keep = n;
+        std::copy(p, p + n, q);
+        release();
+        p = q;
+        cap = c;
+        n = keep;
+    }
+    // Move o's elements here (this must be empty and inline); o is left empty.
+    void take(TensorStorage &o) noexcept
+    {
+        if (o.on_heap())
+        {
+            p = o.p;
+            cap = o.cap;
+            o.p = o.buf;
+            o.cap = kInline;
+        }
+        else
+            std::copy(o.buf, o.buf + o.n, buf);
+        n = o.n;
+        o.n = 0;
+    }
+
+    double buf[kInline];
+    double *p = buf;
+    size_t n = 0, cap = kInline;
+};
+
 struct Tensor
 {
-    std::vector<int64_t> shape;   // e.g., {}, {k}, {m,n}, {b,m,n}, ...
-    std::vector<int64_t> strides; // row-major contiguous by default
-    std::vector<double> data;     // row-major storage
-    Device device = Device::CPU;  // default CPU
+    Shape shape;                 // e.g., {}, {k}, {m,n}, {b,m,n}, ... (rank <= Shape::kMaxRank)
+    Shape strides;               // row-major contiguous by default
+    TensorStorage data;          // row-major storage (tracked by TensorMemory)
+    Device device = Device::CPU; // default CPU
 
     Tensor() = default;
-    // 1) canonical: std::vector<int64_t>
-    explicit Tensor(std::vector<int64_t> s, double fill = 0.0, Device dev = Device::CPU)
-        : shape(std::move(s)), device(dev)
+    // 1) canonical: Shape (also taken from std::vector<int64_t>)
+    explicit Tensor(const Shape &s, double fill = 0.0, Device dev = Device::CPU)
+        : shape(s), device(dev)
     {
         for (auto d : shape)
             if (d <= 0)
                 throw std::runtime_error("Bad shape");
         recompute_strides();
-        data.assign(size(), fill);
+        data.assign(static_cast<size_t>(size()), fill);
     }
     static Tensor zeros(std::initializer_list<int64_t> s, Device dev = Device::CPU)
     {
-        return Tensor(s, 0.0, dev);
+        return Tensor(Shape(s), 0.0, dev);
     }
-    static Tensor zeros(const std::vector<int64_t> &s, Device dev = Device::CPU)
+    static Tensor zeros(const Shape &s, Device dev = Device::CPU)
     {
         return Tensor(s, 0.0, dev);
     }
+    explicit Tensor(const std::vector<int64_t> &s, double fill = 0.0, Device dev = Device::CPU)
+        : Tensor(Shape(s), fill, dev) {}
     // 2) accept any integral vector (e.g., std::vector<pybind11::ssize_t>)
     template <class Int,
               class = std::enable_if_t<std::is_integral<Int>::value && !std::is_same<Int, int64_t>::value>>
     explicit Tensor(const std::vector<Int> &s, double fill = 0.0, Device dev = Device::CPU)
-        : Tensor(std::vector<int64_t>(s.begin(), s.end()), fill, dev) {}
+        : Tensor(Shape(s.begin(), s.end()), fill, dev) {}
 
     // 3) nice brace-list ctor: Tensor({m,n,k}, fill)
     explicit Tensor(std::initializer_list<int64_t> s, double fill = 0.0, Device dev = Device::CPU)
-        : Tensor(std::vector<int64_t>(s), fill, dev) {}
-    // Tensor(std::vector<int64_t> s, double fill = 0.0, Device dev = Device::CPU)
-    //     : shape(std::move(s)), device(dev)
-    // {
-    //     for (auto d : shape)
-    //         if (d <= 0)
-    //             throw std::runtime_error("Bad shape");
-    //     recompute_strides();
-    //     data.assign(size(), fill);
-    // }
+        : Tensor(Shape(s), fill, dev) {}
 
     static Tensor like(const Tensor &t, double fill = 0.0)
     {
@@ -65,16 +334,14 @@ struct Tensor
     }
     static Tensor scalar(double v, Device dev = Device::CPU)
     {
-        Tensor out({}, 0.0, dev);
-        out.recompute_strides();
-        out.data = {v};
+        Tensor out;
+        out.device = dev;
+        out.data.assign(1, v);
         return out;
     }
 
     int64_t size() const
     {
-        if (shape.empty())
-            return 1;
         int64_t sz = 1;
         for (auto d : shape)
             sz *= d;
@@ -82,15 +349,34 @@ struct Tensor
     }
 
     bool is_scalar() const { return shape.empty(); }
+    int64_t nbytes() const { return data.bytes(); }
 
-    void recompute_strides()
+    // Resize storage to shape 's' (contents unspecified), reusing the allocation when it matches.
+    void ensure_shape(const Shape &s)
     {
-        strides.resize(shape.size());
-        if (shape.empty())
+        if (shape != s)
         {
-            strides.clear(); // <— important for scalars
-            return;
+            shape = s;
+            recompute_strides();
         }
+        data.resize(static_cast<size_t>(size()));
+    }
+
+    // Reinterpret the contiguous data with shape 's' (same number of elements).
+    void reshape(const Shape &s)
+    {
+        int64_t n = 1;
+        for (auto d : s)
+            n *= d;
+        if (n != size())
+            throw std::runtime_error("Tensor::reshape: " + std::to_string(size()) + " elements do not fit the new shape");
+        shape = s;
+        recompute_strides();
+    }
+
+    void recompute_strides()
+    {
+        strides.resize(shape.size());
         int64_t stride = 1;
         for (int i = int(shape.size()) - 1; i >= 0; --i)
         {
@@ -156,7 +442,7 @@ struct Tensor
     // Flatten: arithmetic leaf
     template <class T>
     static typename std::enable_if<std::is_arithmetic<T>::value, void>::type
-    flatten_rec(const T &x, std::vector<double> &out)
+    flatten_rec(const T &x, TensorStorage &out)
     {
         out.push_back(static_cast<double>(x));
     }
@@ -164,7 +450,7 @@ struct Tensor
     // Flatten: vector branch
     template <class Vec>
     static typename std::enable_if<is_vector<Vec>::value, void>::type
-    flatten_rec(const Vec &v, std::vector<double> &out)
+    flatten_rec(const Vec &v, TensorStorage &out)
     {
         for (const auto &e : v)
             flatten_rec(e, out);
@@ -199,7 +485,7 @@ struct Tensor
                 throw std::runtime_error("Tensor: bad dimension inferred");
             need *= d;
         }
-        std::vector<double> flat;
+        TensorStorage flat;
         flat.reserve(static_cast<size_t>(need));
         flatten_rec(nested, flat);
         if (static_cast<int64_t>(flat.size()) != need)
@@ -311,13 +597,24 @@ inline void require_matmul_shapes_2d(const Tensor &A, const Tensor &B, const cha
         throw std::runtime_error(std::string(op) + ": inner dims mismatch");
 }
 
+// Axis in [0, rank) from a possibly negative (counted from the end) axis.
+inline int64_t normalize_axis(int64_t axis, size_t rank, const char *op)
+{
+    const int64_t r = static_cast<int64_t>(rank);
+    if (axis < -r || axis >= r)
+        throw std::runtime_error(std::string(op) + ": axis " + std::to_string(axis) +
+                                 " out of range for rank " + std::to_string(r));
+    return axis < 0 ? axis + r : axis;
+}
+
 // Broadcast two shapes (NumPy-style). Align from the right.
-inline std::vector<int64_t> broadcast_shape(const std::vector<int64_t> &a,
-                                            const std::vector<int64_t> &b)
+inline Shape broadcast_shape(const Shape &a, const Shape &b)
 {
+    if (a == b)
+        return a;
     size_t na = a.size(), nb = b.size();
     size_t n = std::max(na, nb);
-    std::vector<int64_t> out(n, 1);
+    Shape out(n, 1);
     for (size_t i = 0; i < n; ++i)
     {
         int64_t da = (i < n - na) ? 1 : a[i - (n - na)];
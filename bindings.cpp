@@ -1,15 +1,120 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 PYBIND11_DECLARE_HOLDER_TYPE(T, std::shared_ptr<T>, true)
 
 #include "Tensor.hpp"
 #include "Node.hpp"
 #include "Graph.hpp"
+#include "Tape.hpp"
+#include "Optimizer.hpp"
+#include "Comm.hpp"
+#include "DataParallel.hpp"
+#include "DataLoader.hpp"
 
 namespace py = pybind11;
 
+static Activation activation_arg(const std::string &name)
+{
+    if (name == "none" || name.empty())
+        return Activation::None;
+    if (name == "relu")
+        return Activation::ReLU;
+    if (name == "gelu")
+        return Activation::GELU;
+    if (name == "tanh")
+        return Activation::Tanh;
+    if (name == "sigmoid")
+        return Activation::Sigmoid;
+    throw std::runtime_error("linear: unknown activation '" + name + "' (none, relu, gelu, tanh, sigmoid)");
+}
+
+// conv2d geometry arguments accept an int (both axes) or an (h, w) pair.
+static void hw_arg(const py::object &v, int64_t out[2], const char *what)
+{
+    if (py::isinstance<py::int_>(v))
+    {
+        out[0] = out[1] = v.cast<int64_t>();
+        return;
+    }
+    const auto t = v.cast<std::vector<int64_t>>();
+    if (t.size() != 2)
+        throw std::runtime_error(std::string("conv2d: ") + what + " must be an int or a pair");
+    out[0] = t[0];
+    out[1] = t[1];
+}
+
+// Borrow a scipy.sparse CSR matrix's buffers without copying (float64 data, int32/int64
+// indices; other dtypes are converted once). The arrays live as long as any view of them.
+static CsrTensor csr_from_scipy(const py::object &mat)
+{
+    if (py::str(mat.attr("format")).cast<std::string>() != "csr")
+        throw std::runtime_error("CsrTensor.from_scipy: expected a CSR matrix");
+    const auto shape = mat.attr("shape").cast<std::pair<int64_t, int64_t>>();
+    auto data = py::array_t<double, py::array::c_style | py::array::forcecast>::ensure(mat.attr("data"));
+    py::array indptr = mat.attr("indptr"), indices = mat.attr("indices");
+    if (!data)
+        throw std::runtime_error("CsrTensor.from_scipy: bad data array");
+
+    CsrTensor t;
+    t.rows = shape.first;
+    t.cols = shape.second;
+    t.nnz = static_cast<int64_t>(data.size());
+    t.values = data.data();
+    auto keep = new std::vector<py::object>{data};
+    if (indptr.dtype().is(py::dtype::of<int32_t>()) && indices.dtype().is(py::dtype::of<int32_t>()))
+    {
+        auto ip = py::array_t<int32_t, py::array::c_style | py::array::forcecast>::ensure(indptr);
+        auto ix = py::array_t<int32_t, py::array::c_style | py::array::forcecast>::ensure(indices);
+        t.indptr32 = ip.data();
+        t.indices32 = ix.data();
+        keep->push_back(ip);
+        keep->push_back(ix);
+    }
+    else
+    {
+        auto ip = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(indptr);
+        auto ix = py::array_t<int64_t, py::array::c_style | py::array::forcecast>::ensure(indices);
+        t.indptr64 = ip.data();
+        t.indices64 = ix.data();
+        keep->push_back(ip);
+        keep->push_back(ix);
+    }
+    // may be released from a GIL-free compute call
+    t.owner = std::shared_ptr<const void>(keep, [](std::vector<py::object> *k)
+                                          { py::gil_scoped_acquire gil; delete k; });
+
+    const int64_t n_ptr = static_cast<int64_t>(py::len(keep->at(1)));
+    if (t.rows <= 0 || t.cols <= 0 || n_ptr != t.rows + 1 ||
+        static_cast<int64_t>(py::len(keep->at(2))) != t.nnz || t.row_begin(t.rows) != t.nnz)
+        throw std::runtime_error("CsrTensor.from_scipy: inconsistent indptr/indices/data");
+    for (int64_t p = 0; p < t.nnz; ++p)
+        if (t.col(p) < 0 || t.col(p) >= t.cols)
+            throw std::runtime_error("CsrTensor.from_scipy: column index out of range");
+    return t;
+}
+
 PYBIND11_MODULE(ElhamMath, m)
 {
+    // Pick the kernel ISA variants now, so a bad ELHAMMATH_KERNEL_ISA fails the import.
+    kernel_isa();
+    m.def("kernel_isa", &kernel_isa, py::arg("kernel") = "",
+          "ISA variant ('baseline', 'avx2', 'avx512' or 'default') used by a kernel, or the default one.");
+    m.def("kernel_isas", &kernel_isas, "Kernel ISA variants this build can run on this CPU.");
+
+    // Counter-based RNG (Philox): (seed, offset) fully determine every later draw.
+    py::class_<Generator, std::shared_ptr<Generator>>(m, "Generator")
+        .def(py::init<uint64_t>(), py::arg("seed") = 0)
+        .def_readwrite("seed", &Generator::seed)
+        .def_property("offset", &Generator::offset, &Generator::set_offset)
+        .def("manual_seed", &Generator::manual_seed, py::arg("seed"));
+    m.def("default_generator", [] { return Generator::global(); },
+          "Generator used by the Tensor factories and dropout when none is given.");
+    m.def("manual_seed", [](uint64_t s) { Generator::global()->manual_seed(s); }, py::arg("seed"),
+          "Reseed the default generator and rewind its offset.");
+    auto gen_or_global = [](const std::shared_ptr<Generator> &g) -> Generator &
+    { return g ? *g : *Generator::global(); };
+
     // Tensor + Device (simple for now; later you can add NumPy buffer protocol)
     py::enum_<Device>(m, "Device")
         .value("CPU", Device::CPU)
@@ -26,9 +131,15 @@ PYBIND11_MODULE(ElhamMath, m)
         .def(py::init<const std::vector<std::vector<std::vector<std::vector<double>>>> &, Device>(),
              py::arg("value"), py::arg("device") = Device::CPU)
         .def_static("scalar", &Tensor::scalar, py::arg("v"), py::arg("device") = Device::CPU)
-        .def_readonly("shape", &Tensor::shape)
-        .def_readonly("strides", &Tensor::strides)
-        .def_readwrite("data", &Tensor::data)
+        .def_property_readonly("shape", [](const Tensor &t)
+                               { return std::vector<int64_t>(t.shape); })
+        .def_property_readonly("strides", [](const Tensor &t)
+                               { return std::vector<int64_t>(t.strides); })
+        .def_property(
+            "data", [](const Tensor &t)
+            { return std::vector<double>(t.data.begin(), t.data.end()); },
+            [](Tensor &t, const std::vector<double> &v)
+            { t.data.assign(v.begin(), v.end()); })
         .def_readwrite("device", &Tensor::device)
         .def("size", &Tensor::size)
         .def("is_scalar", &Tensor::is_scalar)
@@ -38,13 +149,49 @@ PYBIND11_MODULE(ElhamMath, m)
             Tensor t;
             t.shape = shape; t.device = dev; t.recompute_strides();
             t.data.assign(t.size(), fill);
-            return t; }, py::arg("shape"), py::arg("fill") = 0.0, py::arg("device") = Device::CPU);
+            return t; }, py::arg("shape"), py::arg("fill") = 0.0, py::arg("device") = Device::CPU)
+        // random factories, filled in parallel (GIL released)
+        .def_static("rand", [=](const std::vector<int64_t> &shape, std::shared_ptr<Generator> g)
+                    { return random_uniform(shape, 0.0, 1.0, gen_or_global(g)); },
+                    py::arg("shape"), py::arg("generator") = nullptr, py::call_guard<py::gil_scoped_release>())
+        .def_static("randn", [=](const std::vector<int64_t> &shape, std::shared_ptr<Generator> g)
+                    { return random_normal(shape, 0.0, 1.0, gen_or_global(g)); },
+                    py::arg("shape"), py::arg("generator") = nullptr, py::call_guard<py::gil_scoped_release>())
+        .def_static("uniform", [=](const std::vector<int64_t> &shape, double low, double high, std::shared_ptr<Generator> g)
+                    { return random_uniform(shape, low, high, gen_or_global(g)); },
+                    py::arg("shape"), py::arg("low") = 0.0, py::arg("high") = 1.0, py::arg("generator") = nullptr,
+                    py::call_guard<py::gil_scoped_release>())
+        .def_static("normal", [=](const std::vector<int64_t> &shape, double mean, double std, std::shared_ptr<Generator> g)
+                    { return random_normal(shape, mean, std, gen_or_global(g)); },
+                    py::arg("shape"), py::arg("mean") = 0.0, py::arg("std") = 1.0, py::arg("generator") = nullptr,
+                    py::call_guard<py::gil_scoped_release>());
+
+    py::class_<CsrTensor>(m, "CsrTensor")
+        .def(py::init<int64_t, int64_t, std::vector<int64_t>, std::vector<int64_t>, std::vector<double>>(),
+             py::arg("rows"), py::arg("cols"), py::arg("indptr"), py::arg("indices"), py::arg("values"))
+        .def_static("from_dense", &CsrTensor::from_dense, py::arg("dense"))
+        .def_static("from_scipy", &csr_from_scipy, py::arg("matrix"))
+        .def_readonly("rows", &CsrTensor::rows)
+        .def_readonly("cols", &CsrTensor::cols)
+        .def_readonly("nnz", &CsrTensor::nnz)
+        .def("to_dense", &CsrTensor::to_dense)
+        .def("desc", &CsrTensor::desc)
+        .def("__repr__", &CsrTensor::desc);
 
     // Node base (abstract)
     py::class_<Node, std::shared_ptr<Node>>(m, "Node")
         .def_readwrite("name", &Node::name)
-        .def_readwrite("value", &Node::value)
-        .def_readwrite("grad", &Node::grad);
+        // 'value' is returned by copy so assigning it (set_value, which marks the node dirty for
+        // incremental forward()) is the only way to change it from Python
+        .def_property(
+            "value", [](const Node &n)
+            { return n.value; },
+            &Node::set_value)
+        .def_readonly("version", &Node::version)
+        .def("mark_dirty", &Node::mark_dirty)
+        .def_readwrite("grad", &Node::grad)
+        .def_readwrite("tangent", &Node::tangent)
+        .def_readwrite("grad_tangent", &Node::grad_tangent);
 
     // Operator bases
     py::class_<Operator, Node, std::shared_ptr<Operator>>(m, "Operator");
@@ -56,8 +203,16 @@ PYBIND11_MODULE(ElhamMath, m)
              py::arg("value"), py::arg("name"));
 
     py::class_<Constant, Node, std::shared_ptr<Constant>>(m, "Constant")
-        .def(py::init<const Tensor &, const std::string &>(),
-             py::arg("value"), py::arg("name"));
+        .def(py::init<const Tensor &, const std::string &, bool>(),
+             py::arg("value"), py::arg("name"), py::arg("literal") = false)
+        .def_readonly("literal", &Constant::literal);
+
+    py::class_<SparseVariable, Node, std::shared_ptr<SparseVariable>>(m, "SparseVariable")
+        .def(py::init<const CsrTensor &, const std::string &, bool>(),
+             py::arg("value"), py::arg("name"), py::arg("requires_grad") = true)
+        .def_readonly("csr", &SparseVariable::csr)
+        .def_readwrite("requires_grad", &SparseVariable::requires_grad)
+        .def_property_readonly("grad_csr", &SparseVariable::grad_csr);
 
     // Binary elementwise ops
     py::class_<add, Operator, std::shared_ptr<add>>(m, "add")
@@ -93,6 +248,38 @@ PYBIND11_MODULE(ElhamMath, m)
         .def(py::init<std::shared_ptr<Node>, const std::string &>(),
              py::arg("x"), py::arg("name") = "");
 
+    py::class_<dropout, UnaryOperator, std::shared_ptr<dropout>>(m, "dropout")
+        .def(py::init<std::shared_ptr<Node>, double, const std::string &, std::shared_ptr<Generator>>(),
+             py::arg("x"), py::arg("p") = 0.5, py::arg("name") = "", py::arg("generator") = nullptr)
+        .def_readonly("p", &dropout::p)
+        .def_readwrite("training", &dropout::training);
+
+    // Softmax family (axis defaults to the last one)
+    py::class_<softmax_op, UnaryOperator, std::shared_ptr<softmax_op>>(m, "softmax")
+        .def(py::init([](std::shared_ptr<Node> x, int64_t axis, const std::string &name)
+                      { return std::make_shared<softmax_op>(std::move(x), name, axis); }),
+             py::arg("x"), py::arg("axis") = -1, py::arg("name") = "")
+        .def_readonly("axis", &softmax_op::axis);
+
+    py::class_<log_softmax_op, UnaryOperator, std::shared_ptr<log_softmax_op>>(m, "log_softmax")
+        .def(py::init([](std::shared_ptr<Node> x, int64_t axis, const std::string &name)
+                      { return std::make_shared<log_softmax_op>(std::move(x), name, axis); }),
+             py::arg("x"), py::arg("axis") = -1, py::arg("name") = "")
+        .def_readonly("axis", &log_softmax_op::axis);
+
+    py::class_<logsumexp_op, UnaryOperator, std::shared_ptr<logsumexp_op>>(m, "logsumexp")
+        .def(py::init([](std::shared_ptr<Node> x, int64_t axis, const std::string &name)
+                      { return std::make_shared<logsumexp_op>(std::move(x), name, axis); }),
+             py::arg("x"), py::arg("axis") = -1, py::arg("name") = "")
+        .def_readonly("axis", &logsumexp_op::axis);
+
+    py::class_<softmax_cross_entropy, Operator, std::shared_ptr<softmax_cross_entropy>>(m, "softmax_cross_entropy")
+        .def(py::init([](std::shared_ptr<Node> logits, std::shared_ptr<Node> target, int64_t axis,
+                         const std::string &name)
+                      { return std::make_shared<softmax_cross_entropy>(std::move(logits), std::move(target), name, axis); }),
+             py::arg("logits"), py::arg("target"), py::arg("axis") = -1, py::arg("name") = "")
+        .def_readonly("axis", &softmax_cross_entropy::axis);
+
     // Others
     py::class_<log_base, Operator, std::shared_ptr<log_base>>(m, "log_base")
         .def(py::init<std::shared_ptr<Node>, std::shared_ptr<Node>, const std::string &>(),
@@ -102,6 +289,40 @@ PYBIND11_MODULE(ElhamMath, m)
         .def(py::init<std::shared_ptr<Node>, std::shared_ptr<Node>, const std::string &>(),
              py::arg("A"), py::arg("B"), py::arg("name") = "");
 
+    py::class_<linear, Operator, std::shared_ptr<linear>>(m, "linear")
+        .def(py::init([](std::shared_ptr<Node> x, std::shared_ptr<Node> w, std::shared_ptr<Node> bias,
+                         const std::string &activation, const std::string &name)
+                      { return std::make_shared<linear>(std::move(x), std::move(w), std::move(bias), name,
+                                                        activation_arg(activation)); }),
+             py::arg("X"), py::arg("W"), py::arg("bias") = nullptr, py::arg("activation") = "none",
+             py::arg("name") = "");
+
+    py::class_<conv2d, Operator, std::shared_ptr<conv2d>>(m, "conv2d")
+        .def(py::init([](std::shared_ptr<Node> x, std::shared_ptr<Node> w, const py::object &stride,
+                         const py::object &padding, const py::object &dilation, int64_t groups,
+                         const std::string &name)
+                      {
+            Conv2dParams p;
+            hw_arg(stride, p.stride, "stride");
+            hw_arg(padding, p.padding, "padding");
+            hw_arg(dilation, p.dilation, "dilation");
+            p.groups = groups;
+            return std::make_shared<conv2d>(std::move(x), std::move(w), name, p); }),
+             py::arg("x"), py::arg("w"), py::arg("stride") = 1, py::arg("padding") = 0,
+             py::arg("dilation") = 1, py::arg("groups") = 1, py::arg("name") = "")
+        .def_property_readonly("stride", [](const conv2d &c)
+                               { return std::make_pair(c.params.stride[0], c.params.stride[1]); })
+        .def_property_readonly("padding", [](const conv2d &c)
+                               { return std::make_pair(c.params.padding[0], c.params.padding[1]); })
+        .def_property_readonly("dilation", [](const conv2d &c)
+                               { return std::make_pair(c.params.dilation[0], c.params.dilation[1]); })
+        .def_property_readonly("groups", [](const conv2d &c)
+                               { return c.params.groups; });
+
+    py::class_<sparse_matmul, Operator, std::shared_ptr<sparse_matmul>>(m, "sparse_matmul")
+        .def(py::init<std::shared_ptr<Node>, std::shared_ptr<Node>, const std::string &>(),
+             py::arg("S"), py::arg("D"), py::arg("name") = "");
+
     py::class_<dot, Operator, std::shared_ptr<dot>>(m, "dot")
         .def(py::init<std::shared_ptr<Node>, std::shared_ptr<Node>, const std::string &>(),
              py::arg("a"), py::arg("b"), py::arg("name") = "");
@@ -111,8 +332,248 @@ PYBIND11_MODULE(ElhamMath, m)
              py::arg("a"), py::arg("b"), py::arg("name") = "");
 
     // Graph
+    py::class_<PassReport>(m, "PassReport")
+        .def_readonly("folded", &PassReport::folded)
+        .def_readonly("simplified", &PassReport::simplified)
+        .def_readonly("cse", &PassReport::cse)
+        .def("__repr__", [](const PassReport &r)
+             { return "PassReport(folded=" + std::to_string(r.folded) +
+                      ", simplified=" + std::to_string(r.simplified) +
+                      ", cse=" + std::to_string(r.cse) + ")"; });
+
+    // Memory accounting
+    m.def("memory_stats", []
+          {
+        py::dict d;
+        d["current"] = TensorMemory::current.load();
+        d["peak"] = TensorMemory::peak.load();
+        d["allocations"] = TensorMemory::allocations.load();
+        return d; }, "Process-wide tensor storage: bytes alive now, peak bytes, buffers allocated. "
+          "Covers Tensor buffers only: CSR arrays, SparseVariable gradients and int8 packed weights/"
+          "activations are not tracked (Graph.memory_report counts them per node).");
+    m.def("reset_peak", &TensorMemory::reset_peak, "Restart peak tracking from the current usage.");
+
+    py::class_<NodeMemory>(m, "NodeMemory")
+        .def_readonly("name", &NodeMemory::name)
+        .def_readonly("parameters", &NodeMemory::parameters)
+        .def_readonly("inputs", &NodeMemory::inputs)
+        .def_readonly("activations", &NodeMemory::activations)
+        .def_readonly("grads", &NodeMemory::grads)
+        .def_readonly("temporaries", &NodeMemory::temporaries)
+        .def_property_readonly("total", &NodeMemory::total)
+        .def("__repr__", [](const NodeMemory &n)
+             { return "NodeMemory('" + n.name + "', total=" + std::to_string(n.total()) + ")"; });
+
+    py::class_<MemoryReport>(m, "MemoryReport")
+        .def_readonly("nodes", &MemoryReport::nodes)
+        .def_readonly("parameters", &MemoryReport::parameters)
+        .def_readonly("inputs", &MemoryReport::inputs)
+        .def_readonly("activations", &MemoryReport::activations)
+        .def_readonly("grads", &MemoryReport::grads)
+        .def_readonly("temporaries", &MemoryReport::temporaries)
+        .def_property_readonly("total", &MemoryReport::total)
+        .def("largest", &MemoryReport::largest, py::arg("k") = 5)
+        .def("__repr__", [](const MemoryReport &r)
+             { return "MemoryReport(parameters=" + std::to_string(r.parameters) +
+                      ", inputs=" + std::to_string(r.inputs) +
+                      ", activations=" + std::to_string(r.activations) +
+                      ", grads=" + std::to_string(r.grads) +
+                      ", temporaries=" + std::to_string(r.temporaries) + ")"; });
+
+    py::class_<QuantError>(m, "QuantError")
+        .def_readonly("name", &QuantError::name)
+        .def_readonly("max_abs_error", &QuantError::max_abs_error)
+        .def_readonly("rel_error", &QuantError::rel_error)
+        .def("__repr__", [](const QuantError &e)
+             { return "QuantError('" + e.name + "', max_abs_error=" + std::to_string(e.max_abs_error) +
+                      ", rel_error=" + std::to_string(e.rel_error) + ")"; });
+
+    py::class_<QuantReport>(m, "QuantReport")
+        .def_readonly("quantized_ops", &QuantReport::quantized_ops)
+        .def_readonly("root", &QuantReport::root)
+        .def_readonly("ops", &QuantReport::ops)
+        .def("__repr__", [](const QuantReport &r)
+             { return "QuantReport(quantized_ops=" + std::to_string(r.quantized_ops) +
+                      ", root_max_abs_error=" + std::to_string(r.root.max_abs_error) +
+                      ", root_rel_error=" + std::to_string(r.root.rel_error) + ")"; });
+
+    // Futures returned by the Graph's asynchronous calls; waiting releases the GIL.
+    using TensorFuture = std::shared_future<Tensor>;
+    using VoidFuture = std::shared_future<void>;
+    py::class_<TensorFuture>(m, "TensorFuture")
+        .def("result", [](const TensorFuture &f)
+             { return f.get(); }, py::call_guard<py::gil_scoped_release>())
+        .def("wait", &TensorFuture::wait, py::call_guard<py::gil_scoped_release>())
+        .def("done", [](const TensorFuture &f)
+             { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+    py::class_<VoidFuture>(m, "Future")
+        .def("result", [](const VoidFuture &f)
+             { f.get(); }, py::call_guard<py::gil_scoped_release>())
+        .def("wait", &VoidFuture::wait, py::call_guard<py::gil_scoped_release>())
+        .def("done", [](const VoidFuture &f)
+             { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
     py::class_<Graph>(m, "Graph")
-        .def(py::init<std::shared_ptr<Node>>(), py::arg("root"))
-        .def("forward", &Graph::forward)
-        .def("backward", &Graph::backward);
+        .def(py::init<std::shared_ptr<Node>, bool>(), py::arg("root"), py::arg("optimize") = true)
+        .def_readonly("report", &Graph::report)
+        .def_readonly("recomputed", &Graph::recomputed)
+        .def_readwrite("memory_budget", &Graph::memory_budget)
+        .def("memory_report", &Graph::memory_report)
+        .def("check_memory_budget", &Graph::check_memory_budget)
+        .def("invalidate", &Graph::invalidate)
+        // compute runs without the GIL; arguments are converted before it is released
+        .def("forward", &Graph::forward, py::call_guard<py::gil_scoped_release>())
+        .def("backward", &Graph::backward, py::call_guard<py::gil_scoped_release>())
+        .def("jvp", &Graph::jvp, py::arg("tangents"), py::call_guard<py::gil_scoped_release>())
+        .def("hvp", &Graph::hvp, py::arg("v"), py::call_guard<py::gil_scoped_release>())
+        .def("jacobian", &Graph::jacobian, py::arg("wrt") = std::vector<std::string>{}, py::arg("chunk") = 0,
+             py::call_guard<py::gil_scoped_release>())
+        .def("calibrate", &Graph::calibrate, py::arg("batches"), py::call_guard<py::gil_scoped_release>())
+        .def("quantize", &Graph::quantize, py::arg("on") = true, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("quantized", &Graph::quantized)
+        .def("quantization_report", &Graph::quantization_report, py::arg("batches"),
+             py::call_guard<py::gil_scoped_release>())
+        .def("forward_async", &Graph::forward_async, py::arg("feed") = std::map<std::string, Tensor>{})
+        .def("backward_async", &Graph::backward_async)
+        .def("step_async", &Graph::step_async, py::arg("optimizer"), py::keep_alive<1, 2>())
+        .def("synchronize", &Graph::synchronize, py::call_guard<py::gil_scoped_release>())
+        .def("infer_shapes", &Graph::infer_shapes)
+        .def("parameters", &Graph::parameters)
+        .def("train", &Graph::train, py::arg("steps"), py::arg("optimizer"),
+             py::arg("feed") = std::map<std::string, std::vector<Tensor>>{},
+             py::call_guard<py::gil_scoped_release>());
+
+    // Flat compiled form of a Graph (leaf values read from / grads written to the Graph's nodes)
+    py::class_<Tape>(m, "Tape")
+        .def(py::init<Graph &>(), py::arg("graph"), py::keep_alive<1, 2>())
+        .def("__len__", &Tape::size)
+        .def("forward", &Tape::forward, py::call_guard<py::gil_scoped_release>())
+        .def("backward", &Tape::backward, py::call_guard<py::gil_scoped_release>())
+        .def("slot", &Tape::slot, py::arg("name"))
+        .def("value", py::overload_cast<const std::string &>(&Tape::value, py::const_), py::arg("name"))
+        .def("value", py::overload_cast<int32_t>(&Tape::value, py::const_), py::arg("slot"))
+        .def("grad", py::overload_cast<const std::string &>(&Tape::grad, py::const_), py::arg("name"))
+        .def("grad", py::overload_cast<int32_t>(&Tape::grad, py::const_), py::arg("slot"));
+
+    // Optimizers (C++ only: no Python overrides, so steps run without the GIL)
+    py::class_<Optimizer>(m, "Optimizer")
+        .def("step", &Optimizer::step, py::arg("params"), py::call_guard<py::gil_scoped_release>())
+        .def(
+            "step", [](Optimizer &o, Graph &g)
+            { o.step(g.parameters()); },
+            py::arg("graph"), py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SGD, Optimizer>(m, "SGD")
+        .def(py::init<double, double>(), py::arg("lr"), py::arg("weight_decay") = 0.0)
+        .def_readwrite("lr", &SGD::lr)
+        .def_readwrite("weight_decay", &SGD::weight_decay);
+
+    py::class_<Momentum, Optimizer>(m, "Momentum")
+        .def(py::init<double, double, double, bool>(), py::arg("lr"), py::arg("momentum") = 0.9,
+             py::arg("weight_decay") = 0.0, py::arg("nesterov") = false)
+        .def_readwrite("lr", &Momentum::lr)
+        .def_readwrite("momentum", &Momentum::mu)
+        .def_readwrite("weight_decay", &Momentum::weight_decay)
+        .def_readwrite("nesterov", &Momentum::nesterov);
+
+    py::class_<Adam, Optimizer>(m, "Adam")
+        .def(py::init<double, double, double, double, double>(), py::arg("lr") = 1e-3,
+             py::arg("beta1") = 0.9, py::arg("beta2") = 0.999, py::arg("eps") = 1e-8,
+             py::arg("weight_decay") = 0.0)
+        .def_readwrite("lr", &Adam::lr)
+        .def_readwrite("beta1", &Adam::beta1)
+        .def_readwrite("beta2", &Adam::beta2)
+        .def_readwrite("eps", &Adam::eps)
+        .def_readwrite("weight_decay", &Adam::weight_decay)
+        .def_readonly("t", &Adam::t);
+
+    py::class_<AdamW, Adam>(m, "AdamW")
+        .def(py::init<double, double, double, double, double>(), py::arg("lr") = 1e-3,
+             py::arg("beta1") = 0.9, py::arg("beta2") = 0.999, py::arg("eps") = 1e-8,
+             py::arg("weight_decay") = 1e-2);
+
+    // Multi-process data parallelism (one process per rank, same 'name' on every rank)
+    py::class_<ShmCommunicator>(m, "ShmCommunicator")
+        .def(py::init<const std::string &, int, int, int64_t, double>(), py::arg("name"),
+             py::arg("rank"), py::arg("world_size"), py::arg("chunk_elems") = 1 << 16,
+             py::arg("timeout") = 120.0, py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("rank", &ShmCommunicator::rank)
+        .def_property_readonly("world_size", &ShmCommunicator::world_size)
+        .def(
+            "allreduce", [](ShmCommunicator &c, Tensor &t)
+            { c.allreduce_sum(t.data.data(), t.size()); },
+            py::arg("tensor"), py::call_guard<py::gil_scoped_release>())
+        .def(
+            "broadcast", [](ShmCommunicator &c, Tensor &t, int root)
+            { c.broadcast(t.data.data(), t.size(), root); },
+            py::arg("tensor"), py::arg("root") = 0, py::call_guard<py::gil_scoped_release>())
+        .def("barrier", &ShmCommunicator::barrier, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<DataParallel>(m, "DataParallel")
+        .def(py::init<Graph &, Optimizer &, ShmCommunicator &, int64_t>(), py::arg("graph"),
+             py::arg("optimizer"), py::arg("comm"), py::arg("bucket_elems") = 1 << 18,
+             py::keep_alive<1, 2>(), py::keep_alive<1, 3>(), py::keep_alive<1, 4>(),
+             py::call_guard<py::gil_scoped_release>())
+        .def("step", &DataParallel::step, py::arg("feed") = std::map<std::string, Tensor>{},
+             py::call_guard<py::gil_scoped_release>())
+        .def("train", &DataParallel::train, py::arg("steps"),
+             py::arg("feed") = std::map<std::string, std::vector<Tensor>>{},
+             py::call_guard<py::gil_scoped_release>())
+        .def_property_readonly("bucket_count", &DataParallel::bucket_count);
+
+    // Streaming data loading
+    py::class_<DataSource, std::shared_ptr<DataSource>>(m, "DataSource")
+        .def_property_readonly("rows", &DataSource::rows)
+        .def_property_readonly("cols", &DataSource::cols);
+    py::class_<BinarySource, DataSource, std::shared_ptr<BinarySource>>(m, "BinarySource")
+        .def(py::init([](const std::string &path, int64_t cols, const std::string &dtype, int64_t offset)
+                      {
+            if (dtype != "float64" && dtype != "float32")
+                throw std::runtime_error("BinarySource: dtype must be 'float64' or 'float32'");
+            return std::make_shared<BinarySource>(path, cols, dtype == "float32", offset); }),
+             py::arg("path"), py::arg("cols"), py::arg("dtype") = "float64", py::arg("offset") = 0);
+    py::class_<CsvSource, DataSource, std::shared_ptr<CsvSource>>(m, "CsvSource")
+        .def(py::init<std::string, char, bool>(), py::arg("path"), py::arg("delimiter") = ',',
+             py::arg("header") = false, py::call_guard<py::gil_scoped_release>());
+
+    py::class_<DataLoader>(m, "DataLoader")
+        .def(py::init<std::shared_ptr<DataSource>, int64_t, std::vector<DataLoader::Field>, bool, uint64_t, int, int, bool>(),
+             py::arg("source"), py::arg("batch_size"), py::arg("fields") = std::vector<DataLoader::Field>{},
+             py::arg("shuffle") = true, py::arg("seed") = 0, py::arg("workers") = 2, py::arg("prefetch") = 4,
+             py::arg("drop_last") = false)
+        .def("__len__", &DataLoader::batches_per_epoch)
+        .def_property_readonly("epoch", &DataLoader::epoch)
+        .def("restart", &DataLoader::restart, py::call_guard<py::gil_scoped_release>())
+        // a fresh loop over a partly consumed epoch starts the next one
+        .def("__iter__", [](DataLoader &l) -> DataLoader &
+             {
+            py::gil_scoped_release nogil;
+            l.restart();
+            return l; }, py::return_value_policy::reference_internal)
+        // the dict owns its Tensors (moved out of the loader, which no longer writes to them)
+        .def("__next__", [](DataLoader &l)
+             {
+            DataLoader::Batch b;
+            bool more;
+            {
+                py::gil_scoped_release nogil;
+                more = l.next(b);
+            }
+            if (!more)
+                throw py::stop_iteration();
+            py::dict out;
+            for (auto &kv : b)
+                out[py::str(kv.first)] = py::cast(std::move(kv.second));
+            return out; })
+        // hand a finished batch's buffers back for reuse; its Tensors are left empty
+        .def("recycle", [](DataLoader &l, py::dict batch)
+             {
+            DataLoader::Batch b;
+            for (auto kv : batch)
+            {
+                Tensor &t = kv.second.cast<Tensor &>();
+                b[kv.first.cast<std::string>()] = std::move(t);
+                t = Tensor();
+            }
+            l.recycle(std::move(b)); }, py::arg("batch"));
 }
@@ -0,0 +1,97 @@
+#pragma once
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include "Graph.hpp"
+
+// Helpers shared by the test_*.cpp checks (run by ctest): each check prints one line, and main
+// returns test_result(), non-zero if any check failed.
+
+inline int test_failures = 0;
+
+inline void check(bool ok, const std::string &what)
+{
+    std::cout << (ok ? "ok    " : "FAIL  ") << what << std::endl;
+    if (!ok)
+        ++test_failures;
+}
+
+// max |got - want| relative to the largest |want| (at least 1)
+inline void check_close(const Tensor &got, const Tensor &want, double tol, const std::string &what)
+{
+    if (got.shape != want.shape || got.data.size() != want.data.size())
+    {
+        check(false, what + ": shape mismatch");
+        return;
+    }
+    double err = 0.0, scale = 1.0;
+    for (size_t i = 0; i < got.data.size(); ++i)
+    {
+        const double d = std::fabs(got.data[i] - want.data[i]);
+        if (!(d <= err)) // keeps a NaN
+            err = d;
+        scale = std::max(scale, std::fabs(want.data[i]));
+    }
+    std::ostringstream msg;
+    msg << what << " (error " << err / scale << ")";
+    check(err <= tol * scale, msg.str());
+}
+
+inline int test_result()
+{
+    std::cout << (test_failures ? std::to_string(test_failures) + " check(s) failed" : "all checks passed")
+              << std::endl;
+    return test_failures ? 1 : 0;
+}
+
+// Uniform in [lo, hi), from a fixed seed so failures reproduce.
+inline Tensor random_tensor(const Shape &s, double lo = -1.0, double hi = 1.0)
+{
+    static std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> u(lo, hi);
+    Tensor t(s);
+    for (auto &v : t.data)
+        v = u(rng);
+    return t;
+}
+
+inline double sum_of(const Tensor &t)
+{
+    double s = 0.0;
+    for (double v : t.data)
+        s += v;
+    return s;
+}
+
+// Central differences of sum(root) w.r.t. each element of 'leaf' (the function Graph::backward
+// differentiates, since it seeds the root with ones). Leaves 'leaf' unchanged.
+inline Tensor numeric_gradient(Graph &g, Node &leaf, double h = 1e-6)
+{
+    Tensor out = Tensor::like(leaf.value, 0.0);
+    for (size_t i = 0; i < leaf.value.data.size(); ++i)
+    {
+        const double x = leaf.value.data[i];
+        leaf.value.data[i] = x + h;
+        leaf.mark_dirty();
+        const double up = sum_of(g.forward());
+        leaf.value.data[i] = x - h;
+        leaf.mark_dirty();
+        const double down = sum_of(g.forward());
+        leaf.value.data[i] = x;
+        leaf.mark_dirty();
+        out.data[i] = (up - down) / (2.0 * h);
+    }
+    g.forward();
+    return out;
+}
+
+// Reverse-mode grad of 'leaf' against central differences.
+inline void check_gradient(Graph &g, Node &leaf, const std::string &what, double tol = 1e-6, double h = 1e-6)
+{
+    g.forward();
+    g.backward();
+    const Tensor got = leaf.grad;
+    check_close(got, numeric_gradient(g, leaf, h), tol, what);
+}
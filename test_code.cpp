@@ -5,33 +5,37 @@
 
 int main() {
     // Create variable x = 3
-    NodePtr x = std::make_shared<Variable>(3.0, "x");
+    NodePtr x = std::make_shared<Variable>(Tensor(3.0), "x");
 
-    // Create constants cons_1 = 2, cons_2 = 6
-    NodePtr cons_1 = std::make_shared<Constant>(2.0, "cons_1");
-    NodePtr cons_2 = std::make_shared<Constant>(6.0, "cons_2");
+    // Create literal constants cons_1 = 2, cons_2 = 6 (fixed values the passes may fold)
+    NodePtr cons_1 = std::make_shared<Constant>(Tensor(2.0), "cons_1", true);
+    NodePtr cons_2 = std::make_shared<Constant>(Tensor(6.0), "cons_2", true);
 
-    NodePtr y = std::make_shared<Add>(
-        std::make_shared<Power>(x, cons_1, "x^2"),
+    NodePtr y = std::make_shared<add>(
+        std::make_shared<power>(x, cons_1, "x^2"),
         cons_2,
         "y0"
     );
 
     for (int i = 1; i <= 500; ++i) {
         std::string node_name = "y" + std::to_string(i);
-        y = std::make_shared<Add>(
-            std::make_shared<Power>(x, cons_1, "x^2_" + std::to_string(i)),
+        y = std::make_shared<add>(
+            std::make_shared<power>(x, cons_1, "x^2_" + std::to_string(i)),
             y,
             node_name
         );
     }
 
-    // Build computation graph
+    // Build computation graph (runs constant folding, simplification and CSE)
     Graph graph(y);
+    std::cout << "Removed nodes: folded=" << graph.report.folded
+              << " simplified=" << graph.report.simplified
+              << " cse=" << graph.report.cse
+              << " (" << graph.order.size() << " left)" << std::endl;
 
     // Forward pass
-    double result = graph.forward();
-    std::cout << "The forward pass : " << result << std::endl;
+    Tensor result = graph.forward();
+    std::cout << "The forward pass : " << result.data[0] << std::endl;
 
     // Measure backward time
     auto start = std::chrono::high_resolution_clock::now();
@@ -42,7 +46,7 @@ int main() {
     std::chrono::duration<double, std::milli> elapsed = end - start;
     std::cout << "Backward elapsed time: " << elapsed.count() << " ms" << std::endl;
 
-    std::cout << "Gradient wrt x: " << x->grad << std::endl;
+    std::cout << "Gradient wrt x: " << x->grad.data[0] << std::endl;
 
     return 0;
 }
@@ -0,0 +1,81 @@
+#include <csignal>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "Comm.hpp"
+#include "test_check.hpp"
+
+// ShmCommunicator start-up next to a segment left by a crashed run: a rank that attaches to the
+// stale segment before rank 0 replaces it must end up on the new one.
+
+const int64_t CHUNK = 64;
+
+void sleep_ms(int ms) { usleep(useconds_t(ms) * 1000); }
+
+// Rank 'rank' of 2: allreduce of rank + 1 must give 3 everywhere.
+int run_rank(const std::string &name, int rank)
+{
+    try
+    {
+        ShmCommunicator comm(name, rank, 2, CHUNK, 10.0);
+        std::vector<double> v(3 * CHUNK, double(rank + 1));
+        comm.allreduce_sum(v.data(), int64_t(v.size()));
+        for (double x : v)
+            if (x != 3.0)
+                return 1;
+        comm.barrier();
+        return 0;
+    }
+    catch (const std::runtime_error &e)
+    {
+        std::cout << "rank " << rank << ": " << e.what() << std::endl;
+        return 1;
+    }
+}
+
+bool exited_ok(pid_t pid)
+{
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main()
+{
+    const std::string name = "/elham_test_comm_" + std::to_string(getpid());
+
+    // a run whose rank 0 dies after initializing the segment, before any rank joined
+    const pid_t crashed = fork();
+    if (crashed == 0)
+    {
+        ShmCommunicator comm(name, 0, 2, CHUNK, 30.0);
+        _exit(0);
+    }
+    int fd = -1;
+    for (int i = 0; i < 1000 && fd < 0; ++i, sleep_ms(1))
+        fd = shm_open(name.c_str(), O_RDONLY, 0);
+    check(fd >= 0, "the crashed run left its segment");
+    if (fd >= 0)
+        close(fd);
+    sleep_ms(100);
+    kill(crashed, SIGKILL);
+    waitpid(crashed, nullptr, 0);
+
+    // rank 1 attaches to the stale segment first, then rank 0 replaces it
+    const pid_t rank1 = fork();
+    if (rank1 == 0)
+        _exit(run_rank(name, 1));
+    sleep_ms(200);
+    const int rank0 = run_rank(name, 0);
+    check(rank0 == 0 && exited_ok(rank1), "both ranks reduce on the new segment");
+    shm_unlink(name.c_str());
+
+    // and a clean start, rank 0 last
+    const pid_t late = fork();
+    if (late == 0)
+        _exit(run_rank(name, 1));
+    sleep_ms(50);
+    check(run_rank(name, 0) == 0 && exited_ok(late), "clean start");
+    return test_result();
+}
@@ -0,0 +1,49 @@
+#include "test_check.hpp"
+
+// conv2d grads of input and weight against central differences, over stride, padding,
+// dilation and groups. The root C ⊙ conv2d(x, w) weights every output differently, so
+// backward computes the grad of sum(C ⊙ y).
+struct Case
+{
+    const char *what;
+    int64_t N, C, H, W, F, KH, KW;
+    Conv2dParams p;
+};
+
+Conv2dParams params(int64_t sh, int64_t sw, int64_t ph, int64_t pw, int64_t dh, int64_t dw, int64_t groups)
+{
+    Conv2dParams p;
+    p.stride[0] = sh;
+    p.stride[1] = sw;
+    p.padding[0] = ph;
+    p.padding[1] = pw;
+    p.dilation[0] = dh;
+    p.dilation[1] = dw;
+    p.groups = groups;
+    return p;
+}
+
+int main()
+{
+    const Case cases[] = {
+        {"plain", 2, 3, 6, 7, 4, 3, 3, params(1, 1, 0, 0, 1, 1, 1)},
+        {"stride", 2, 3, 9, 8, 4, 3, 2, params(2, 3, 0, 0, 1, 1, 1)},
+        {"padding", 1, 2, 5, 6, 3, 3, 3, params(1, 1, 2, 1, 1, 1, 1)},
+        {"dilation", 2, 2, 9, 9, 3, 3, 2, params(1, 1, 0, 0, 2, 3, 1)},
+        {"groups", 2, 4, 6, 6, 6, 3, 3, params(1, 1, 1, 1, 1, 1, 2)},
+        {"depthwise", 1, 4, 7, 6, 4, 3, 3, params(2, 1, 1, 1, 1, 1, 4)},
+        {"all", 2, 6, 11, 10, 9, 3, 2, params(2, 2, 1, 2, 2, 1, 3)},
+    };
+    for (const Case &c : cases)
+    {
+        auto x = std::make_shared<Variable>(random_tensor({c.N, c.C, c.H, c.W}), "x");
+        auto w = std::make_shared<Variable>(random_tensor({c.F, c.C / c.p.groups, c.KH, c.KW}), "w");
+        NodePtr y = std::make_shared<conv2d>(x, w, "y", c.p);
+        Graph probe(y, false);
+        auto C = std::make_shared<Constant>(random_tensor(probe.forward().shape), "C");
+        Graph g(std::make_shared<mul>(y, C, "C*y"), false);
+        check_gradient(g, *x, std::string(c.what) + ": d/dx");
+        check_gradient(g, *w, std::string(c.what) + ": d/dw");
+    }
+    return test_result();
+}
@@ -0,0 +1,104 @@
+#include <cstdio>
+#include <set>
+#include "DataLoader.hpp"
+#include "test_check.hpp"
+
+// DataLoader: every row once per epoch, fields split per row, handed-out batches owned by the
+// caller (never written by a worker afterwards), and recycle()d buffers reused.
+
+const int64_t ROWS = 100, COLS = 3, BATCH = 10;
+
+// Row r holds (3r, 3r + 1, 3r + 2).
+std::string write_rows()
+{
+    const std::string path = "test_data_loader.bin";
+    std::vector<double> d(static_cast<size_t>(ROWS * COLS));
+    for (size_t i = 0; i < d.size(); ++i)
+        d[i] = double(i);
+    FILE *f = std::fopen(path.c_str(), "wb");
+    std::fwrite(d.data(), sizeof(double), d.size(), f);
+    std::fclose(f);
+    return path;
+}
+
+// Rows of a batch if its fields are consistent, else an empty list.
+std::vector<int64_t> rows_of(const DataLoader::Batch &b)
+{
+    const Tensor &x = b.at("x"), &y = b.at("y");
+    std::vector<int64_t> rows;
+    for (int64_t i = 0; i < x.shape[0]; ++i)
+    {
+        const double first = x.data[static_cast<size_t>(2 * i)];
+        if (x.data[static_cast<size_t>(2 * i + 1)] != first + 1 || y.data[static_cast<size_t>(i)] != first + 2)
+            return {};
+        rows.push_back(static_cast<int64_t>(first) / 3);
+    }
+    return rows;
+}
+
+bool whole_epoch(const std::vector<DataLoader::Batch> &kept)
+{
+    std::set<int64_t> seen;
+    size_t n = 0;
+    for (auto &b : kept)
+        for (int64_t r : rows_of(b))
+        {
+            seen.insert(r);
+            ++n;
+        }
+    return n == size_t(ROWS) && seen.size() == size_t(ROWS) && *seen.begin() == 0 && *seen.rbegin() == ROWS - 1;
+}
+
+int main()
+{
+    DataLoader l(std::make_shared<BinarySource>(write_rows(), COLS), BATCH, {{"x", 2}, {"y", 1}}, true, 7, 2, 3);
+
+    // keep every batch of epoch 0 (each taken into an empty batch, as the Python iterator does)
+    std::vector<DataLoader::Batch> kept;
+    DataLoader::Batch b;
+    while (l.next(b))
+    {
+        kept.push_back(std::move(b));
+        b.clear();
+    }
+    check(int64_t(kept.size()) == l.batches_per_epoch() && whole_epoch(kept), "epoch 0: every row once, fields split per row");
+
+    // run epoch 1 to its end: the workers refill their slots, the kept batches must not change
+    std::vector<std::vector<int64_t>> before;
+    for (auto &k : kept)
+        before.push_back(rows_of(k));
+    std::vector<DataLoader::Batch> epoch1;
+    while (l.next(b))
+    {
+        epoch1.push_back(std::move(b));
+        b.clear();
+    }
+    bool unchanged = true;
+    for (size_t i = 0; i < kept.size(); ++i)
+        unchanged = unchanged && rows_of(kept[i]) == before[i];
+    check(unchanged && whole_epoch(kept), "kept batches are not written after the next epoch");
+    check(whole_epoch(epoch1) && l.epoch() == 2, "epoch 1: every row once");
+
+    // recycled buffers come back as slot storage once the ring reaches them
+    std::set<const double *> recycled;
+    for (auto &k : kept)
+    {
+        recycled.insert(k.at("x").data.data());
+        l.recycle(std::move(k));
+    }
+    int reused = 0;
+    while (l.next(b))
+    {
+        reused += recycled.count(b.at("x").data.data()) ? 1 : 0;
+        b.clear();
+    }
+    check(reused > 0, "recycled buffers are reused (" + std::to_string(reused) + " batches)");
+
+    // passing the previous batch back recycles it directly
+    std::set<const double *> buffers;
+    while (l.next(b))
+        buffers.insert(b.at("x").data.data());
+    check(buffers.size() <= 4, "next(previous batch) cycles through the slot buffers");
+    std::remove("test_data_loader.bin");
+    return test_result();
+}
@@ -0,0 +1,104 @@
+#include <sys/wait.h>
+#include <unistd.h>
+#include "DataParallel.hpp"
+#include "test_check.hpp"
+
+// Three forked ranks train the same model with DataParallel, each on its own shard. Every
+// rank must end with the weights a single process gets by stepping on the rank-averaged grad.
+
+const int WORLD = 3, STEPS = 50;
+
+struct Model
+{
+    NodePtr W1, b1, W2, x;
+    std::unique_ptr<Graph> g;
+    explicit Model(double w_fill)
+    {
+        W1 = std::make_shared<Variable>(Tensor({3, 4}, 0.0), "W1");
+        for (size_t i = 0; i < W1->value.data.size(); ++i)
+            W1->value.data[i] = w_fill * (0.1 + 0.05 * double(i % 5));
+        b1 = std::make_shared<Variable>(Tensor({4}, 0.1), "b1");
+        W2 = std::make_shared<Variable>(Tensor({4, 2}, w_fill * 0.2), "W2");
+        x = std::make_shared<Constant>(Tensor({1, 3}, 0.0), "x");
+        NodePtr h = std::make_shared<linear>(x, W1, b1, "h", Activation::Tanh);
+        NodePtr d = std::make_shared<sub>(std::make_shared<matmul>(h, W2, "hW2"),
+                                          std::make_shared<Constant>(Tensor({1, 2}, 0.5), "y"), "d");
+        NodePtr loss = std::make_shared<matmul>(std::make_shared<mul>(d, d, "d^2"),
+                                                std::make_shared<Constant>(Tensor({2, 1}, 1.0), "ones"), "loss");
+        g = std::make_unique<Graph>(loss, false);
+    }
+};
+
+// Rank r's batch at step s.
+Tensor shard(int r, int s)
+{
+    Tensor t({1, 3});
+    for (int i = 0; i < 3; ++i)
+        t.data[i] = 0.3 * r - 0.2 * i + 0.1 * (s % 2);
+    return t;
+}
+
+int run_rank(const std::string &name, int rank)
+{
+    ShmCommunicator comm(name, rank, WORLD);
+    Model m(rank == 0 ? 1.0 : -3.0); // replicas must start from rank 0's parameters
+    SGD opt(0.05);
+    DataParallel dp(*m.g, opt, comm, 5);
+    std::map<std::string, std::vector<Tensor>> feed;
+    for (int s = 0; s < 2; ++s)
+        feed["x"].push_back(shard(rank, s));
+    dp.train(STEPS, feed);
+
+    // reference: one process, grads averaged over the shards by hand
+    Model ref(1.0);
+    for (int s = 0; s < STEPS; ++s)
+    {
+        std::map<std::string, Tensor> avg;
+        for (int r = 0; r < WORLD; ++r)
+        {
+            ref.x->set_value(shard(r, s));
+            ref.g->forward();
+            ref.g->backward();
+            for (auto &p : ref.g->parameters())
+            {
+                Tensor &a = avg.emplace(p->name, Tensor::like(p->value, 0.0)).first->second;
+                for (size_t i = 0; i < a.data.size(); ++i)
+                    a.data[i] += p->grad.data[i] / WORLD;
+            }
+        }
+        for (auto &p : ref.g->parameters())
+        {
+            p->grad = avg[p->name];
+            for (size_t i = 0; i < p->value.data.size(); ++i)
+                p->value.data[i] -= 0.05 * p->grad.data[i];
+            p->mark_dirty();
+        }
+    }
+    check(dp.bucket_count() > 1, "rank " + std::to_string(rank) + ": several gradient buckets");
+    for (auto &p : m.g->parameters())
+        check_close(p->value, ref.g->leaf_named(p->name, "test")->value, 1e-12,
+                    "rank " + std::to_string(rank) + ": " + p->name + " matches averaged-gradient SGD");
+    return test_result();
+}
+
+int main()
+{
+    const std::string name = "/elham_test_dp_" + std::to_string(getpid());
+    std::vector<pid_t> children;
+    for (int r = 1; r < WORLD; ++r)
+    {
+        const pid_t pid = fork();
+        if (pid == 0)
+            _exit(run_rank(name, r));
+        children.push_back(pid);
+    }
+    int failed = run_rank(name, 0);
+    for (pid_t pid : children)
+    {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    check(!failed, "all ranks passed");
+    return failed;
+}
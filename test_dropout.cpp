@@ -0,0 +1,140 @@
+#include "Random.hpp"
+#include "Tape.hpp"
+#include "test_check.hpp"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+// Philox known-answer values, and dropout masks: one mask per forward, reused by backward and
+// jvp, identical between Graph and Tape, independent of the thread count, and never merged or
+// folded by the graph passes.
+
+// Philox4x32-10 of counter 0 under key 0 (the Random123 known-answer vector).
+const uint32_t KAT[4] = {0x6627e8d5u, 0xe169c58du, 0xbc57ac4cu, 0x9b00dbd8u};
+
+double unit(uint32_t hi, uint32_t lo)
+{
+    return double((uint64_t(hi >> 5) << 26) | (lo >> 6)) * 0x1.0p-53;
+}
+
+void check_known_answers()
+{
+    // fill_uniform: element 2b + i takes words (2i, 2i + 1) of block b
+    Tensor u({2});
+    fill_uniform(u, 0, 0, 0.0, 1.0);
+    check(u.data[0] == unit(KAT[0], KAT[1]) && u.data[1] == unit(KAT[2], KAT[3]), "fill_uniform known answer");
+
+    // dropout keeps element i of block 0 when word i >= p * 2^32; the words are 0.40, 0.88,
+    // 0.74 and 0.61 of 2^32
+    auto gen = std::make_shared<Generator>(0);
+    auto x = std::make_shared<Variable>(Tensor({4}, 1.0), "x");
+    auto d = std::make_shared<dropout>(x, 0.5, "d", gen);
+    Graph g(d, false);
+    check_close(g.forward(), Tensor(std::vector<double>{0.0, 2.0, 2.0, 2.0}), 1e-15, "dropout(p = 0.5) known answer");
+    check(gen->offset() == 1, "a 4-element mask uses one Philox block");
+    d->p = 0.7;
+    gen->set_offset(0);
+    check_close(g.forward(), Tensor(std::vector<double>{0.0, 1.0 / 0.3, 1.0 / 0.3, 0.0}), 1e-15,
+                "dropout(p = 0.7) known answer");
+}
+
+void check_mask_reuse()
+{
+    auto gen = std::make_shared<Generator>(42);
+    auto X = std::make_shared<Variable>(random_tensor({6, 8}, 0.5, 1.5), "X");
+    auto W = std::make_shared<Variable>(random_tensor({8, 3}), "W");
+    auto d = std::make_shared<dropout>(X, 0.4, "d", gen);
+    NodePtr z = std::make_shared<matmul>(d, W, "z");
+    Graph g(std::make_shared<mul>(z, z, "z^2"), false);
+
+    // backward: dX = mask / (1 - p) ⊙ (upstream), i.e. zero exactly where the forward dropped
+    g.forward();
+    g.backward();
+    const Tensor y = d->value;
+    bool same_mask = true;
+    int dropped = 0;
+    for (size_t i = 0; i < y.data.size(); ++i)
+    {
+        dropped += y.data[i] == 0.0;
+        same_mask = same_mask && ((y.data[i] == 0.0) == (X->grad.data[i] == 0.0));
+    }
+    check(same_mask && dropped > 0 && dropped < int(y.data.size()), "backward uses the forward's mask");
+
+    // every forward draws a fresh mask; rewinding the generator reproduces it
+    const uint64_t at = gen->offset();
+    g.forward();
+    check(d->value.data != y.data, "the next forward draws a new mask");
+    gen->set_offset(at - (y.size() + 3) / 4);
+    g.forward();
+    check(d->value.data == y.data, "rewinding the generator reproduces the mask");
+
+    // jvp along e runs the forward again and pushes e through that forward's mask
+    gen->set_offset(at - (y.size() + 3) / 4);
+    const Tensor e = random_tensor(X->value.shape);
+    g.jvp({{"X", e}});
+    Tensor want = Tensor::like(e, 0.0);
+    for (size_t i = 0; i < e.data.size(); ++i)
+        want.data[i] = e.data[i] * y.data[i] / X->value.data[i];
+    check_close(d->tangent, want, 1e-12, "jvp uses the forward's mask");
+
+    // Graph and Tape draw the same stream
+    Tape t(g);
+    gen->set_offset(0);
+    const Tensor gv = g.forward();
+    g.backward();
+    const Tensor gx = X->grad, gw = W->grad;
+    X->zero_grad();
+    W->zero_grad();
+    gen->set_offset(0);
+    check_close(t.forward(), gv, 0.0, "Tape: same value as Graph");
+    t.backward();
+    check_close(X->grad, gx, 0.0, "Tape: same grad of X as Graph");
+    check_close(W->grad, gw, 0.0, "Tape: same grad of W as Graph");
+
+    // evaluation: identity, in both
+    d->training = false;
+    g.forward();
+    check_close(d->value, X->value, 0.0, "eval: Graph dropout is the identity");
+    t.forward();
+    check_close(t.value("d"), X->value, 0.0, "eval: Tape dropout is the identity");
+}
+
+void check_large()
+{
+    // above the kernels' parallel threshold: drop rate, and the same mask at any thread count
+    Tensor x({1 << 18}, 1.0), y, y1;
+    dropout_into(x, 0.3, 7, 100, y);
+    int64_t dropped = 0;
+    for (double v : y.data)
+        dropped += v == 0.0;
+    const double rate = double(dropped) / double(x.size());
+    check(std::fabs(rate - 0.3) < 0.005, "drop rate " + std::to_string(rate) + " for p = 0.3");
+#if defined(_OPENMP)
+    const int threads = omp_get_max_threads();
+    omp_set_num_threads(1);
+    dropout_into(x, 0.3, 7, 100, y1);
+    omp_set_num_threads(threads);
+    check(y1.data == y.data, "same mask on one thread");
+#endif
+}
+
+void check_passes()
+{
+    // two dropouts of the same constant must stay two nodes with independent masks
+    auto ones = std::make_shared<Constant>(Tensor({1000}, 1.0), "ones", true);
+    NodePtr a = std::make_shared<dropout>(ones, 0.5, "a"), b = std::make_shared<dropout>(ones, 0.5, "b");
+    Graph g(std::make_shared<add>(a, b, "a+b"));
+    bool one_kept = false;
+    for (double v : g.forward().data)
+        one_kept = one_kept || v == 2.0;
+    check(g.report.folded == 0 && g.report.cse == 0 && one_kept, "passes keep dropouts apart and unfolded");
+}
+
+int main()
+{
+    check_known_answers();
+    check_mask_reuse();
+    check_large();
+    check_passes();
+    return test_result();
+}
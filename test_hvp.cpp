@@ -0,0 +1,115 @@
+#include "test_check.hpp"
+
+// Graph::jvp against central differences of the root, and Graph::hvp against central
+// differences of the gradient, on a root mixing elementwise ops, matmul, dot and cross.
+NodePtr build(NodePtr x, NodePtr y, NodePtr M, NodePtr q)
+{
+    NodePtr c = std::make_shared<Constant>(Tensor(std::vector<double>{2.0, 3.0}), "c");
+    NodePtr t1 = std::make_shared<mul>(std::make_shared<power>(x, c, "x^c"), y, "x^c*y");
+    NodePtr t2 = std::make_shared<divide>(std::make_shared<exp_op>(std::make_shared<mul>(x, y, "xy"), "exp"), y, "exp/y");
+    NodePtr t3 = std::make_shared<add>(std::make_shared<ln_op>(x, "ln"), std::make_shared<sqrt_op>(y, "sqrt"), "ln+sqrt");
+    NodePtr t4 = std::make_shared<add>(std::make_shared<log_base>(x, y, "log_y"), std::make_shared<power>(x, y, "x^y"), "log+pow");
+    NodePtr s = std::make_shared<add>(std::make_shared<add>(t1, t2, "s1"), std::make_shared<sub>(t3, t4, "s2"), "s");
+    NodePtr w = std::make_shared<Constant>(Tensor(std::vector<double>{1.0, -0.5}), "w");
+
+    NodePtr col = std::make_shared<Constant>(Tensor(std::vector<std::vector<double>>{{1.0}, {2.0}}), "col");
+    NodePtr mv = std::make_shared<matmul>(M, std::make_shared<matmul>(M, col, "M col"), "M M col");
+    NodePtr ones = std::make_shared<Constant>(Tensor(std::vector<std::vector<double>>{{1.0, 1.0}}), "ones");
+    NodePtr sumsq = std::make_shared<matmul>(ones, std::make_shared<mul>(mv, mv, "mv^2"), "sum mv^2");
+
+    NodePtr r = std::make_shared<Constant>(Tensor(std::vector<double>{0.5, -1.0, 2.0}), "r");
+    NodePtr qr = std::make_shared<cross>(q, r, "q x r");
+    NodePtr tot = std::make_shared<add>(std::make_shared<dot>(s, w, "s.w"),
+                                        std::make_shared<mul>(std::make_shared<dot>(qr, qr, "|q x r|^2"),
+                                                              std::make_shared<dot>(x, y, "x.y"), "prod"),
+                                        "tot");
+    return std::make_shared<add>(tot, sumsq, "root");
+}
+
+// Move every Variable by s * v[name].
+void shift(Graph &g, const std::map<std::string, Tensor> &v, double s)
+{
+    for (auto &p : g.parameters())
+    {
+        const Tensor &d = v.at(p->name);
+        for (size_t i = 0; i < d.data.size(); ++i)
+            p->value.data[i] += s * d.data[i];
+        p->mark_dirty();
+    }
+}
+
+std::map<std::string, Tensor> gradients(Graph &g)
+{
+    g.forward();
+    g.backward();
+    std::map<std::string, Tensor> out;
+    for (auto &p : g.parameters())
+        out[p->name] = p->grad;
+    return out;
+}
+
+int main()
+{
+    NodePtr x = std::make_shared<Variable>(Tensor(std::vector<double>{1.3, 0.7}), "x");
+    NodePtr y = std::make_shared<Variable>(Tensor(std::vector<double>{1.8, 2.2}), "y");
+    NodePtr M = std::make_shared<Variable>(Tensor(std::vector<std::vector<double>>{{0.3, 0.2}, {0.1, 0.5}}), "M");
+    NodePtr q = std::make_shared<Variable>(Tensor(std::vector<double>{1.0, 2.0, 3.0}), "q");
+    Graph g(build(x, y, M, q));
+
+    const std::map<std::string, Tensor> v{{"x", random_tensor({2})},
+                                          {"y", random_tensor({2})},
+                                          {"M", random_tensor({2, 2})},
+                                          {"q", random_tensor({3})}};
+    const double h = 1e-5;
+
+    // jvp: d root / dt along v
+    const Tensor jv = g.jvp(v);
+    shift(g, v, h);
+    const double up = g.forward().data[0];
+    shift(g, v, -2 * h);
+    const double down = g.forward().data[0];
+    shift(g, v, h);
+    check_close(jv, Tensor::like(jv, (up - down) / (2 * h)), 1e-6, "jvp vs finite differences");
+
+    // hvp: d grad / dt along v; hvp also leaves the plain gradient in 'grad'
+    const std::map<std::string, Tensor> Hv = g.hvp(v);
+    std::map<std::string, Tensor> hvp_grad;
+    for (auto &p : g.parameters())
+        hvp_grad[p->name] = p->grad;
+    const std::map<std::string, Tensor> grad = gradients(g);
+    for (auto &kv : grad)
+        check_close(hvp_grad.at(kv.first), kv.second, 1e-12, "hvp leaves the gradient of " + kv.first);
+    shift(g, v, h);
+    std::map<std::string, Tensor> gp = gradients(g);
+    shift(g, v, -2 * h);
+    std::map<std::string, Tensor> gm = gradients(g);
+    shift(g, v, h);
+    for (auto &kv : Hv)
+    {
+        Tensor fd = Tensor::like(kv.second, 0.0);
+        for (size_t i = 0; i < fd.data.size(); ++i)
+            fd.data[i] = (gp[kv.first].data[i] - gm[kv.first].data[i]) / (2 * h);
+        check_close(kv.second, fd, 1e-6, "hvp vs finite differences of the gradient, " + kv.first);
+    }
+
+    // tangent names must each resolve to one Variable
+    auto rejects = [](Graph &graph, const std::map<std::string, Tensor> &t)
+    {
+        try
+        {
+            graph.jvp(t);
+        }
+        catch (const std::runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    };
+    check(rejects(g, {{"z", random_tensor({2})}}), "jvp rejects an unknown name");
+    check(rejects(g, {{"c", random_tensor({2})}}), "jvp rejects a Constant");
+    check(rejects(g, {{"x", random_tensor({3})}}), "jvp rejects a tangent of the wrong shape");
+    NodePtr a = std::make_shared<Variable>(Tensor(1.0), "dup"), b = std::make_shared<Variable>(Tensor(2.0), "dup");
+    Graph dup(std::make_shared<mul>(a, b, "ab"));
+    check(rejects(dup, {{"dup", Tensor(1.0)}}), "jvp rejects a name shared by two Variables");
+    return test_result();
+}
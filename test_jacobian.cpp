@@ -0,0 +1,63 @@
+#include "test_check.hpp"
+
+// Graph::jacobian against central differences of the (non-scalar) root, for several seed
+// chunk sizes and for a subset of the leaves.
+
+// J[name] has shape (*root.shape, *leaf.shape): column j is d root / d leaf[j].
+Tensor numeric_jacobian(Graph &g, Node &leaf, double h = 1e-6)
+{
+    const int64_t m = g.forward().size(), n = leaf.value.size();
+    Shape s = g.root->value.shape;
+    for (auto d : leaf.value.shape)
+        s.push_back(d);
+    Tensor J(s, 0.0);
+    for (int64_t j = 0; j < n; ++j)
+    {
+        const double x = leaf.value.data[j];
+        leaf.value.data[j] = x + h;
+        leaf.mark_dirty();
+        const Tensor up = g.forward();
+        leaf.value.data[j] = x - h;
+        leaf.mark_dirty();
+        const Tensor &down = g.forward();
+        for (int64_t i = 0; i < m; ++i)
+            J.data[i * n + j] = (up.data[i] - down.data[i]) / (2.0 * h);
+        leaf.value.data[j] = x;
+        leaf.mark_dirty();
+    }
+    g.forward();
+    return J;
+}
+
+int main()
+{
+    // 2-layer MLP with a row-wise log_softmax, plus an elementwise term in a vector leaf
+    auto X = std::make_shared<Constant>(random_tensor({5, 4}), "X");
+    auto W1 = std::make_shared<Variable>(random_tensor({4, 6}), "W1");
+    auto b1 = std::make_shared<Variable>(random_tensor({6}), "b1");
+    auto W2 = std::make_shared<Variable>(random_tensor({6, 3}), "W2");
+    auto u = std::make_shared<Variable>(random_tensor({3}, 0.5, 1.5), "u");
+    NodePtr h = std::make_shared<linear>(X, W1, b1, "h", Activation::Tanh);
+    NodePtr z = std::make_shared<matmul>(h, W2, "z");
+    NodePtr ls = std::make_shared<log_softmax_op>(z, "log_softmax", 1);
+    NodePtr root = std::make_shared<add>(std::make_shared<mul>(ls, u, "ls*u"), std::make_shared<ln_op>(u, "ln u"), "root");
+    Graph g(root, false);
+
+    std::map<std::string, Tensor> fd;
+    for (auto &p : g.parameters())
+        fd[p->name] = numeric_jacobian(g, *p);
+
+    for (int64_t chunk : {0, 1, 4, 15})
+    {
+        const std::map<std::string, Tensor> J = g.jacobian({}, chunk);
+        check(J.size() == fd.size(), "chunk " + std::to_string(chunk) + ": one Jacobian per Variable");
+        for (auto &kv : J)
+            check_close(kv.second, fd.at(kv.first), 1e-6, "chunk " + std::to_string(chunk) + ": d root / d " + kv.first);
+    }
+
+    const std::map<std::string, Tensor> J = g.jacobian({"W2", "u"});
+    check(J.size() == 2 && J.count("W2") && J.count("u"), "wrt selects the leaves");
+    for (auto &kv : J)
+        check_close(kv.second, fd.at(kv.first), 1e-6, "wrt: d root / d " + kv.first);
+    return test_result();
+}
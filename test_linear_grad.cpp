@@ -0,0 +1,51 @@
+#include "test_check.hpp"
+
+// linear (fused X @ W + b and activation) grads of X, W and b against central differences, for
+// every activation, with and without a bias, on a small shape and on one large enough for the
+// blocked, multithreaded GEMM paths.
+
+const char *name_of(Activation act)
+{
+    switch (act)
+    {
+    case Activation::None:
+        return "none";
+    case Activation::ReLU:
+        return "relu";
+    case Activation::GELU:
+        return "gelu";
+    case Activation::Tanh:
+        return "tanh";
+    case Activation::Sigmoid:
+        return "sigmoid";
+    }
+    return "?";
+}
+
+void check_linear(int64_t n, int64_t k, int64_t m, Activation act, bool bias)
+{
+    auto X = std::make_shared<Variable>(random_tensor({n, k}), "X");
+    auto W = std::make_shared<Variable>(random_tensor({k, m}), "W");
+    auto b = std::make_shared<Variable>(random_tensor({m}), "b");
+    NodePtr y = std::make_shared<linear>(X, W, bias ? NodePtr(b) : nullptr, "y", act);
+    auto C = std::make_shared<Constant>(random_tensor({n, m}), "C");
+    Graph g(std::make_shared<mul>(y, C, "C*y"), false);
+
+    const std::string what = std::string(name_of(act)) + (bias ? " + bias" : "") + ", " + std::to_string(n) +
+                             "x" + std::to_string(k) + " @ " + std::to_string(k) + "x" + std::to_string(m);
+    check_gradient(g, *X, what + ": d/dX");
+    check_gradient(g, *W, what + ": d/dW");
+    if (bias)
+        check_gradient(g, *b, what + ": d/db");
+}
+
+int main()
+{
+    for (Activation act : {Activation::None, Activation::ReLU, Activation::GELU, Activation::Tanh, Activation::Sigmoid})
+        for (bool bias : {true, false})
+        {
+            check_linear(6, 5, 7, act, bias);
+            check_linear(40, 30, 35, act, bias);
+        }
+    return test_result();
+}
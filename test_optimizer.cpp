@@ -0,0 +1,95 @@
+#include "Optimizer.hpp"
+#include "test_check.hpp"
+
+// The fused optimizer updates against a per-element reference over parameter sets that are
+// below and above the kernels' parallel threshold, with sizes around the 8192-element block so
+// every element must be updated exactly once.
+
+struct Param
+{
+    NodePtr node;
+    std::vector<double> w, m, v; // reference state
+};
+
+std::vector<Param> make_params(const std::vector<int64_t> &sizes)
+{
+    std::vector<Param> ps;
+    for (size_t i = 0; i < sizes.size(); ++i)
+    {
+        Param p;
+        p.node = std::make_shared<Variable>(random_tensor({sizes[i]}), "p" + std::to_string(i));
+        p.w.assign(p.node->value.data.begin(), p.node->value.data.end());
+        p.m.assign(p.w.size(), 0.0);
+        p.v.assign(p.w.size(), 0.0);
+        ps.push_back(std::move(p));
+    }
+    return ps;
+}
+
+// Runs two steps of 'opt' and of 'ref(p, i, g, t)' on fresh grads, then compares the values.
+template <class Ref>
+void check_steps(const std::string &what, Optimizer &opt, const std::vector<int64_t> &sizes, Ref ref)
+{
+    std::vector<Param> ps = make_params(sizes);
+    std::vector<NodePtr> nodes;
+    for (auto &p : ps)
+        nodes.push_back(p.node);
+    for (int64_t t = 1; t <= 2; ++t)
+    {
+        for (auto &p : ps)
+        {
+            p.node->grad = random_tensor(p.node->value.shape);
+            for (size_t i = 0; i < p.w.size(); ++i)
+                ref(p, i, p.node->grad.data[i], t);
+        }
+        opt.step(nodes);
+    }
+    double err = 0.0;
+    for (auto &p : ps)
+        for (size_t i = 0; i < p.w.size(); ++i)
+        {
+            const double d = std::fabs(p.node->value.data[i] - p.w[i]);
+            if (!(d <= err)) // keeps a NaN
+                err = d;
+        }
+    std::ostringstream msg;
+    msg << what << " (error " << err << ")";
+    check(err <= 1e-12, msg.str());
+}
+
+int main()
+{
+    const std::vector<std::vector<int64_t>> sets = {{1, 3, 100, 7},                           // one thread
+                                                    {1, 8191, 8192, 8193, 3, 50000, 16385, 2}}; // parallel
+    for (size_t s = 0; s < sets.size(); ++s)
+    {
+        const std::string tag = s ? " (parallel)" : " (small)";
+        const double lr = 0.05, wd = 0.01, mu = 0.9, b1 = 0.9, b2 = 0.99, eps = 1e-8;
+
+        SGD sgd(lr, wd);
+        check_steps("SGD" + tag, sgd, sets[s], [&](Param &p, size_t i, double g, int64_t)
+                    { p.w[i] -= lr * (g + wd * p.w[i]); });
+
+        Momentum nesterov(lr, mu, wd, true);
+        check_steps("Nesterov momentum" + tag, nesterov, sets[s], [&](Param &p, size_t i, double g, int64_t)
+                    {
+            const double gi = g + wd * p.w[i];
+            p.m[i] = mu * p.m[i] + gi;
+            p.w[i] -= lr * (gi + mu * p.m[i]); });
+
+        for (bool decoupled : {false, true})
+        {
+            Adam adam(lr, b1, b2, eps, wd);
+            AdamW adamw(lr, b1, b2, eps, wd);
+            check_steps((decoupled ? "AdamW" : "Adam") + tag, decoupled ? static_cast<Optimizer &>(adamw) : adam, sets[s],
+                        [&](Param &p, size_t i, double g, int64_t t)
+                        {
+                const double gi = decoupled ? g : g + wd * p.w[i];
+                p.m[i] = b1 * p.m[i] + (1.0 - b1) * gi;
+                p.v[i] = b2 * p.v[i] + (1.0 - b2) * gi * gi;
+                const double mh = p.m[i] / (1.0 - std::pow(b1, double(t))), vh = p.v[i] / (1.0 - std::pow(b2, double(t)));
+                p.w[i] = (decoupled ? 1.0 - lr * wd : 1.0) * p.w[i] - lr * mh / (std::sqrt(vh) + eps); });
+        }
+    }
+    return test_result();
+}
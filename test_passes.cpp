@@ -0,0 +1,93 @@
+#include "Optimizer.hpp"
+#include "test_check.hpp"
+
+// The construction-time passes: PassReport counts on known graphs, and named Constants
+// (inputs fed by name) that must survive folding, simplification and CSE untouched.
+
+Tensor vec(std::vector<double> v) { return Tensor(v); }
+
+void check_chain()
+{
+    // test_code.cpp's graph: 501 copies of x^2 over the literal 2, plus the literal 6
+    NodePtr x = std::make_shared<Variable>(Tensor(3.0), "x");
+    NodePtr two = std::make_shared<Constant>(Tensor(2.0), "two", true);
+    NodePtr y = std::make_shared<add>(std::make_shared<power>(x, two, "x^2"),
+                                      std::make_shared<Constant>(Tensor(6.0), "six", true), "y0");
+    for (int i = 1; i <= 500; ++i)
+        y = std::make_shared<add>(std::make_shared<power>(x, two, "x^2_" + std::to_string(i)), y,
+                                  "y" + std::to_string(i));
+    Graph g(y);
+    // x^2 -> x*x drops the literal 2; CSE then merges the 501 identical x*x into one
+    check(g.report.folded == 0 && g.report.simplified == 1 && g.report.cse == 500,
+          "chain: folded 0, simplified 1, cse 500");
+    check(g.order.size() == 504, "chain: x, x*x, 6 and 501 adds left");
+    check(g.forward().data[0] == 501 * 9.0 + 6.0, "chain: value");
+    g.backward();
+    check(x->grad.data[0] == 501 * 6.0, "chain: grad");
+}
+
+void check_literals()
+{
+    // (2 + 3) * x folds to 5 * x; x * 1 (unnamed, so literal) and x + 0 disappear
+    auto x = std::make_shared<Variable>(vec({1.0, -2.0}), "x");
+    NodePtr five = std::make_shared<add>(std::make_shared<Constant>(Tensor(2.0), "a", true),
+                                         std::make_shared<Constant>(Tensor(3.0), "b", true), "a+b");
+    NodePtr y = std::make_shared<mul>(five, x, "5x");
+    y = std::make_shared<mul>(y, std::make_shared<Constant>(Tensor(1.0), "", false), "*1");
+    y = std::make_shared<add>(y, std::make_shared<Constant>(Tensor(0.0), "zero", true), "+0");
+    Graph g(y);
+    check(g.report.folded == 2 && g.report.simplified == 4 && g.report.cse == 0,
+          "literals: folded 2, simplified 4, cse 0");
+    check_close(g.forward(), vec({5.0, -10.0}), 0.0, "literals: value");
+
+    bool threw = false;
+    try
+    {
+        Graph(std::make_shared<add>(x, std::make_shared<Constant>(Tensor(1.0), "c", true), "x+c"))
+            .leaf_named("c", "test");
+    }
+    catch (const std::runtime_error &)
+    {
+        threw = true;
+    }
+    check(threw, "literals: feeding a literal throws");
+}
+
+void check_placeholders()
+{
+    // two zero-filled inputs of the same shape, an input added to something, an operator
+    // over inputs only: none of them may be merged, simplified or folded
+    auto v = std::make_shared<Variable>(vec({1.0, 1.0}), "v");
+    auto x = std::make_shared<Constant>(vec({0.0, 0.0}), "x");
+    auto x2 = std::make_shared<Constant>(vec({0.0, 0.0}), "x2");
+    auto s = std::make_shared<Constant>(Tensor(1.0), "s");
+    NodePtr vx = std::make_shared<add>(v, x, "v+x");
+    NodePtr x2s = std::make_shared<mul>(x2, s, "x2*s");
+    NodePtr xx2 = std::make_shared<add>(x, x2, "x+x2");
+    Graph g(std::make_shared<add>(std::make_shared<add>(vx, x2s, "p"), xx2, "root"));
+    check(g.report.folded == 0 && g.report.simplified == 0 && g.report.cse == 0,
+          "placeholders: nothing removed");
+    check_close(g.forward(), vec({1.0, 1.0}), 0.0, "placeholders: initial value");
+
+    g.leaf_named("x", "test")->set_value(vec({1.0, 2.0}));
+    check_close(g.forward(), vec({3.0, 5.0}), 0.0, "placeholders: feeding x leaves x2 alone");
+    g.leaf_named("x2", "test")->set_value(vec({10.0, 20.0}));
+    g.leaf_named("s", "test")->set_value(Tensor(2.0));
+    check_close(g.forward(), vec({33.0, 65.0}), 0.0, "placeholders: feeding x2 and s");
+
+    // Graph::train feeds by name too; lr = 0 keeps w, so the losses are the fed values
+    auto w = std::make_shared<Variable>(Tensor(0.0), "w");
+    auto in = std::make_shared<Constant>(Tensor(0.0), "in");
+    Graph t(std::make_shared<add>(w, in, "w+in"));
+    SGD sgd(0.0);
+    const std::vector<double> losses = t.train(3, sgd, {{"in", {Tensor(1.0), Tensor(2.0)}}});
+    check(losses == std::vector<double>{1.0, 2.0, 1.0}, "placeholders: Graph::train feeds an input added to a Variable");
+}
+
+int main()
+{
+    check_chain();
+    check_literals();
+    check_placeholders();
+    return test_result();
+}
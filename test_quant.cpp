@@ -0,0 +1,175 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include "test_check.hpp"
+
+// The int8 inference path: qlinear_into and a quantized Graph against fp64 within the
+// quantization error, the k <= 65536 accumulator guard, gradients refused while quantized, and
+// the same bits from every kernel variant (this binary re-runs itself once per
+// ELHAMMATH_KERNEL_ISA value and compares what each run prints).
+
+Tensor qlinear(const Tensor &X, const Tensor &W, const Tensor *bias, Activation act, const QuantParams &qp)
+{
+    QActivations qx;
+    QWeights qw;
+    Tensor Y;
+    quantize_into(X, qp, qx);
+    quantize_weights(W, qw);
+    qlinear_into(qx, qw, bias, act, Y);
+    return Y;
+}
+
+Tensor qlinear(const Tensor &X, const Tensor &W, const Tensor *bias, Activation act)
+{
+    const auto mm = std::minmax_element(X.data.begin(), X.data.end());
+    return qlinear(X, W, bias, act, QuantParams::from_range(*mm.first, *mm.second));
+}
+
+// Two layers, both on the int8 kernels once quantized: X is fed by name.
+struct Mlp
+{
+    std::shared_ptr<Constant> X = std::make_shared<Constant>(random_tensor({16, 40}), "X");
+    std::shared_ptr<Variable> W1 = std::make_shared<Variable>(random_tensor({40, 23}), "W1");
+    std::shared_ptr<Variable> b1 = std::make_shared<Variable>(random_tensor({23}), "b1");
+    std::shared_ptr<Variable> W2 = std::make_shared<Variable>(random_tensor({23, 6}), "W2");
+    Graph g{std::make_shared<matmul>(std::make_shared<linear>(X, W1, b1, "h", Activation::GELU), W2, "z"), false};
+};
+
+// Quantized results whose bits must not depend on the kernel variant: odd k and n reach the
+// vector loops and their scalar tails.
+std::vector<Tensor> isa_outputs()
+{
+    std::vector<Tensor> out;
+    for (int64_t k : {7, 64, 131})
+    {
+        const Tensor X = random_tensor({9, k}), W = random_tensor({k, 13}), b = random_tensor({13});
+        out.push_back(qlinear(X, W, &b, Activation::Tanh));
+        out.push_back(qlinear(X, W, nullptr, Activation::ReLU));
+    }
+    Mlp m;
+    m.g.quantize();
+    out.push_back(m.g.forward());
+    return out;
+}
+
+// The outputs as hex floats, one line per tensor.
+std::string dump(const std::vector<Tensor> &ts)
+{
+    std::string s;
+    char buf[32];
+    for (auto &t : ts)
+    {
+        for (double v : t.data)
+        {
+            std::snprintf(buf, sizeof buf, "%a ", v);
+            s += buf;
+        }
+        s += "\n";
+    }
+    return s;
+}
+
+// Output of this binary run with ELHAMMATH_KERNEL_ISA=isa and --dump.
+std::string run_with_isa(const std::string &isa)
+{
+    char self[4096];
+    const ssize_t len = readlink("/proc/self/exe", self, sizeof self - 1);
+    if (len <= 0)
+        return "";
+    self[len] = '\0';
+    setenv("ELHAMMATH_KERNEL_ISA", isa.c_str(), 1);
+    FILE *p = popen(("'" + std::string(self) + "' --dump").c_str(), "r");
+    unsetenv("ELHAMMATH_KERNEL_ISA");
+    if (!p)
+        return "";
+    std::string s;
+    char buf[4096];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof buf, p)) > 0)
+        s.append(buf, n);
+    return pclose(p) == 0 ? s : "";
+}
+
+void check_against_fp64()
+{
+    // one layer: the quantization steps of X and W bound the error
+    const Tensor X = random_tensor({12, 96}), W = random_tensor({96, 10}), b = random_tensor({10});
+    Tensor Y, pre;
+    linear_into(X, W, &b, Activation::GELU, Y, pre);
+    check_close(qlinear(X, W, &b, Activation::GELU), Y, 0.02, "qlinear_into vs fp64 linear");
+
+    // a calibrated two-layer graph, then the same graph back on fp64
+    Mlp m;
+    const Tensor ref = m.g.forward();
+    std::vector<std::map<std::string, Tensor>> batches;
+    for (int i = 0; i < 4; ++i)
+        batches.push_back({{"X", random_tensor({16, 40})}});
+    batches.push_back({{"X", m.X->value}});
+    m.g.calibrate(batches);
+    m.g.quantize();
+    check(m.g.quantized(), "quantize() switches the graph to int8");
+    check_close(m.g.forward(), ref, 0.03, "calibrated int8 graph vs fp64");
+    const QuantReport r = m.g.quantization_report(batches);
+    check(r.quantized_ops == 2 && r.root.rel_error < 0.03, "quantization_report: two ops, small root error");
+    m.g.quantize(false);
+    check_close(m.g.forward(), ref, 0.0, "quantize(false) restores fp64");
+}
+
+template <class F>
+bool throws(F &&f)
+{
+    try
+    {
+        f();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+void check_fp64_only()
+{
+    Mlp m;
+    NodePtr uz = std::make_shared<matmul>(std::make_shared<Constant>(random_tensor({1, 16}), "u"), m.g.root, "u z");
+    Graph loss(std::make_shared<matmul>(uz, std::make_shared<Constant>(random_tensor({6, 1}), "v"), "loss"), false);
+    loss.quantize();
+    const std::map<std::string, Tensor> v{{"W2", random_tensor({23, 6})}};
+    check(throws([&] { loss.backward(); }), "backward throws while quantized");
+    check(throws([&] { loss.jvp(v); }), "jvp throws while quantized");
+    check(throws([&] { loss.hvp(v); }), "hvp throws while quantized");
+    check(throws([&] { loss.jacobian(); }), "jacobian throws while quantized");
+    loss.quantize(false);
+    loss.forward();
+    check(!throws([&] { loss.backward(); }), "forward and backward run after quantize(false)");
+}
+
+void check_guard()
+{
+    // k = 65536 at full scale is the largest sum the int32 accumulators hold: 255 * -127 * 65536
+    const int64_t k = 65536;
+    const Tensor ones({1, k}, 1.0), minus({k, 4}, -1.0);
+    check_close(qlinear(ones, minus, nullptr, Activation::None, QuantParams::from_range(0.0, 1.0)), Tensor({1, 4}, -double(k)),
+                1e-12, "k = 65536 at full scale does not overflow");
+    const Tensor wide({1, k + 1}, 1.0), W({k + 1, 4}, -1.0);
+    check(throws([&] { qlinear(wide, W, nullptr, Activation::None); }), "k = 65537 is rejected");
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--dump")
+    {
+        std::cout << dump(isa_outputs());
+        return 0;
+    }
+    // first, so the random inputs match the --dump runs
+    const std::string here = dump(isa_outputs());
+    check_against_fp64();
+    check_fp64_only();
+    check_guard();
+    for (auto &isa : kernel_isas())
+        check(run_with_isa(isa) == here, std::string("ELHAMMATH_KERNEL_ISA=") + isa + ": same bits as " + kernel_isa());
+    return test_result();
+}
@@ -0,0 +1,39 @@
+#include "test_check.hpp"
+
+// softmax, log_softmax, logsumexp and softmax_cross_entropy grads against central differences
+// on every axis of a 3-D input, at moderate logits and at logits large enough that exp
+// overflows without the max shift.
+
+template <class Op>
+void check_reduction(const char *what, int64_t axis, double scale)
+{
+    auto x = std::make_shared<Variable>(random_tensor({3, 4, 5}, -scale, scale), "x");
+    NodePtr y = std::make_shared<Op>(x, "y", axis);
+    Graph probe(y, false);
+    auto C = std::make_shared<Constant>(random_tensor(probe.forward().shape), "C");
+    Graph g(std::make_shared<mul>(y, C, "C*y"), false);
+    check_gradient(g, *x, std::string(what) + ", axis " + std::to_string(axis) + ", |x| < " + std::to_string(int(scale)));
+}
+
+void check_cross_entropy(int64_t axis, double scale)
+{
+    auto z = std::make_shared<Variable>(random_tensor({3, 4, 5}, -scale, scale), "z");
+    auto t = std::make_shared<Variable>(random_tensor({3, 4, 5}, 0.0, 1.0), "t");
+    Graph g(std::make_shared<softmax_cross_entropy>(z, t, "ce", axis), false);
+    const std::string what = "softmax_cross_entropy, axis " + std::to_string(axis) + ", |z| < " + std::to_string(int(scale));
+    check_gradient(g, *z, what + ": d/dz");
+    check_gradient(g, *t, what + ": d/dt");
+}
+
+int main()
+{
+    for (double scale : {2.0, 800.0})
+        for (int64_t axis : {0, 1, 2, -1})
+        {
+            check_reduction<softmax_op>("softmax", axis, scale);
+            check_reduction<log_softmax_op>("log_softmax", axis, scale);
+            check_reduction<logsumexp_op>("logsumexp", axis, scale);
+            check_cross_entropy(axis, scale);
+        }
+    return test_result();
+}
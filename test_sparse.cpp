@@ -0,0 +1,114 @@
+#include "test_check.hpp"
+
+// CsrTensor construction (the owning constructor and the borrowed int32 arrays from_scipy
+// builds), and sparse_matmul against dense matmul: values, the grad of the dense operand and
+// the grad at the sparse operand's nonzeros, below and above the kernels' parallel threshold.
+
+template <class F>
+bool throws(F &&f)
+{
+    try
+    {
+        f();
+    }
+    catch (const std::runtime_error &)
+    {
+        return true;
+    }
+    return false;
+}
+
+// rows x cols with about 'density' of the entries nonzero, and an empty row 1.
+Tensor sparse_dense(int64_t rows, int64_t cols, double density)
+{
+    Tensor D = random_tensor({rows, cols});
+    const Tensor keep = random_tensor({rows, cols}, 0.0, 1.0);
+    for (size_t i = 0; i < D.data.size(); ++i)
+        if (keep.data[i] >= density || int64_t(i) / cols == 1)
+            D.data[i] = 0.0;
+    return D;
+}
+
+void check_construction()
+{
+    // [[1, 0, 2], [0, 0, 0], [0, 3, 0]]
+    const CsrTensor A(3, 3, {0, 2, 2, 3}, {0, 2, 1}, {1.0, 2.0, 3.0});
+    check(A.nnz == 3, "owning constructor: nnz");
+    check_close(A.to_dense(), Tensor(std::vector<std::vector<double>>{{1, 0, 2}, {0, 0, 0}, {0, 3, 0}}), 0.0,
+                "owning constructor: to_dense");
+    check(throws([] { CsrTensor(3, 3, {0, 2, 3}, {0, 2, 1}, {1.0, 2.0, 3.0}); }), "rejects indptr of the wrong length");
+    check(throws([] { CsrTensor(3, 3, {0, 2, 1, 3}, {0, 2, 1}, {1.0, 2.0, 3.0}); }), "rejects a decreasing indptr");
+    check(throws([] { CsrTensor(3, 3, {0, 2, 2, 3}, {0, 3, 1}, {1.0, 2.0, 3.0}); }), "rejects a column out of range");
+    check(throws([] { CsrTensor(3, 3, {0, 2, 2, 3}, {0, 2, 1}, {1.0, 2.0}); }), "rejects indices/values of different lengths");
+    check(throws([] { CsrTensor(0, 3, {0}, {}, {}); }), "rejects an empty shape");
+
+    // from_scipy borrows SciPy's int32 indptr/indices: the same products as the int64 form
+    const CsrTensor S = CsrTensor::from_dense(sparse_dense(40, 30, 0.2));
+    std::vector<int32_t> indptr, indices;
+    for (int64_t i = 0; i <= S.rows; ++i)
+        indptr.push_back(int32_t(S.row_begin(i)));
+    for (int64_t p = 0; p < S.nnz; ++p)
+        indices.push_back(int32_t(S.col(p)));
+    CsrTensor S32;
+    S32.rows = S.rows;
+    S32.cols = S.cols;
+    S32.nnz = S.nnz;
+    S32.values = S.values;
+    S32.indptr32 = indptr.data();
+    S32.indices32 = indices.data();
+    const Tensor B = random_tensor({30, 5}), G = random_tensor({40, 5});
+    check_close(spmm(S32, B), spmm(S, B), 0.0, "int32 indices: spmm");
+    check_close(spmm_t(S32, G), spmm_t(S, G), 0.0, "int32 indices: spmm_t");
+    check(sddmm(S32, G, B) == sddmm(S, G, B), "int32 indices: sddmm");
+}
+
+void check_matmul(const std::string &tag, int64_t m, int64_t k, int64_t n, double density)
+{
+    const Tensor Sd = sparse_dense(m, k, density);
+    auto S = std::make_shared<SparseVariable>(CsrTensor::from_dense(Sd), "S");
+    auto D = std::make_shared<Variable>(random_tensor({k, n}), "D");
+    NodePtr sp = std::make_shared<sparse_matmul>(S, D, "S D");
+    Graph g(std::make_shared<mul>(sp, sp, "(S D)^2"), false);
+    check((S->csr.nnz * n > 32768) == (tag == "parallel"), tag + ": nnz * n on the expected side of the threshold");
+
+    Tensor want = matmul2d(Sd, D->value);
+    for (auto &v : want.data)
+        v *= v;
+    check_close(g.forward(), want, 1e-12, tag + ": value");
+    check_gradient(g, *D, tag + ": grad of the dense operand");
+
+    // the sparse grad at each nonzero against central differences in that value
+    g.forward();
+    g.backward();
+    const std::vector<double> got = S->grad_values;
+    std::vector<double> vals(S->csr.values, S->csr.values + S->csr.nnz);
+    const CsrTensor base = S->csr;
+    const double h = 1e-6;
+    Tensor fd({S->csr.nnz}), an({S->csr.nnz});
+    for (size_t p = 0; p < vals.size(); ++p)
+    {
+        const double x = vals[p];
+        vals[p] = x + h;
+        S->csr = base.with_values(vals);
+        S->mark_dirty();
+        const double up = sum_of(g.forward());
+        vals[p] = x - h;
+        S->csr = base.with_values(vals);
+        S->mark_dirty();
+        const double down = sum_of(g.forward());
+        vals[p] = x;
+        fd.data[p] = (up - down) / (2.0 * h);
+        an.data[p] = got[p];
+    }
+    S->csr = base;
+    S->mark_dirty();
+    check_close(an, fd, 1e-6, tag + ": grad at the sparse nonzeros");
+}
+
+int main()
+{
+    check_construction();
+    check_matmul("serial", 12, 9, 4, 0.3);
+    check_matmul("parallel", 200, 150, 16, 0.12);
+    return test_result();
+}
@@ -0,0 +1,143 @@
+#include "Random.hpp"
+#include "Tape.hpp"
+#include "test_check.hpp"
+
+// Tape (the flat compiled form of a Graph) against Graph::forward/backward: both run the same
+// kernels, so the root value and every leaf grad must match exactly, also after a leaf update.
+
+void compare(const std::string &what, Graph &g, const std::vector<NodePtr> &leaves)
+{
+    Tape t(g);
+    for (int round = 0; round < 2; ++round)
+    {
+        const std::string tag = what + (round ? " (after a leaf update)" : "");
+        const Tensor value = g.forward();
+        g.backward();
+        std::vector<Tensor> grads;
+        std::vector<std::vector<double>> sparse_grads;
+        for (auto &l : leaves)
+        {
+            grads.push_back(l->grad);
+            if (auto s = std::dynamic_pointer_cast<SparseVariable>(l))
+                sparse_grads.push_back(s->grad_values);
+            l->zero_grad();
+        }
+
+        check_close(t.forward(), value, 0.0, tag + ": root value");
+        t.backward();
+        size_t j = 0;
+        for (size_t k = 0; k < leaves.size(); ++k)
+        {
+            check_close(leaves[k]->grad, grads[k], 0.0, tag + ": grad of " + leaves[k]->name);
+            if (auto s = std::dynamic_pointer_cast<SparseVariable>(leaves[k]))
+                check(s->grad_values == sparse_grads[j++], tag + ": sparse grad of " + s->name);
+        }
+
+        // the tape reads leaf values from the Graph's nodes
+        for (auto &l : leaves)
+            if (!std::dynamic_pointer_cast<SparseVariable>(l))
+            {
+                for (auto &v : l->value.data)
+                    v *= 0.9;
+                l->mark_dirty();
+            }
+    }
+}
+
+int main()
+{
+    { // elementwise ops with broadcasting, pow, log_base, dot and cross
+        auto x = std::make_shared<Variable>(random_tensor({3}, 0.5, 2.0), "x");
+        auto y = std::make_shared<Variable>(random_tensor({3}, 0.5, 2.0), "y");
+        auto s = std::make_shared<Variable>(Tensor(1.7), "s");
+        auto c = std::make_shared<Constant>(random_tensor({3}, 1.0, 3.0), "c");
+        NodePtr t1 = std::make_shared<power>(x, c, "x^c"), t2 = std::make_shared<power>(x, y, "x^y");
+        NodePtr t3 = std::make_shared<divide>(std::make_shared<exp_op>(std::make_shared<mul>(x, s, "xs"), "exp"), y, "exp/y");
+        NodePtr t4 = std::make_shared<sub>(std::make_shared<ln_op>(x, "ln"), std::make_shared<sqrt_op>(y, "sqrt"), "ln-sqrt");
+        NodePtr t5 = std::make_shared<log_base>(x, y, "log_y");
+        NodePtr sum = std::make_shared<add>(std::make_shared<add>(t1, t2, "a1"),
+                                            std::make_shared<add>(t3, std::make_shared<add>(t4, t5, "a2"), "a3"), "a4");
+        NodePtr cr = std::make_shared<cross>(sum, y, "cross");
+        NodePtr root = std::make_shared<add>(std::make_shared<dot>(cr, x, "dot"), s, "root");
+        Graph g(root, false);
+        compare("elementwise", g, {x, y, s});
+    }
+    { // MLP with linear, the softmax family and cross entropy
+        auto X = std::make_shared<Constant>(random_tensor({8, 5}), "X");
+        auto W1 = std::make_shared<Variable>(random_tensor({5, 16}), "W1");
+        auto b1 = std::make_shared<Variable>(random_tensor({16}), "b1");
+        auto W2 = std::make_shared<Variable>(random_tensor({16, 4}), "W2");
+        auto T = std::make_shared<Constant>(random_tensor({8, 4}, 0.0, 1.0), "T");
+        NodePtr h = std::make_shared<linear>(X, W1, b1, "h", Activation::GELU);
+        NodePtr z = std::make_shared<matmul>(h, W2, "z");
+        NodePtr ls = std::make_shared<log_softmax_op>(z, "log_softmax", 1);
+        NodePtr sm = std::make_shared<softmax_op>(z, "softmax", 0);
+        NodePtr lse = std::make_shared<logsumexp_op>(z, "logsumexp", -1);
+        NodePtr ce = std::make_shared<softmax_cross_entropy>(z, T, "ce");
+        NodePtr mix = std::make_shared<add>(std::make_shared<mul>(ls, sm, "ls*sm"), lse, "mix");
+        NodePtr proj = std::make_shared<matmul>(std::make_shared<Constant>(random_tensor({1, 8}), "u"),
+                                                std::make_shared<matmul>(mix, std::make_shared<Constant>(random_tensor({4, 1}), "v"), "mix v"),
+                                                "u mix v");
+        Graph g(std::make_shared<add>(ce, proj, "root"));
+        compare("mlp", g, {W1, b1, W2});
+    }
+    { // conv2d and sparse @ dense
+        auto X = std::make_shared<Variable>(random_tensor({2, 3, 6, 6}), "X");
+        auto W = std::make_shared<Variable>(random_tensor({4, 3, 3, 3}), "W");
+        Conv2dParams p;
+        p.padding[0] = p.padding[1] = 1;
+        NodePtr cv = std::make_shared<conv2d>(X, W, "conv", p);
+        NodePtr ce = std::make_shared<softmax_cross_entropy>(std::make_shared<log_softmax_op>(std::make_shared<mul>(cv, cv, "conv^2"), "ls", 1),
+                                                             std::make_shared<Constant>(random_tensor({2, 4, 6, 6}, 0.0, 1.0), "T"), "ce", 1);
+        Tensor Sd = random_tensor({4, 3});
+        Sd.data[1] = Sd.data[5] = 0.0;
+        auto S = std::make_shared<SparseVariable>(CsrTensor::from_dense(Sd), "S");
+        auto D = std::make_shared<Variable>(random_tensor({3, 2}), "D");
+        NodePtr sp = std::make_shared<sparse_matmul>(S, D, "S D");
+        NodePtr proj = std::make_shared<matmul>(std::make_shared<Constant>(random_tensor({1, 4}), "u"),
+                                                std::make_shared<matmul>(std::make_shared<mul>(sp, sp, "(S D)^2"),
+                                                                         std::make_shared<Constant>(random_tensor({2, 1}), "v"), "sq v"),
+                                                "u sq v");
+        Graph g(std::make_shared<add>(proj, ce, "root"), false);
+        compare("conv/sparse", g, {X, W, S, D});
+    }
+    { // the tape owns the operators it refers to: it outlives the Graph and the caller's nodes
+        std::unique_ptr<Tape> t;
+        std::weak_ptr<Node> drop;
+        auto x = std::make_shared<Variable>(Tensor({8}, 1.0), "x");
+        Tensor value;
+        {
+            NodePtr d = std::make_shared<dropout>(x, 0.5, "d", std::make_shared<Generator>(3));
+            Graph g(std::make_shared<mul>(d, d, "d^2"), false);
+            drop = d;
+            t = std::make_unique<Tape>(g);
+            value = g.forward();
+        }
+        check(!drop.expired(), "tape keeps its dropout node alive");
+        t->forward();
+        t->backward();
+        check(t->value("d^2").shape == value.shape, "tape runs after its Graph is gone");
+    }
+    { // operators without a tape instruction are rejected when the tape is built
+        struct custom : UnaryOperator
+        {
+            using UnaryOperator::UnaryOperator;
+            Shape infer_shape() const override { return a->value.shape; }
+            void compute() override { value = a->value; }
+            void vjp() override {}
+        };
+        auto x = std::make_shared<Variable>(Tensor(1.0), "x");
+        Graph g(std::make_shared<custom>(x, "custom"), false);
+        bool threw = false;
+        try
+        {
+            Tape t(g);
+        }
+        catch (const std::runtime_error &)
+        {
+            threw = true;
+        }
+        check(threw, "unsupported operator rejected");
+    }
+    return test_result();
+}